@@ -26,22 +26,26 @@ static const char *opcode_names[] = {
     "GT", "GTI", "GE", "GEI",
     
     /* 控制流 */
-    "JMP", "TEST", "TESTSET", "CALL", "CALLSELF", "TAILCALL", "RETURN",
+    "JMP", "TEST", "TESTSET", "ITERPREP", "ITERNEXT",
+    "CALL", "CALLSELF", "TAILCALL", "RETURN",
     
     /* 表操作 */
-    "NEWTABLE", "GETTABLE", "GETI", "GETFIELD",
+    "NEWTABLE", "NEWMAP", "GETTABLE", "GETI", "GETFIELD",
     "SETTABLE", "SETI", "SETFIELD", "SETLIST",
     
     /* 闭包 */
     "CLOSURE", "GETUPVAL", "SETUPVAL", "CLOSE",
     
     /* OOP */
-    "CLASS", "INHERIT", "GETPROP", "SETPROP",
+    "CLASS", "ADDFIELD", "INHERIT", "GETPROP", "SETPROP",
     "GETSUPER", "INVOKE", "SUPERINVOKE", "METHOD",
     
     /* 全局变量 */
     "GETGLOBAL", "SETGLOBAL", "DEFGLOBAL",
     
+    /* 字符串 */
+    "CONCAT", "SBBEGIN", "SBAPPEND", "SBEND",
+    
     /* 内置函数 */
     "PRINT",
     
@@ -144,6 +148,7 @@ Proto *xr_bc_proto_new(void) {
     proto->maxstacksize = 0;
     proto->numparams = 0;
     proto->is_vararg = false;
+    proto->gc_epoch = 0;
     
     return proto;
 }
@@ -107,17 +107,20 @@ typedef enum {
     OP_GE,          /* if (R[A] >= R[B]) != k then PC++ */
     OP_GEI,         /* if (R[A] >= sB) != k then PC++ */
     
-    /* === 控制流（7个）=== */
+    /* === 控制流（9个）=== */
     OP_JMP,         /* PC += sJ */
     OP_TEST,        /* if (R[A]) != k then PC++ */
     OP_TESTSET,     /* if (R[B]) != k then PC++ else R[A] = R[B] */
+    OP_ITERPREP,    /* 检查R[A]可迭代（数组/Map），R[A+1] = 0 (游标) */
+    OP_ITERNEXT,    /* if next(R[A], R[A+1]) then R[A+2]...R[A+1+B] = key, value; PC++ */
     OP_CALL,        /* R[A]...R[A+C-2] = R[A](R[A+1]...R[A+B-1]) */
     OP_CALLSELF,    /* R[A]...R[A+C-2] = self(R[A+1]...R[A+B-1]) - 递归调用优化 */
     OP_TAILCALL,    /* R[A](R[A+1]...R[A+B-1]) - 尾调用优化 */
     OP_RETURN,      /* return R[A]...R[A+B-2] */
     
-    /* === 表操作（8个）=== */
+    /* === 表操作（9个）=== */
     OP_NEWTABLE,    /* R[A] = {} (创建表/数组) */
+    OP_NEWMAP,      /* R[A] = Map{} (B=预分配元素数, C!=0为WeakMap) */
     OP_GETTABLE,    /* R[A] = R[B][R[C]] */
     OP_GETI,        /* R[A] = R[B][C] (整数索引优化) */
     OP_GETFIELD,    /* R[A] = R[B][K[C]:string] (字段访问优化) */
@@ -148,6 +151,12 @@ typedef enum {
     OP_SETGLOBAL,   /* _G[K[Bx]] = R[A] */
     OP_DEFGLOBAL,   /* 定义全局变量 */
     
+    /* === 字符串（4个）=== */
+    OP_CONCAT,      /* R[A] = R[B] .. ... .. R[B+C-1] (一次分配) */
+    OP_SBBEGIN,     /* R[A] = builder(R[B]) 若R[B]是字符串，否则R[A] = nil */
+    OP_SBAPPEND,    /* if R[A] then append(R[A], R[B]); PC++ (否则执行下一条ADD) */
+    OP_SBEND,       /* if R[A] then R[B] = tostring(R[A]), 释放构建器 */
+    
     /* === 内置函数（1个）=== */
     OP_PRINT,       /* print(R[A]) - 打印寄存器值 */
     
@@ -258,6 +267,9 @@ typedef struct Proto {
     int maxstacksize;       /* 最大栈（寄存器）大小 */
     int numparams;          /* 参数数量 */
     bool is_vararg;         /* 是否是可变参数函数 */
+    
+    /* GC */
+    unsigned int gc_epoch;  /* 最近一次被标记的GC轮次（见xvm_gc.c） */
 } Proto;
 
 /* Proto操作 */
@@ -177,7 +177,7 @@ void xr_print_value(XrValue value) {
             switch (obj->type) {
                 case XR_TSTRING: {
                     XrString *str = (XrString*)obj;
-                    printf("%s", str->chars);  // 不带引号
+                    printf("%.*s", (int)str->length, xr_string_data(str));  // 不带引号
                     break;
                 }
                 case XR_TFUNCTION:
@@ -210,7 +210,7 @@ void xr_print_value(XrValue value) {
             switch (obj->type) {
                 case XR_TSTRING: {
                     XrString *str = (XrString*)obj;
-                    printf("%s", str->chars);  // 去掉引号
+                    printf("%.*s", (int)str->length, xr_string_data(str));  // 去掉引号
                     break;
                 }
                 case XR_TFUNCTION:
@@ -250,9 +250,9 @@ void xr_print_value(XrValue value) {
             printf("[IN_STRING_CASE] ");
             XrString *str = (XrString *)value.as.obj;
             if (str != NULL) {
-                printf("[STR_PTR=%p,CHARS=%s] ", (void*)str, str->chars);
+                printf("[STR_PTR=%p,CHARS=%.*s] ", (void*)str, (int)str->length, xr_string_data(str));
                 /* 移除引号 - print应该直接输出字符串内容 */
-                printf("%s", str->chars);
+                printf("%.*s", (int)str->length, xr_string_data(str));
             } else {
                 printf("[STR_NULL] null");
             }
@@ -395,6 +395,12 @@ int xr_disassemble_instruction(Proto *proto, int offset) {
         case OP_TESTSET:
             return ab_instruction(name, proto, offset);
         
+        case OP_ITERPREP:
+            return byte_instruction(name, proto, offset);
+        
+        case OP_ITERNEXT:
+            return ab_imm_instruction(name, proto, offset);
+        
         case OP_CALL:
         case OP_CALLSELF:
         case OP_TAILCALL:
@@ -403,6 +409,7 @@ int xr_disassemble_instruction(Proto *proto, int offset) {
         
         /* 表操作 */
         case OP_NEWTABLE:
+        case OP_NEWMAP:
             return byte_instruction(name, proto, offset);
         
         case OP_GETTABLE:
@@ -448,6 +455,15 @@ int xr_disassemble_instruction(Proto *proto, int offset) {
         case OP_DEFGLOBAL:
             return constant_instruction(name, proto, offset);
         
+        /* 字符串 */
+        case OP_CONCAT:
+            return abc_instruction(name, proto, offset);
+        
+        case OP_SBBEGIN:
+        case OP_SBAPPEND:
+        case OP_SBEND:
+            return ab_instruction(name, proto, offset);
+        
         /* 内置函数 */
         case OP_PRINT:
             return byte_instruction(name, proto, offset);
@@ -11,6 +11,7 @@
 #include "xinline.h"
 #include "xmem.h"
 #include "xstring.h"
+#include "xslab.h"
 #include "xsymbol.h"  /* v0.20.0: Symbol系统支持 */
 #include <stdio.h>
 #include <stdarg.h>
@@ -28,6 +29,7 @@
 /* ========== 前向声明 ========== */
 
 static int get_or_add_global(CompilerContext *ctx, Compiler *compiler, XrString *name);
+static bool global_defined(CompilerContext *ctx, const char *name);
 
 static int compile_literal(CompilerContext *ctx, Compiler *compiler, LiteralNode *node);
 static int compile_binary(CompilerContext *ctx, Compiler *compiler, BinaryNode *node, AstNodeType type);
@@ -39,12 +41,17 @@ static void compile_print(CompilerContext *ctx, Compiler *compiler, PrintNode *n
 static void compile_if(CompilerContext *ctx, Compiler *compiler, IfStmtNode *node);
 static void compile_while(CompilerContext *ctx, Compiler *compiler, WhileStmtNode *node);
 static void compile_for(CompilerContext *ctx, Compiler *compiler, ForStmtNode *node);
+static void compile_for_in(CompilerContext *ctx, Compiler *compiler, ForInStmtNode *node);
 static int compile_call(CompilerContext *ctx, Compiler *compiler, CallExprNode *node);
 static void compile_function(CompilerContext *ctx, Compiler *compiler, FunctionDeclNode *node);
 static void compile_return(CompilerContext *ctx, Compiler *compiler, ReturnStmtNode *node);
 static int compile_array_literal(CompilerContext *ctx, Compiler *compiler, ArrayLiteralNode *node);
 static int compile_index_get(CompilerContext *ctx, Compiler *compiler, IndexGetNode *node);
 static void compile_index_set(CompilerContext *ctx, Compiler *compiler, IndexSetNode *node);
+static int compile_map_literal(CompilerContext *ctx, Compiler *compiler, MapLiteralNode *node);
+static int compile_template_string(CompilerContext *ctx, Compiler *compiler, TemplateStringNode *node);
+static bool is_self_concat(AssignmentNode *node);
+static void compile_concat_append(CompilerContext *ctx, Compiler *compiler, Local *target, AstNode *value);
 
 /* OOP相关编译函数（v0.19.0新增）*/
 static void compile_class(CompilerContext *ctx, Compiler *compiler, ClassDeclNode *node);
@@ -245,6 +252,7 @@ void xr_define_local(CompilerContext *ctx, Compiler *compiler, XrString *name) {
     local->reg = reg;
     local->depth = compiler->scope_depth;
     local->is_captured = false;
+    local->builder = -1;
     
     /* 保留寄存器 */
     xr_reservereg(compiler);
@@ -266,6 +274,7 @@ static void define_local_with_reg(CompilerContext *ctx, Compiler *compiler, XrSt
     local->reg = reg;
     local->depth = compiler->scope_depth;
     local->is_captured = false;
+    local->builder = -1;
     
     /* 保留寄存器 */
     xr_reservereg(compiler);
@@ -287,6 +296,19 @@ int xr_resolve_local(Compiler *compiler, XrString *name) {
     return -1;  /* 未找到 */
 }
 
+/*
+** 查找局部变量描述（从内向外），未找到返回NULL
+*/
+static Local *find_local(Compiler *compiler, const char *name) {
+    for (int i = compiler->local_count - 1; i >= 0; i--) {
+        Local *local = &compiler->locals[i];
+        if (local->name != NULL && strcmp(local->name->chars, name) == 0) {
+            return local;
+        }
+    }
+    return NULL;
+}
+
 /*
 ** 添加upvalue到编译器
 */
@@ -851,6 +873,14 @@ int xr_compile_expression(CompilerContext *ctx, Compiler *compiler, AstNode *nod
         case AST_INDEX_GET:
             return compile_index_get(ctx, compiler, &node->as.index_get);
         
+        /* Map操作 */
+        case AST_MAP_LITERAL:
+            return compile_map_literal(ctx, compiler, &node->as.map_literal);
+        
+        /* 模板字符串 */
+        case AST_TEMPLATE_STRING:
+            return compile_template_string(ctx, compiler, &node->as.template_str);
+        
         /* v0.19.0：OOP表达式 */
         case AST_NEW_EXPR:
             return compile_new_expr(ctx, compiler, &node->as.new_expr);
@@ -949,6 +979,13 @@ static void compile_print(CompilerContext *ctx, Compiler *compiler, PrintNode *n
 ** 编译赋值语句
 */
 static void compile_assignment(CompilerContext *ctx, Compiler *compiler, AssignmentNode *node) {
+    /* 已降级为构建器的 s = s + e（见compile_loop_concat） */
+    Local *target = find_local(compiler, node->name);
+    if (target != NULL && target->builder >= 0 && is_self_concat(node)) {
+        compile_concat_append(ctx, compiler, target, node->value->as.binary.right);
+        return;
+    }
+    
     /* 创建字符串 */
     XrString *name_str = xr_string_new(node->name, strlen(node->name));
     
@@ -1059,10 +1096,314 @@ static void compile_if(CompilerContext *ctx, Compiler *compiler, IfStmtNode *nod
     }
 }
 
+/* ========== 循环内字符串拼接降级 ========== */
+
+/*
+** 循环里的 s = s + e 每次都分配并驻留一个新字符串，整体是O(n²)。
+** s是当前函数的局部变量时，把它降级为VM的字符串构建器：
+**
+**   SBBEGIN sb s       ; s是字符串时开启构建器，否则sb = nil
+** loop:
+**   ...
+**   SBAPPEND sb e      ; 构建器已开启：追加并跳过下一条
+**   ADD s s e          ; 否则按普通加法执行
+**   ...
+** exit:
+**   SBEND sb s         ; s = 构建结果
+**
+** 循环期间s的寄存器不再更新，因此要求整个循环（条件、更新、循环体）
+** 中除这种拼接外没有任何对s的读写。含函数、类或return的循环不降级：
+** 闭包可能读到s，return会跳过SBEND。
+*/
+
+#define LOOP_CONCAT_MAX 4   /* 每个循环最多降级的变量数 */
+
+/* 一个已降级的变量 */
+typedef struct {
+    Local *local;           /* 被拼接的局部变量 */
+    int builder;            /* 构建器寄存器 */
+} LoopConcat;
+
+/*
+** 是否为 name = name + e
+*/
+static bool is_self_concat(AssignmentNode *node) {
+    AstNode *value = node->value;
+    if (value == NULL || value->type != AST_BINARY_ADD) return false;
+    
+    AstNode *left = value->as.binary.left;
+    return left->type == AST_VARIABLE &&
+           strcmp(left->as.variable.name, node->name) == 0;
+}
+
+/*
+** 子树中是否有妨碍降级的对name的使用
+** 自拼接本身不算（只检查其右侧表达式）；不认识的节点一律视为使用
+*/
+static bool concat_blocked(AstNode *node, const char *name) {
+    if (node == NULL) return false;
+    
+    switch (node->type) {
+        case AST_LITERAL_INT:
+        case AST_LITERAL_FLOAT:
+        case AST_LITERAL_STRING:
+        case AST_LITERAL_NULL:
+        case AST_LITERAL_TRUE:
+        case AST_LITERAL_FALSE:
+        case AST_THIS_EXPR:
+        case AST_BREAK_STMT:
+        case AST_CONTINUE_STMT:
+            return false;
+        
+        case AST_VARIABLE:
+            return strcmp(node->as.variable.name, name) == 0;
+        
+        case AST_ASSIGNMENT: {
+            AssignmentNode *assign = &node->as.assignment;
+            if (strcmp(assign->name, name) != 0) {
+                return concat_blocked(assign->value, name);
+            }
+            if (!is_self_concat(assign)) return true;
+            return concat_blocked(assign->value->as.binary.right, name);
+        }
+        
+        case AST_VAR_DECL:
+        case AST_CONST_DECL:
+            return strcmp(node->as.var_decl.name, name) == 0 ||
+                   concat_blocked(node->as.var_decl.initializer, name);
+        
+        case AST_BINARY_ADD:
+        case AST_BINARY_SUB:
+        case AST_BINARY_MUL:
+        case AST_BINARY_DIV:
+        case AST_BINARY_MOD:
+        case AST_BINARY_EQ:
+        case AST_BINARY_NE:
+        case AST_BINARY_LT:
+        case AST_BINARY_LE:
+        case AST_BINARY_GT:
+        case AST_BINARY_GE:
+        case AST_BINARY_AND:
+        case AST_BINARY_OR:
+            return concat_blocked(node->as.binary.left, name) ||
+                   concat_blocked(node->as.binary.right, name);
+        
+        case AST_UNARY_NEG:
+        case AST_UNARY_NOT:
+            return concat_blocked(node->as.unary.operand, name);
+        
+        case AST_GROUPING:
+            return concat_blocked(node->as.grouping, name);
+        
+        case AST_EXPR_STMT:
+            return concat_blocked(node->as.expr_stmt, name);
+        
+        case AST_PRINT_STMT:
+            return concat_blocked(node->as.print_stmt.expr, name);
+        
+        case AST_BLOCK:
+            for (int i = 0; i < node->as.block.count; i++) {
+                if (concat_blocked(node->as.block.statements[i], name)) return true;
+            }
+            return false;
+        
+        case AST_IF_STMT:
+            return concat_blocked(node->as.if_stmt.condition, name) ||
+                   concat_blocked(node->as.if_stmt.then_branch, name) ||
+                   concat_blocked(node->as.if_stmt.else_branch, name);
+        
+        case AST_WHILE_STMT:
+            return concat_blocked(node->as.while_stmt.condition, name) ||
+                   concat_blocked(node->as.while_stmt.body, name);
+        
+        case AST_FOR_STMT:
+            return concat_blocked(node->as.for_stmt.initializer, name) ||
+                   concat_blocked(node->as.for_stmt.condition, name) ||
+                   concat_blocked(node->as.for_stmt.increment, name) ||
+                   concat_blocked(node->as.for_stmt.body, name);
+        
+        case AST_FOR_IN_STMT: {
+            ForInStmtNode *for_in = &node->as.for_in_stmt;
+            if (strcmp(for_in->key_name, name) == 0) return true;
+            if (for_in->value_name != NULL && strcmp(for_in->value_name, name) == 0) return true;
+            return concat_blocked(for_in->iterable, name) ||
+                   concat_blocked(for_in->body, name);
+        }
+        
+        case AST_CALL_EXPR:
+            if (concat_blocked(node->as.call_expr.callee, name)) return true;
+            for (int i = 0; i < node->as.call_expr.arg_count; i++) {
+                if (concat_blocked(node->as.call_expr.arguments[i], name)) return true;
+            }
+            return false;
+        
+        case AST_ARRAY_LITERAL:
+            for (int i = 0; i < node->as.array_literal.count; i++) {
+                if (concat_blocked(node->as.array_literal.elements[i], name)) return true;
+            }
+            return false;
+        
+        case AST_MAP_LITERAL:
+            for (int i = 0; i < node->as.map_literal.count; i++) {
+                if (concat_blocked(node->as.map_literal.keys[i], name) ||
+                    concat_blocked(node->as.map_literal.values[i], name)) return true;
+            }
+            return false;
+        
+        case AST_TEMPLATE_STRING:
+            for (int i = 0; i < node->as.template_str.part_count; i++) {
+                if (concat_blocked(node->as.template_str.parts[i], name)) return true;
+            }
+            return false;
+        
+        case AST_INDEX_GET:
+            return concat_blocked(node->as.index_get.array, name) ||
+                   concat_blocked(node->as.index_get.index, name);
+        
+        case AST_INDEX_SET:
+            return concat_blocked(node->as.index_set.array, name) ||
+                   concat_blocked(node->as.index_set.index, name) ||
+                   concat_blocked(node->as.index_set.value, name);
+        
+        case AST_MEMBER_ACCESS:
+            return concat_blocked(node->as.member_access.object, name);
+        
+        case AST_MEMBER_SET:
+            return concat_blocked(node->as.member_set.object, name) ||
+                   concat_blocked(node->as.member_set.value, name);
+        
+        case AST_NEW_EXPR:
+            for (int i = 0; i < node->as.new_expr.arg_count; i++) {
+                if (concat_blocked(node->as.new_expr.arguments[i], name)) return true;
+            }
+            return false;
+        
+        default:
+            /* 函数、类、return等：保守处理 */
+            return true;
+    }
+}
+
+/*
+** 收集循环体中自拼接语句的目标变量名（去重）
+*/
+static void collect_concat_targets(AstNode *node, const char **names, int *count) {
+    if (node == NULL || *count >= LOOP_CONCAT_MAX) return;
+    
+    switch (node->type) {
+        case AST_EXPR_STMT: {
+            AstNode *expr = node->as.expr_stmt;
+            if (expr->type != AST_ASSIGNMENT || !is_self_concat(&expr->as.assignment)) return;
+            
+            const char *name = expr->as.assignment.name;
+            for (int i = 0; i < *count; i++) {
+                if (strcmp(names[i], name) == 0) return;
+            }
+            names[(*count)++] = name;
+            return;
+        }
+        
+        case AST_BLOCK:
+            for (int i = 0; i < node->as.block.count; i++) {
+                collect_concat_targets(node->as.block.statements[i], names, count);
+            }
+            return;
+        
+        case AST_IF_STMT:
+            collect_concat_targets(node->as.if_stmt.then_branch, names, count);
+            collect_concat_targets(node->as.if_stmt.else_branch, names, count);
+            return;
+        
+        case AST_WHILE_STMT:
+            collect_concat_targets(node->as.while_stmt.body, names, count);
+            return;
+        
+        case AST_FOR_STMT:
+            collect_concat_targets(node->as.for_stmt.body, names, count);
+            return;
+        
+        case AST_FOR_IN_STMT:
+            collect_concat_targets(node->as.for_in_stmt.body, names, count);
+            return;
+        
+        default:
+            return;
+    }
+}
+
+/*
+** 为循环开启拼接降级，在循环入口之前调用
+** @param parts 循环每轮都会执行的子树（条件、更新、循环体），可含NULL
+** @param first_loop_local 循环自身变量在locals中的起始下标，只降级它之前的变量
+** @param out 输出已降级的变量
+** @return 降级的变量数
+*/
+static int compile_loop_concat(CompilerContext *ctx, Compiler *compiler,
+                               AstNode **parts, int nparts, AstNode *body,
+                               int first_loop_local, LoopConcat *out) {
+    const char *names[LOOP_CONCAT_MAX];
+    int nnames = 0;
+    collect_concat_targets(body, names, &nnames);
+    
+    int count = 0;
+    for (int i = 0; i < nnames; i++) {
+        Local *local = find_local(compiler, names[i]);
+        if (local == NULL || local->is_captured || local->builder >= 0 ||
+            local - compiler->locals >= first_loop_local) {
+            continue;
+        }
+        
+        bool blocked = false;
+        for (int j = 0; j < nparts && !blocked; j++) {
+            blocked = concat_blocked(parts[j], names[i]);
+        }
+        if (blocked) continue;
+        
+        /* 隐藏变量保存构建器句柄 */
+        xr_define_local(ctx, compiler, xr_string_new("(for concat)", 12));
+        int builder = compiler->locals[compiler->local_count - 1].reg;
+        xr_emit_ABC(ctx, compiler, OP_SBBEGIN, builder, local->reg, 0);
+        
+        local->builder = builder;
+        out[count].local = local;
+        out[count].builder = builder;
+        count++;
+    }
+    return count;
+}
+
+/*
+** 循环出口：写回构建结果（后开先关，与VM的构建器栈一致）
+*/
+static void end_loop_concat(CompilerContext *ctx, Compiler *compiler, LoopConcat *items, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        xr_emit_ABC(ctx, compiler, OP_SBEND, items[i].builder, items[i].local->reg, 0);
+        items[i].local->builder = -1;
+    }
+}
+
+/*
+** 编译降级后的 s = s + e：追加到构建器，后跟未开启时的ADD
+*/
+static void compile_concat_append(CompilerContext *ctx, Compiler *compiler, Local *target, AstNode *value) {
+    int value_reg = xr_compile_expression(ctx, compiler, value);
+    xr_emit_ABC(ctx, compiler, OP_SBAPPEND, target->builder, value_reg, 0);
+    xr_emit_ABC(ctx, compiler, OP_ADD, target->reg, target->reg, value_reg);
+    xr_freereg(compiler, value_reg);
+}
+
 /*
 ** 编译while循环
 */
 static void compile_while(CompilerContext *ctx, Compiler *compiler, WhileStmtNode *node) {
+    xr_begin_scope(compiler);
+    
+    /* 循环内字符串拼接降级 */
+    AstNode *parts[] = { node->condition, node->body };
+    LoopConcat concat[LOOP_CONCAT_MAX];
+    int nconcat = compile_loop_concat(ctx, compiler, parts, 2, node->body,
+                                      compiler->local_count, concat);
+    
     int loop_start = compiler->proto->sizecode;
     
     /* 编译条件 */
@@ -1084,6 +1425,9 @@ static void compile_while(CompilerContext *ctx, Compiler *compiler, WhileStmtNod
     
     /* 回填退出跳转 */
     xr_patch_jump(ctx, compiler, exit_jump);
+    
+    end_loop_concat(ctx, compiler, concat, nconcat);
+    xr_end_scope(ctx, compiler);
 }
 
 /*
@@ -1098,6 +1442,12 @@ static void compile_for(CompilerContext *ctx, Compiler *compiler, ForStmtNode *n
         xr_compile_statement(ctx, compiler, node->initializer);
     }
     
+    /* 循环内字符串拼接降级 */
+    AstNode *parts[] = { node->condition, node->increment, node->body };
+    LoopConcat concat[LOOP_CONCAT_MAX];
+    int nconcat = compile_loop_concat(ctx, compiler, parts, 3, node->body,
+                                      compiler->local_count, concat);
+    
     int loop_start = compiler->proto->sizecode;
     
     /* 编译条件 */
@@ -1137,10 +1487,73 @@ static void compile_for(CompilerContext *ctx, Compiler *compiler, ForStmtNode *n
         xr_patch_jump(ctx, compiler, exit_jump);
     }
     
+    end_loop_concat(ctx, compiler, concat, nconcat);
+    
     /* 退出循环作用域 */
     xr_end_scope(ctx, compiler);
 }
 
+/*
+** 编译for-in循环
+** 寄存器布局（Lua风格的隐藏局部变量）：
+**   R[base]   被迭代对象    R[base+1] 游标
+**   R[base+2] 第一个变量    R[base+3] 第二个变量（可选）
+**
+**   ITERPREP base
+** loop:
+**   ITERNEXT base n    ; 有下一个元素则跳过退出跳转
+**   JMP exit
+**   body
+**   JMP loop
+** exit:
+*/
+static void compile_for_in(CompilerContext *ctx, Compiler *compiler, ForInStmtNode *node) {
+    xr_begin_scope(compiler);
+    int first_loop_local = compiler->local_count;
+    
+    /* 隐藏变量：名字不是合法标识符，不会被用户代码解析到 */
+    xr_define_local(ctx, compiler, xr_string_new("(for iter)", 10));
+    int base = compiler->locals[compiler->local_count - 1].reg;
+    int expr_reg = xr_compile_expression(ctx, compiler, node->iterable);
+    if (expr_reg != base) {
+        xr_emit_ABC(ctx, compiler, OP_MOVE, base, expr_reg, 0);
+        xr_freereg(compiler, expr_reg);
+    }
+    xr_define_local(ctx, compiler, xr_string_new("(for cursor)", 12));
+    
+    /* 循环变量 */
+    int nvars = 1;
+    xr_define_local(ctx, compiler, xr_string_new(node->key_name, strlen(node->key_name)));
+    if (node->value_name != NULL) {
+        xr_define_local(ctx, compiler, xr_string_new(node->value_name, strlen(node->value_name)));
+        nvars = 2;
+    }
+    
+    xr_emit_ABC(ctx, compiler, OP_ITERPREP, base, 0, 0);
+    
+    /* 循环内字符串拼接降级 */
+    LoopConcat concat[LOOP_CONCAT_MAX];
+    int nconcat = compile_loop_concat(ctx, compiler, &node->body, 1, node->body,
+                                      first_loop_local, concat);
+    
+    int loop_start = compiler->proto->sizecode;
+    xr_emit_ABC(ctx, compiler, OP_ITERNEXT, base, nvars, 0);
+    int exit_jump = xr_emit_jump(ctx, compiler, OP_JMP);
+    
+    /* 编译循环体 */
+    compiler->loop_depth++;
+    compiler->loop_start = loop_start;
+    xr_compile_statement(ctx, compiler, node->body);
+    compiler->loop_depth--;
+    
+    /* 跳回取下一个元素 */
+    xr_emit_loop(ctx, compiler, loop_start);
+    xr_patch_jump(ctx, compiler, exit_jump);
+    
+    end_loop_concat(ctx, compiler, concat, nconcat);
+    xr_end_scope(ctx, compiler);
+}
+
 /*
 ** 编译函数定义
 */
@@ -1375,6 +1788,102 @@ static int compile_array_literal(CompilerContext *ctx, Compiler *compiler, Array
     return array_reg;
 }
 
+/*
+** 常量字符串键：返回常量索引（不是字符串字面量或超出操作数范围返回-1）
+** 操作数范围内已有同样的字符串就复用；放不下新常量时不添加，
+** 由调用者退回SETTABLE/GETTABLE，避免常量池里留下用不到的重复项
+*/
+static int string_key_constant(Compiler *compiler, AstNode *key, int maxarg) {
+    if (key->type != AST_LITERAL_STRING) {
+        return -1;
+    }
+    
+    XrValue value = ((LiteralNode *)&key->as)->value;
+    ValueArray *constants = &compiler->proto->constants;
+    int limit = constants->count <= maxarg ? constants->count : maxarg + 1;
+    for (int i = 0; i < limit; i++) {
+        if (xr_isstring(constants->values[i]) &&
+            xr_string_equal(xr_tostring(constants->values[i]), xr_tostring(value))) {
+            return i;
+        }
+    }
+    
+    if (constants->count > maxarg) {
+        return -1;
+    }
+    return xr_bc_proto_add_constant(compiler->proto, value);
+}
+
+/*
+** 编译Map字面量
+** 按键值对数量预分配，常量字符串键使用SETFIELD
+*/
+static int compile_map_literal(CompilerContext *ctx, Compiler *compiler, MapLiteralNode *node) {
+    /* 分配目标寄存器 */
+    int map_reg = xr_allocreg(ctx, compiler);
+    
+    /* NEWMAP A B: R[A] = Map{}，预分配B个元素（超出B的部分按需扩容） */
+    int size_hint = node->count > MAXARG_B ? MAXARG_B : node->count;
+    xr_emit_ABC(ctx, compiler, OP_NEWMAP, map_reg, size_hint, 0);
+    
+    for (int i = 0; i < node->count; i++) {
+        int kidx = string_key_constant(compiler, node->keys[i], MAXARG_B);
+        
+        if (kidx >= 0) {
+            /* SETFIELD A B C: R[A][K[B]] = R[C] */
+            int value_reg = xr_compile_expression(ctx, compiler, node->values[i]);
+            xr_emit_ABC(ctx, compiler, OP_SETFIELD, map_reg, kidx, value_reg);
+            xr_freereg(compiler, value_reg);
+        } else {
+            int key_reg = xr_compile_expression(ctx, compiler, node->keys[i]);
+            int value_reg = xr_compile_expression(ctx, compiler, node->values[i]);
+            xr_emit_ABC(ctx, compiler, OP_SETTABLE, map_reg, key_reg, value_reg);
+            xr_freereg(compiler, value_reg);
+            xr_freereg(compiler, key_reg);
+        }
+    }
+    
+    return map_reg;
+}
+
+/*
+** 编译模板字符串
+** 各片段编译到连续寄存器，一条CONCAT生成结果（总长只算一次，一次分配）：
+**   R[base] .. R[base+n-1] = parts
+**   CONCAT base base n
+*/
+static int compile_template_string(CompilerContext *ctx, Compiler *compiler, TemplateStringNode *node) {
+    if (node->part_count == 0) {
+        int dst = xr_allocreg(ctx, compiler);
+        int kidx = xr_bc_proto_add_constant(compiler->proto, XR_OBJ_TO_VAL(xr_string_new("", 0)));
+        xr_emit_ABx(ctx, compiler, OP_LOADK, dst, kidx);
+        return dst;
+    }
+    
+    int base = compiler->rs.freereg;
+    for (int i = 0; i < node->part_count; i++) {
+        int part_reg = xr_compile_expression(ctx, compiler, node->parts[i]);
+        
+        /* 确保片段在连续寄存器中（局部变量不占新寄存器，需要复制） */
+        int target_reg = base + i;
+        if (part_reg != target_reg) {
+            if (compiler->rs.freereg <= target_reg) {
+                xr_allocreg(ctx, compiler);
+            }
+            xr_emit_ABC(ctx, compiler, OP_MOVE, target_reg, part_reg, 0);
+        }
+        
+        /* 片段求值留下的临时寄存器已无用（值已在target_reg），只保留base..target_reg */
+        compiler->rs.freereg = target_reg + 1;
+    }
+    
+    xr_emit_ABC(ctx, compiler, OP_CONCAT, base, base, node->part_count);
+    
+    /* 只保留结果寄存器 */
+    compiler->rs.freereg = base + 1;
+    return base;
+}
+
 /*
 ** 编译索引访问
 */
@@ -1382,6 +1891,15 @@ static int compile_index_get(CompilerContext *ctx, Compiler *compiler, IndexGetN
     /* 编译数组表达式 */
     int array_reg = xr_compile_expression(ctx, compiler, node->array);
     
+    /* 常量字符串键：GETFIELD（使用预计算哈希） */
+    int kidx = string_key_constant(compiler, node->index, MAXARG_C);
+    if (kidx >= 0) {
+        int result_reg = xr_allocreg(ctx, compiler);
+        xr_emit_ABC(ctx, compiler, OP_GETFIELD, result_reg, array_reg, kidx);
+        xr_freereg(compiler, array_reg);
+        return result_reg;
+    }
+    
     /* 编译索引表达式 */
     int index_reg = xr_compile_expression(ctx, compiler, node->index);
     
@@ -1405,6 +1923,16 @@ static void compile_index_set(CompilerContext *ctx, Compiler *compiler, IndexSet
     /* 编译数组表达式 */
     int array_reg = xr_compile_expression(ctx, compiler, node->array);
     
+    /* 常量字符串键：SETFIELD（使用预计算哈希） */
+    int kidx = string_key_constant(compiler, node->index, MAXARG_B);
+    if (kidx >= 0) {
+        int value_reg = xr_compile_expression(ctx, compiler, node->value);
+        xr_emit_ABC(ctx, compiler, OP_SETFIELD, array_reg, kidx, value_reg);
+        xr_freereg(compiler, value_reg);
+        xr_freereg(compiler, array_reg);
+        return;
+    }
+    
     /* 编译索引表达式 */
     int index_reg = xr_compile_expression(ctx, compiler, node->index);
     
@@ -1461,6 +1989,10 @@ void xr_compile_statement(CompilerContext *ctx, Compiler *compiler, AstNode *nod
             compile_for(ctx, compiler, &node->as.for_stmt);
             break;
         
+        case AST_FOR_IN_STMT:
+            compile_for_in(ctx, compiler, &node->as.for_in_stmt);
+            break;
+        
         case AST_FUNCTION_DECL:
             compile_function(ctx, compiler, &node->as.function_decl);
             break;
@@ -1513,6 +2045,19 @@ void xr_compile_statement(CompilerContext *ctx, Compiler *compiler, AstNode *nod
 /*
 ** 获取或添加全局变量索引
 */
+/*
+** 是否已有该名字的全局变量
+*/
+static bool global_defined(CompilerContext *ctx, const char *name) {
+    for (int i = 0; i < ctx->global_var_count; i++) {
+        if (ctx->global_vars[i].name != NULL &&
+            strcmp(ctx->global_vars[i].name->chars, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static int get_or_add_global(CompilerContext *ctx, Compiler *compiler, XrString *name) {
     /* 查找是否已存在 */
     for (int i = 0; i < ctx->global_var_count; i++) {
@@ -1537,8 +2082,20 @@ static int get_or_add_global(CompilerContext *ctx, Compiler *compiler, XrString
 
 /*
 ** 编译AST到函数原型
+** xr_parse得到的树持有arena，编译期间的临时内存也从它分配
 */
 Proto *xr_compile(CompilerContext *ctx, AstNode *ast) {
+    XrArena *saved_arena = xr_arena_current();
+    if (ast->type == AST_PROGRAM && ast->as.program.arena != NULL) {
+        xr_arena_use(ast->as.program.arena);
+    }
+    
+    /* 常量字符串进默认池，不随某个VM的GC回收（见xr_parse） */
+    StringPool *saved_pool = xr_string_pool_current();
+    XrSlab *saved_slab = xr_slab_current();
+    xr_string_pool_use(NULL);
+    xr_slab_use(NULL);
+    
     /* 重置全局变量计数（每次编译重新开始） */
     ctx->global_var_count = 0;
     for (int i = 0; i < MAX_GLOBALS; i++) {
@@ -1560,7 +2117,11 @@ Proto *xr_compile(CompilerContext *ctx, AstNode *ast) {
     compiler.proto->num_globals = ctx->global_var_count;
     
     /* 结束编译 */
-    return xr_compiler_end(ctx, &compiler);
+    Proto *proto = xr_compiler_end(ctx, &compiler);
+    xr_arena_use(saved_arena);
+    xr_string_pool_use(saved_pool);
+    xr_slab_use(saved_slab);
+    return proto;
 }
 
 /* ========== OOP编译支持（v0.19.0新增）========== */
@@ -1690,6 +2251,14 @@ static void compile_class(CompilerContext *ctx, Compiler *compiler, ClassDeclNod
 ** new Number(10)
 */
 static int compile_new_expr(CompilerContext *ctx, Compiler *compiler, NewExprNode *node) {
+    /* new WeakMap()：没有同名的全局类时直接创建WeakMap */
+    if (node->arg_count == 0 && strcmp(node->class_name, "WeakMap") == 0 &&
+        !global_defined(ctx, node->class_name)) {
+        int map_reg = xr_allocreg(ctx, compiler);
+        xr_emit_ABC(ctx, compiler, OP_NEWMAP, map_reg, 0, 1);
+        return map_reg;
+    }
+    
     /* 加载类对象 */
     XrString *class_name = xr_string_new(node->class_name, strlen(node->class_name));
     int global_index = get_or_add_global(ctx, compiler, class_name);
@@ -38,6 +38,7 @@ typedef struct {
     int reg;            /* 寄存器编号 */
     int depth;          /* 作用域深度 */
     bool is_captured;   /* 是否被闭包捕获 */
+    int builder;        /* 循环拼接降级的构建器寄存器（-1表示未降级） */
 } Local;
 
 /* ========== Upvalue描述 ========== */
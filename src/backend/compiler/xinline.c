@@ -82,7 +82,8 @@ int xr_inline_complexity(Proto *proto) {
     /* 分支和跳转增加复杂度 */
     for (int pc = 0; pc < proto->sizecode; pc++) {
         OpCode op = GET_OPCODE(proto->code[pc]);
-        if (op == OP_JMP || op == OP_TEST || op == OP_TESTSET) {
+        if (op == OP_JMP || op == OP_TEST || op == OP_TESTSET || op == OP_ITERNEXT ||
+            op == OP_SBAPPEND) {
             complexity += 2;
         }
     }
@@ -5,6 +5,7 @@
 */
 
 #include "xpeephole.h"
+#include "xarena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -165,11 +166,9 @@ int xr_peep_dead_code(Proto *proto) {
         return 0;
     }
     
-    /* 创建可达性标记数组 */
-    bool *reachable = (bool*)calloc(proto->sizecode, sizeof(bool));
-    if (!reachable) {
-        return 0;
-    }
+    /* 创建可达性标记数组（编译会话的临时内存） */
+    bool *reachable = (bool*)xr_arena_scratch_alloc(proto->sizecode * sizeof(bool));
+    memset(reachable, 0, proto->sizecode * sizeof(bool));
     
     /* 第一轮：标记所有可达指令 */
     /* 起点：第一条指令总是可达的 */
@@ -216,6 +215,8 @@ int xr_peep_dead_code(Proto *proto) {
             case OP_GEI:
             case OP_TEST:
             case OP_TESTSET:
+            case OP_ITERNEXT:
+            case OP_SBAPPEND:
                 /* 条件跳转会跳过下一条指令，标记pc+2 */
                 if (pc + 2 < proto->sizecode) {
                     reachable[pc + 2] = true;
@@ -250,7 +251,7 @@ int xr_peep_dead_code(Proto *proto) {
         }
     }
     
-    free(reachable);
+    xr_arena_scratch_free(reachable);
     return opt_count;
 }
 
@@ -303,10 +304,7 @@ int xr_peep_compress_nop(Proto *proto) {
     }
     
     /* 创建PC映射表：old_pc -> new_pc */
-    int *pc_map = (int*)malloc(proto->sizecode * sizeof(int));
-    if (!pc_map) {
-        return 0;
-    }
+    int *pc_map = (int*)xr_arena_scratch_alloc(proto->sizecode * sizeof(int));
     
     /* 创建新的指令和行号数组 */
     int new_size = proto->sizecode - nop_count;
@@ -314,7 +312,7 @@ int xr_peep_compress_nop(Proto *proto) {
     int *new_lineinfo = proto->lineinfo ? (int*)malloc(new_size * sizeof(int)) : NULL;
     
     if (!new_code || (proto->lineinfo && !new_lineinfo)) {
-        free(pc_map);
+        xr_arena_scratch_free(pc_map);
         free(new_code);
         free(new_lineinfo);
         return 0;
@@ -386,7 +384,7 @@ int xr_peep_compress_nop(Proto *proto) {
         proto->capacity_lineinfo = new_size;
     }
     
-    free(pc_map);
+    xr_arena_scratch_free(pc_map);
     
     g_peephole_stats.nop_compressed += nop_count;
     return nop_count;
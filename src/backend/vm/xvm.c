@@ -6,10 +6,13 @@
 */
 
 #include "xvm.h"
+#include "xvm_gc.h"
 #include "xdebug.h"
 #include "xmem.h"
 #include "xstring.h"
 #include "xarray.h"
+#include "xmap.h"
+#include "xstrbuf.h"
 #include "xclass.h"      /* v0.19.0：类对象 */
 #include "xinstance.h"   /* v0.19.0：实例对象 */
 #include "xmethod.h"     /* v0.19.0：方法对象 */
@@ -69,12 +72,39 @@
 #define KB(inst) (K(GETARG_B(inst)))
 #define KC(inst) (K(GETARG_C(inst)))
 
+/*
+** GC安全点：分配对象的指令把结果写入寄存器之后检查
+** 此时所有存活值都能从根找到（见xvm_gc.h）
+*/
+#define GC_CHECK() \
+    do { \
+        if (unlikely(xr_bc_gc_needed(vm))) { \
+            xr_bc_gc_step(vm); \
+        } \
+    } while (0)
+
+/*
+** 循环回跳：增量标记期间每GC_BACKEDGE_INTERVAL次做一步，
+** 不分配对象的长循环也能推进标记
+*/
+#define GC_BACKEDGE() \
+    do { \
+        if (unlikely(vm->gc_phase == GC_MARK) && \
+            ++vm->gc_backedges >= GC_BACKEDGE_INTERVAL) { \
+            vm->gc_backedges = 0; \
+            xr_bc_gc_step(vm); \
+        } \
+    } while (0)
+
 /* ========== 运行时错误处理 ========== */
 
 /*
 ** 报告运行时错误
 */
 void xr_bc_runtime_error(VM *vm, const char *format, ...) {
+    /* 先写出已缓冲的print输出，保持与错误信息的先后顺序 */
+    xr_bc_vm_flush_output(vm);
+    
     va_list args;
     va_start(args, format);
     vfprintf(stderr, format, args);
@@ -115,7 +145,7 @@ void xr_bc_runtime_error(VM *vm, const char *format, ...) {
 ** 创建upvalue对象
 */
 XrUpvalue *xr_bc_upvalue_new(XrValue *location) {
-    XrUpvalue *upvalue = (XrUpvalue *)xr_malloc(sizeof(XrUpvalue));
+    XrUpvalue *upvalue = (XrUpvalue *)xr_slab_alloc(sizeof(XrUpvalue));
     if (upvalue == NULL) {
         return NULL;
     }
@@ -133,7 +163,7 @@ XrUpvalue *xr_bc_upvalue_new(XrValue *location) {
 */
 void xr_bc_upvalue_free(XrUpvalue *upvalue) {
     if (upvalue != NULL) {
-        xr_free(upvalue);
+        xr_slab_free(upvalue);
     }
 }
 
@@ -158,6 +188,7 @@ static XrUpvalue *capture_upvalue(VM *vm, XrValue *location) {
     
     /* 创建新的upvalue */
     XrUpvalue *created_upvalue = xr_bc_upvalue_new(location);
+    xr_bc_gc_track_upvalue(vm, created_upvalue);
     created_upvalue->next = upvalue;
     
     /* 插入到链表中（保持降序） */
@@ -222,7 +253,7 @@ void xr_bc_cfunction_free(XrCFunction *cfunc) {
 ** 创建闭包对象
 */
 XrClosure *xr_bc_closure_new(Proto *proto) {
-    XrClosure *closure = (XrClosure *)xr_malloc(sizeof(XrClosure));
+    XrClosure *closure = (XrClosure *)xr_slab_alloc(sizeof(XrClosure));
     if (closure == NULL) {
         return NULL;
     }
@@ -233,7 +264,7 @@ XrClosure *xr_bc_closure_new(Proto *proto) {
     
     /* 分配upvalue数组 */
     if (proto->sizeupvalues > 0) {
-        closure->upvalues = (XrUpvalue **)xr_malloc(sizeof(XrUpvalue*) * proto->sizeupvalues);
+        closure->upvalues = (XrUpvalue **)xr_slab_alloc(sizeof(XrUpvalue*) * proto->sizeupvalues);
         for (int i = 0; i < proto->sizeupvalues; i++) {
             closure->upvalues[i] = NULL;
         }
@@ -253,18 +284,43 @@ void xr_bc_closure_free(XrClosure *closure) {
     }
     
     if (closure->upvalues != NULL) {
-        xr_free(closure->upvalues);
+        xr_slab_free(closure->upvalues);
     }
     
-    xr_free(closure);
+    xr_slab_free(closure);
 }
 
 /* ========== VM初始化和清理 ========== */
 
+/*
+** 当前字符串池和slab是进程全局的：多个VM并存时，每个执行入口先切换到
+** 正在运行的VM的池和slab（区域打开时为区域的），返回前恢复调用者的
+*/
+typedef struct {
+    StringPool *pool;
+    XrSlab *slab;
+} VmScope;
+
+static VmScope vm_enter(VM *vm) {
+    VmScope scope = { xr_string_pool_current(), xr_slab_current() };
+    xr_string_pool_use(vm->region.active ? &vm->region.strings : &vm->strings);
+    xr_slab_use(vm->region.active ? &vm->region.slab : &vm->slab);
+    return scope;
+}
+
+static void vm_leave(VmScope scope) {
+    xr_string_pool_use(scope.pool);
+    xr_slab_use(scope.slab);
+}
+
 /*
 ** 初始化虚拟机
 */
 void xr_bc_vm_init(VM *vm) {
+    /* 寄存器全部置null：GC把调用帧窗口内的寄存器都当作根 */
+    for (int i = 0; i < STACK_MAX; i++) {
+        vm->stack[i] = xr_null();
+    }
     vm->stack_top = vm->stack;
     vm->frame_count = 0;
     vm->open_upvalues = NULL;
@@ -277,13 +333,27 @@ void xr_bc_vm_init(VM *vm) {
     
     /* 全局变量使用数组，无需哈希表 */
     
-    /* 初始化字符串驻留表 */
-    vm->strings = xr_hashmap_new();
+    /* 字符串池归VM所有，之后创建的字符串都登记在这里 */
+    memset(&vm->strings, 0, sizeof(vm->strings));
+    xr_string_pool_use(&vm->strings);
+    
+    /* slab同样归VM所有，之后的定长对象从这里分配 */
+    xr_slab_init(&vm->slab);
+    xr_slab_use(&vm->slab);
     
     /* GC初始化 */
-    vm->objects = NULL;
-    vm->bytes_allocated = 0;
-    vm->next_gc = 1024 * 1024;  /* 1MB */
+    xr_bc_gc_init(vm);
+    
+    /* 字符串构建器栈 */
+    for (int i = 0; i < BUILDERS_MAX; i++) {
+        xr_strbuf_init(&vm->builders[i]);
+    }
+    vm->builder_count = 0;
+    
+    /* print输出缓冲 */
+    xr_strbuf_init(&vm->output);
+    vm->output_fn = NULL;
+    vm->output_ud = NULL;
     
     /* 调试选项 */
     vm->trace_execution = false;
@@ -295,20 +365,143 @@ void xr_bc_vm_init(VM *vm) {
 void xr_bc_vm_free(VM *vm) {
     /* 全局变量使用数组，无需释放哈希表 */
     
-    /* 释放字符串驻留表 */
-    if (vm->strings != NULL) {
-        xr_hashmap_free(vm->strings);
-        vm->strings = NULL;
+    /* 之前选中的是别的VM的池和slab时，释放后恢复它们 */
+    StringPool *saved_pool = xr_string_pool_current();
+    if (saved_pool == &vm->strings || saved_pool == &vm->region.strings) {
+        saved_pool = NULL;
     }
+    XrSlab *saved_slab = xr_slab_current();
+    if (saved_slab == &vm->slab || saved_slab == &vm->region.slab) {
+        saved_slab = NULL;
+    }
+    
+    /* 仍打开的区域先归还 */
+    xr_bc_region_reset(vm);
+    
+    /* 对象释放时先回到本VM的slab */
+    xr_slab_use(&vm->slab);
+    
+    /* 释放字符串池（包括未驻留的长字符串），不再指向本VM */
+    xr_string_pool_use(&vm->strings);
+    xr_string_pool_free();
+    xr_string_pool_use(saved_pool);
     
     /* 释放所有GC对象 */
-    XrObject *object = vm->objects;
-    while (object != NULL) {
-        XrObject *next = object->next;
-        /* 对象释放：当前由xmem管理，GC阶段将自动处理 */
-        object = next;
+    xr_bc_gc_free_all(vm);
+    
+    /* slab的页整体归还 */
+    xr_slab_free_all(&vm->slab);
+    xr_slab_use(saved_slab);
+    
+    /* 释放字符串构建器缓冲区 */
+    for (int i = 0; i < BUILDERS_MAX; i++) {
+        xr_strbuf_free(&vm->builders[i]);
     }
-    vm->objects = NULL;
+    vm->builder_count = 0;
+    
+    /* 写出剩余的print输出 */
+    xr_bc_vm_flush_output(vm);
+    xr_strbuf_free(&vm->output);
+}
+
+/*
+** 重置虚拟机的执行状态
+** 归还仍打开的区域，清空寄存器、调用帧、全局变量和构建器，
+** 再做一次完整GC回收不再可达的对象；输出目标和GC、区域模式的配置保留
+*/
+void xr_bc_vm_reset(VM *vm) {
+    xr_bc_region_reset(vm);
+    
+    for (int i = 0; i < STACK_MAX; i++) {
+        vm->stack[i] = xr_null();
+    }
+    vm->stack_top = vm->stack;
+    vm->frame_count = 0;
+    vm->open_upvalues = NULL;
+    
+    vm->global_count = 0;
+    for (int i = 0; i < 256; i++) {
+        vm->globals_array[i] = xr_null();
+    }
+    
+    for (int i = 0; i < vm->builder_count; i++) {
+        xr_strbuf_reset(&vm->builders[i]);
+    }
+    vm->builder_count = 0;
+    
+    /* 进行中的增量标记随之完成，记忆集和年轻代清空 */
+    xr_bc_gc_collect(vm);
+    memset(&vm->gc_pauses, 0, sizeof(vm->gc_pauses));
+}
+
+/* ========== 区域模式 ========== */
+
+/*
+** 开关区域模式
+*/
+void xr_bc_vm_set_region_mode(VM *vm, bool enabled) {
+    xr_bc_region_reset(vm);
+    vm->region.enabled = enabled;
+    
+    /* 寄存器里可能还有区域对象的旧指针，之后的GC会把调用帧窗口当作根 */
+    if (!enabled) {
+        for (int i = 0; i < STACK_MAX; i++) {
+            vm->stack[i] = xr_null();
+        }
+    }
+}
+
+/* ========== 输出 ========== */
+
+/*
+** 设置print输出目标
+*/
+void xr_bc_vm_set_output(VM *vm, XrOutputFn fn, void *ud) {
+    xr_bc_vm_flush_output(vm);
+    vm->output_fn = fn;
+    vm->output_ud = ud;
+}
+
+/*
+** 写出print缓冲区
+*/
+void xr_bc_vm_flush_output(VM *vm) {
+    XrStringBuilder *out = &vm->output;
+    if (out->length == 0) return;
+    
+    if (vm->output_fn != NULL) {
+        vm->output_fn(out->data, out->length, vm->output_ud);
+    } else {
+        fwrite(out->data, 1, out->length, stdout);
+        fflush(stdout);
+    }
+    xr_strbuf_reset(out);
+}
+
+/*
+** 把值的文本追加到输出缓冲（数字直接格式化进缓冲区）
+** 对象的写法与xr_print_value一致
+*/
+static void output_value(XrStringBuilder *out, XrValue value) {
+    if (xr_isstring(value) || xr_isint(value) || xr_isfloat(value) ||
+        xr_isbool(value) || xr_isnull(value)) {
+        xr_strbuf_append_value(out, value);
+        return;
+    }
+    
+    XrObject *obj = (XrObject*)xr_toobj(value);
+    const char *text;
+    if (obj == NULL) {
+        text = "null";
+    } else {
+        switch (obj->type) {
+            case XR_TFUNCTION: text = "<function>"; break;
+            case XR_TARRAY:    text = "<array>"; break;
+            case XR_TINSTANCE: text = "<instance>"; break;
+            default:           text = "<object>"; break;
+        }
+    }
+    xr_strbuf_append(out, text, strlen(text));
 }
 
 /* ========== 值操作辅助函数 ========== */
@@ -322,7 +515,12 @@ static bool values_equal(XrValue a, XrValue b) {
     if (XR_IS_NUM(a) && XR_IS_NUM(b)) {
         return XR_TO_FLOAT(a) == XR_TO_FLOAT(b);
     }
-    return a == b;
+    if (a == b) return true;
+    /* 长字符串不驻留，内容相同的可能是不同对象 */
+    if (xr_isstring(a) && xr_isstring(b)) {
+        return xr_string_equal(xr_tostring(a), xr_tostring(b));
+    }
+    return false;
 #else
     /* Tagged Union模式 */
     if (a.type != b.type) {
@@ -339,6 +537,7 @@ static bool values_equal(XrValue a, XrValue b) {
         case XR_TFLOAT:
             return a.as.n == b.as.n;
         case XR_TSTRING:
+            return xr_string_equal((XrString*)a.as.obj, (XrString*)b.as.obj);
         case XR_TFUNCTION:
         case XR_TARRAY:
         case XR_TMAP:
@@ -370,6 +569,15 @@ bool xr_bc_is_truthy(XrValue value) {
     return !is_falsey(value);
 }
 
+/*
+** 字符串拼接（至少一侧是字符串）
+** 按总长一次分配；数字直接格式化进缓冲区
+*/
+static XrString *concat_values(XrValue a, XrValue b) {
+    XrValue parts[2] = { a, b };
+    return xr_strbuf_concat(parts, 2);
+}
+
 /* ========== VM执行循环 ========== */
 
 /*
@@ -484,14 +692,8 @@ startfunc:
                         }
                         
                         /* 创建闭包对象 */
-                        XrClosure *closure = (XrClosure*)gc_alloc(sizeof(XrClosure), OBJ_CLOSURE);
-                        closure->header.type = XR_TFUNCTION;
-                        closure->header.next = vm->objects;
-                        closure->header.marked = false;
-                        closure->proto = proto;
-                        closure->upvalue_count = 0;
-                        closure->upvalues = NULL;
-                        vm->objects = (XrObject*)closure;
+                        XrClosure *closure = xr_bc_closure_new(proto);
+                        xr_bc_gc_track(vm, (XrObject*)closure);
                         
                         /* 设置参数：R[a+1] = this, R[a+2] = other */
                         R(a + 1) = R(b);  /* this */
@@ -505,6 +707,7 @@ startfunc:
                         
                         /* 跳转到新函数执行 */
                         frame = new_frame;
+                        GC_CHECK();
                         goto startfunc;
                     }
                     /* 没有找到运算符方法，继续尝试内置运算 */
@@ -517,8 +720,12 @@ startfunc:
                     double nb = xr_isint(R(b)) ? (double)xr_toint(R(b)) : xr_tofloat(R(b));
                     double nc = xr_isint(R(c)) ? (double)xr_toint(R(c)) : xr_tofloat(R(c));
                     R(a) = xr_float(nb + nc);
+                } else if (xr_isstring(R(b)) || xr_isstring(R(c))) {
+                    /* 字符串拼接：另一侧转为文本，只分配一次 */
+                    R(a) = xr_string_value(concat_values(R(b), R(c)));
+                    GC_CHECK();
                 } else {
-                    xr_bc_runtime_error(vm, "类型错误：加法操作数必须是数字或定义了operator+的类实例");
+                    xr_bc_runtime_error(vm, "类型错误：加法操作数必须是数字、字符串或定义了operator+的类实例");
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 break;
@@ -530,8 +737,13 @@ startfunc:
                 int b = GETARG_B(inst);
                 int sc = GETARG_sC(inst);  /* 有符号立即数 */
                 
-                /* 直接整数运算，无类型检查 */
-                R(a) = xr_int(xr_toint(R(b)) + sc);
+                /* 字符串 + 整数字面量：走拼接；其余直接整数运算，无类型检查 */
+                if (unlikely(xr_isstring(R(b)))) {
+                    R(a) = xr_string_value(concat_values(R(b), xr_int(sc)));
+                    GC_CHECK();
+                } else {
+                    R(a) = xr_int(xr_toint(R(b)) + sc);
+                }
                 break;
             }
             
@@ -874,6 +1086,9 @@ startfunc:
             case OP_JMP: {
                 int sj = GETARG_sJ(inst);
                 frame->pc += sj;
+                if (sj < 0) {
+                    GC_BACKEDGE();
+                }
                 break;
             }
             
@@ -899,6 +1114,54 @@ startfunc:
                 break;
             }
             
+            case OP_ITERPREP: {
+                /* for-in：R[A]为被迭代对象，R[A+1]为游标 */
+                int a = GETARG_A(inst);
+                
+                if (!xr_isarray(R(a)) && !xr_ismap(R(a))) {
+                    xr_bc_runtime_error(vm, "for-in requires an array or map");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                R(a + 1) = xr_int(0);
+                break;
+            }
+            
+            case OP_ITERNEXT: {
+                /* 取下一个元素：成功则写入循环变量并跳过随后的退出跳转
+                ** B=1：数组绑定元素，Map绑定键
+                ** B=2：R[A+2]=下标/键，R[A+3]=元素/值
+                ** 游标保存在寄存器中，迭代不分配内存 */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                uint32_t cursor = (uint32_t)xr_toint(R(a + 1));
+                
+                if (xr_isarray(R(a))) {
+                    XrArray *array = xr_to_array(R(a));
+                    if (cursor < array->count) {
+                        if (b == 1) {
+                            R(a + 2) = array->elements[cursor];
+                        } else {
+                            R(a + 2) = xr_int(cursor);
+                            R(a + 3) = array->elements[cursor];
+                        }
+                        R(a + 1) = xr_int(cursor + 1);
+                        frame->pc++;
+                    }
+                    break;
+                }
+                
+                XrValue key, value;
+                if (xr_map_next(xr_to_map(R(a)), &cursor, &key, &value)) {
+                    R(a + 2) = key;
+                    if (b > 1) {
+                        R(a + 3) = value;
+                    }
+                    R(a + 1) = xr_int(cursor);
+                    frame->pc++;
+                }
+                break;
+            }
+            
             case OP_GETGLOBAL: {
                 /* Wren风格优化：Bx现在是全局变量的固定索引，而非常量索引 */
                 int a = GETARG_A(inst);
@@ -953,6 +1216,7 @@ startfunc:
                 
                 /* 创建闭包 */
                 XrClosure *closure = xr_bc_closure_new(proto);
+                xr_bc_gc_track(vm, (XrObject*)closure);
                 
                 /* 捕获upvalues（使用Lua风格的capture机制） */
                 for (int i = 0; i < proto->sizeupvalues; i++) {
@@ -968,6 +1232,7 @@ startfunc:
                 
                 /* 存储闭包（使用正确的闭包值表示） */
                 R(a) = xr_value_from_closure(closure);
+                GC_CHECK();
                 break;
             }
             
@@ -1039,11 +1304,71 @@ startfunc:
                 break;
             }
             
+            case OP_CONCAT: {
+                /* R[A] = R[B] .. ... .. R[B+C-1]：总长只算一次，一次分配 */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                int c = GETARG_C(inst);
+                
+                R(a) = xr_string_value(xr_strbuf_concat(&R(b), c));
+                GC_CHECK();
+                break;
+            }
+            
+            case OP_SBBEGIN: {
+                /* R[A] = builder(R[B])：以R[B]为初始内容开启构建器 */
+                /* R[B]不是字符串或构建器栈已满时R[A] = nil，循环体退回普通ADD */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                
+                if (xr_isstring(R(b)) && vm->builder_count < BUILDERS_MAX) {
+                    int slot = vm->builder_count++;
+                    XrStringBuilder *sb = &vm->builders[slot];
+                    xr_strbuf_reset(sb);
+                    xr_strbuf_append_string(sb, xr_tostring(R(b)));
+                    R(a) = xr_int(slot);
+                } else {
+                    R(a) = xr_null();
+                }
+                break;
+            }
+            
+            case OP_SBAPPEND: {
+                /* if R[A] then append(R[A], R[B]); PC++ */
+                /* 下一条是同一拼接的ADD，构建器未开启时执行它 */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                
+                if (!xr_isnull(R(a))) {
+                    xr_strbuf_append_value(&vm->builders[xr_toint(R(a))], R(b));
+                    frame->pc++;
+                }
+                break;
+            }
+            
+            case OP_SBEND: {
+                /* if R[A] then R[B] = tostring(R[A])，释放构建器（栈式，后开先关） */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                
+                if (!xr_isnull(R(a))) {
+                    int slot = (int)xr_toint(R(a));
+                    R(b) = xr_string_value(xr_strbuf_take_string(&vm->builders[slot]));
+                    vm->builder_count = slot;
+                    R(a) = xr_null();
+                    GC_CHECK();
+                }
+                break;
+            }
+            
             case OP_PRINT: {
-                /* print(R[A]) - 打印寄存器值 */
+                /* print(R[A]) - 写入输出缓冲，满了再整块写出 */
                 int a = GETARG_A(inst);
-                xr_print_value(R(a));
-                printf("\n");
+                output_value(&vm->output, R(a));
+                xr_strbuf_append(&vm->output, "\n", 1);
+                if (vm->output.length >= OUTPUT_FLUSH_SIZE) {
+                    xr_bc_vm_flush_output(vm);
+                }
                 break;
             }
             
@@ -1059,9 +1384,29 @@ startfunc:
                 
                 /* 创建数组 */
                 XrArray *array = (b > 0) ? xr_array_with_capacity(b) : xr_array_new();
+                xr_bc_gc_track(vm, (XrObject*)array);
                 
                 /* 存储数组 */
                 R(a) = xr_value_from_array(array);
+                GC_CHECK();
+                break;
+            }
+            
+            case OP_NEWMAP: {
+                /* R[A] = Map{} - 创建Map（B=预分配元素数，C!=0为WeakMap） */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                int c = GETARG_C(inst);
+                
+                XrMap *map;
+                if (c != 0) {
+                    map = xr_map_new_weak();
+                } else {
+                    map = (b > 0) ? xr_map_with_capacity((uint32_t)b) : xr_map_new();
+                }
+                xr_bc_gc_track(vm, (XrObject*)map);
+                R(a) = xr_value_from_map(map);
+                GC_CHECK();
                 break;
             }
             
@@ -1071,8 +1416,14 @@ startfunc:
                 int b = GETARG_B(inst);
                 int c = GETARG_C(inst);
                 
-                /* 获取数组对象 */
+                /* Map：任意可哈希键 */
                 XrValue table_val = R(b);
+                if (xr_ismap(table_val)) {
+                    R(a) = xr_map_get(xr_to_map(table_val), R(c), NULL);
+                    break;
+                }
+                
+                /* 获取数组对象 */
                 if (!xr_isarray(table_val)) {
                     xr_bc_runtime_error(vm, "Attempt to index a non-array value");
                     return INTERPRET_RUNTIME_ERROR;
@@ -1098,8 +1449,17 @@ startfunc:
                 int b = GETARG_B(inst);
                 int c = GETARG_C(inst);
                 
-                /* 获取数组对象 */
+                /* Map：任意可哈希键 */
                 XrValue table_val = R(a);
+                if (xr_ismap(table_val)) {
+                    XrMap *map = xr_to_map(table_val);
+                    xr_map_set(map, R(b), R(c));
+                    xr_bc_gc_barrier(vm, (XrObject*)map, R(b));
+                    xr_bc_gc_barrier(vm, (XrObject*)map, R(c));
+                    break;
+                }
+                
+                /* 获取数组对象 */
                 if (!xr_isarray(table_val)) {
                     xr_bc_runtime_error(vm, "Attempt to index a non-array value");
                     return INTERPRET_RUNTIME_ERROR;
@@ -1116,6 +1476,43 @@ startfunc:
                 
                 int index = (int)xr_toint(index_val);
                 xr_array_set(array, index, R(c));
+                xr_bc_gc_barrier(vm, (XrObject*)array, R(c));
+                break;
+            }
+            
+            case OP_GETFIELD: {
+                /* R[A] = R[B][K[C]:string] - 常量字符串键访问 */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                int c = GETARG_C(inst);
+                
+                XrValue table_val = R(b);
+                if (!xr_ismap(table_val)) {
+                    xr_bc_runtime_error(vm, "Attempt to index a non-map value with a string key");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                
+                /* 键来自常量池，哈希已预计算 */
+                R(a) = xr_map_get_str(xr_to_map(table_val), xr_tostring(K(c)), NULL);
+                break;
+            }
+            
+            case OP_SETFIELD: {
+                /* R[A][K[B]:string] = R[C] - 常量字符串键赋值 */
+                int a = GETARG_A(inst);
+                int b = GETARG_B(inst);
+                int c = GETARG_C(inst);
+                
+                XrValue table_val = R(a);
+                if (!xr_ismap(table_val)) {
+                    xr_bc_runtime_error(vm, "Attempt to index a non-map value with a string key");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                
+                XrMap *map = xr_to_map(table_val);
+                xr_map_set_str(map, xr_tostring(K(b)), R(c));
+                xr_bc_gc_barrier(vm, (XrObject*)map, K(b));
+                xr_bc_gc_barrier(vm, (XrObject*)map, R(c));
                 break;
             }
             
@@ -1136,6 +1533,7 @@ startfunc:
                 /* 批量设置元素（xr_array_set会自动扩展数组） */
                 for (int i = 1; i <= b; i++) {
                     xr_array_set(array, i - 1, R(a + i));
+                    xr_bc_gc_barrier(vm, (XrObject*)array, R(a + i));
                 }
                 break;
             }
@@ -1156,6 +1554,9 @@ startfunc:
                     
                     /* 调用C函数（参数从R[a+1]开始） */
                     XrValue result = cfunc->func(&vm, &R(a + 1), nargs);
+                    for (int i = 1; i <= nargs; i++) {
+                        xr_bc_gc_barrier_arg(vm, R(a + i));
+                    }
                     
                     /* 检查是否出错（可以通过返回值类型判断）*/
                     if (xr_isnull(result) && nargs < 0) {  /* 错误标志 */
@@ -1366,7 +1767,9 @@ startfunc:
                 
                 XrString *class_name = xr_tostring(name_val);
                 XrClass *cls = xr_class_new(NULL, class_name->chars, NULL);
+                xr_bc_gc_track(vm, (XrObject*)cls);
                 R(a) = xr_value_from_class(cls);
+                GC_CHECK();
                 break;
             }
             
@@ -1449,7 +1852,9 @@ startfunc:
                 
                 /* 创建方法对象并通过symbol添加到类（高性能）*/
                 XrMethod *method = xr_method_new(NULL, method_name, func, false);
+                xr_bc_gc_track_method(vm, method);
                 xr_class_add_method_by_symbol(cls, method_symbol, method);  /* ⭐ 使用by_symbol */
+                GC_CHECK();
                 break;
             }
             
@@ -1481,6 +1886,7 @@ startfunc:
                     if (strcmp(method_name_chars, "constructor") == 0) {
                         /* 创建实例 */
                         XrInstance *inst = xr_instance_new(NULL, cls);
+                        xr_bc_gc_track(vm, (XrObject*)inst);
                         XrValue inst_val = xr_value_from_instance(inst);
                         
                         /* v0.20.0: 通过symbol查找构造函数（高性能）*/
@@ -1505,14 +1911,8 @@ startfunc:
                             }
                             
                             /* 创建堆上的闭包对象 */
-                            XrClosure *closure = (XrClosure*)gc_alloc(sizeof(XrClosure), OBJ_CLOSURE);
-                            closure->header.type = XR_TFUNCTION;
-                            closure->header.next = vm->objects;
-                            closure->header.marked = false;
-                            closure->proto = proto;
-                            closure->upvalue_count = 0;
-                            closure->upvalues = NULL;
-                            vm->objects = (XrObject*)closure;
+                            XrClosure *closure = xr_bc_closure_new(proto);
+                            xr_bc_gc_track(vm, (XrObject*)closure);
                             
                             /* 将this放到参数位置的第一个 */
                             /* 参数布局：R[a+1] = this, R[a+2] = arg1, R[a+3] = arg2, ... */
@@ -1530,11 +1930,13 @@ startfunc:
                             
                             /* 跳转到新函数 */
                             frame = new_frame;
+                            GC_CHECK();
                             goto startfunc;
                         }
                         
                         /* 没有构造函数或执行完毕，返回实例 */
                         R(a) = inst_val;
+                        GC_CHECK();
                     } else {
                         xr_bc_runtime_error(vm, "Cannot call method '%s' on class", method_name_chars);
                         return INTERPRET_RUNTIME_ERROR;
@@ -1567,14 +1969,8 @@ startfunc:
                     }
                     
                     /* 创建堆上的闭包对象 */
-                    XrClosure *closure = (XrClosure*)gc_alloc(sizeof(XrClosure), OBJ_CLOSURE);
-                    closure->header.type = XR_TFUNCTION;
-                    closure->header.next = vm->objects;
-                    closure->header.marked = false;
-                    closure->proto = proto;
-                    closure->upvalue_count = 0;
-                    closure->upvalues = NULL;
-                    vm->objects = (XrObject*)closure;
+                    XrClosure *closure = xr_bc_closure_new(proto);
+                    xr_bc_gc_track(vm, (XrObject*)closure);
                     
                     /* 将this放到参数位置的第一个 */
                     for (int i = nargs; i > 0; i--) {
@@ -1590,6 +1986,7 @@ startfunc:
                     
                     /* 跳转到新函数 */
                     frame = new_frame;
+                    GC_CHECK();
                     goto startfunc;
                 } else {
                     xr_bc_runtime_error(vm, "INVOKE: receiver must be a class or instance");
@@ -1670,6 +2067,7 @@ startfunc:
                 }
                 
                 xr_instance_set_field(inst, prop_name->chars, value);
+                xr_bc_gc_barrier(vm, (XrObject*)inst, value);
                 break;
             }
             
@@ -1712,6 +2110,7 @@ XrValue xr_bc_call_closure(VM *vm, XrClosure *closure, XrValue *args, int nargs)
         fprintf(stderr, "Stack overflow in callback\n");
         return xr_null();
     }
+    VmScope scope = vm_enter(vm);
     
     BcCallFrame *frame = &vm->frames[vm->frame_count++];
     frame->closure = closure;
@@ -1737,6 +2136,7 @@ XrValue xr_bc_call_closure(VM *vm, XrClosure *closure, XrValue *args, int nargs)
     vm->stack_top = saved_stack_top;
     vm->frame_count = saved_frame_count;
     
+    vm_leave(scope);
     return return_value;
 }
 
@@ -1746,23 +2146,38 @@ XrValue xr_bc_call_closure(VM *vm, XrClosure *closure, XrValue *args, int nargs)
 ** 执行函数原型
 */
 InterpretResult xr_bc_interpret_proto(VM *vm, Proto *proto) {
+    VmScope scope = vm_enter(vm);
+    
+    /* 区域模式：这次执行的对象（含顶层闭包）都归新区域 */
+    if (vm->region.enabled) {
+        xr_bc_region_begin(vm, proto);
+    }
+    
     /* 创建顶层闭包 */
     XrClosure *closure = xr_bc_closure_new(proto);
     if (closure == NULL) {
+        vm_leave(scope);
         return INTERPRET_RUNTIME_ERROR;
     }
+    xr_bc_gc_track(vm, (XrObject*)closure);
     
     /* 不需要压栈 - 直接创建调用帧 */
     vm->stack_top = vm->stack;
     
+    /* 上次执行若因运行时错误中断，可能遗留未结束的构建器 */
+    vm->builder_count = 0;
+    
     /* 创建调用帧 */
     BcCallFrame *frame = &vm->frames[vm->frame_count++];
     frame->closure = closure;
     frame->pc = proto->code;
     frame->base = vm->stack;
     
-    /* 执行 */
-    return run(vm);
+    /* 执行（结束或出错都写出print缓冲） */
+    InterpretResult result = run(vm);
+    xr_bc_vm_flush_output(vm);
+    vm_leave(scope);
+    return result;
 }
 
 /*
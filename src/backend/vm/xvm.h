@@ -12,12 +12,34 @@
 #include "xchunk.h"
 #include "xvalue.h"
 #include "xhashmap.h"
+#include "xstrbuf.h"
+#include "xslab.h"
 #include <stdbool.h>
 
 /* ========== 常量定义 ========== */
 
 #define FRAMES_MAX 64               /* 最大调用帧数量 */
 #define STACK_MAX (FRAMES_MAX * 256) /* 最大栈大小（寄存器数量） */
+#define BUILDERS_MAX FRAMES_MAX     /* 最多同时活跃的字符串构建器 */
+#define OUTPUT_FLUSH_SIZE (64 * 1024) /* print缓冲区达到该大小时写出 */
+#define GC_MIN_HEAP (1024 * 1024)   /* GC阈值下限 */
+#define GC_HEAP_GROW_FACTOR 2       /* GC后阈值 = 存活字节数 * 该倍数 */
+#define GC_NURSERY_SIZE (256 * 1024) /* 年轻代达到该大小时做minor GC */
+#define GC_PROMOTE_AGE 2            /* 熬过该次数minor GC的对象晋升老年代 */
+#define GC_STRESS_FULL_INTERVAL 16  /* 压力测试模式下完整GC的间隔 */
+#define GC_STEP_SIZE (16 * 1024)    /* 增量标记期间每分配这么多字节做一步 */
+#define GC_STEP_BATCH 32            /* 每批追踪的对象数（批间检查停顿时长） */
+#define GC_BACKEDGE_INTERVAL 1024   /* 增量标记期间每隔这么多次循环回跳做一步 */
+#define GC_PAUSE_TARGET_US 1000.0   /* 默认的单次停顿目标（微秒） */
+#define GC_PAUSE_BUCKETS 16         /* 停顿直方图格数 */
+
+/* ========== 输出目标 ========== */
+
+/*
+** print输出写入函数
+** 嵌入方可以借此截获脚本输出（写文件描述符、管道、内存等）
+*/
+typedef void (*XrOutputFn)(const char *data, size_t length, void *ud);
 
 /* ========== C函数对象 ========== */
 
@@ -49,6 +71,52 @@ typedef struct {
     int upvalue_count;          /* upvalue数量 */
 } XrClosure;
 
+/* ========== GC状态 ========== */
+
+/* GC阶段 */
+typedef enum {
+    GC_PAUSE,                   /* 空闲：只做minor GC */
+    GC_MARK                     /* 完整GC的增量标记进行中 */
+} GcPhase;
+
+/*
+** GC停顿统计
+** histogram[k]是时长在[2^(k-1), 2^k)微秒内的停顿次数，
+** 第0格是不足1微秒的，最后一格不设上限
+*/
+typedef struct {
+    unsigned int histogram[GC_PAUSE_BUCKETS];
+    unsigned int count;         /* 停顿次数 */
+    double total_us;            /* 总停顿时长（微秒） */
+    double max_us;              /* 最长停顿（微秒） */
+} GcPauseStats;
+
+/*
+** 请求级区域（见xvm_gc.c的区域模式）
+** 一次执行新建的对象和字符串都归区域所有，重置时整体丢弃
+*/
+typedef struct {
+    bool enabled;               /* 区域模式：每次xr_bc_interpret_proto打开一个区域 */
+    bool active;                /* 区域已打开（执行中，或执行完尚未重置） */
+    XrSlab slab;                /* 本次执行的定长对象和短字符串 */
+    StringPool strings;         /* 本次执行的字符串 */
+    
+    /* 打开区域时VM的状态，重置时恢复 */
+    XrObject *upvalues;         /* 之前的upvalue链表 */
+    XrObject *methods;          /* 之前的方法链表 */
+    size_t bytes_allocated;     /* 之前的老年代字节数 */
+    
+    /* 导出的副本（重置后成为年轻对象） */
+    XrObject *exported;
+    size_t exported_bytes;
+    
+    /* 不在slab中的区域对象 -> 导出副本（执行结束后才建立） */
+    void **index_keys;
+    void **index_values;
+    size_t index_count;
+    size_t index_capacity;      /* 0表示尚未建立 */
+} XrRegion;
+
 /* ========== 调用帧 ========== */
 
 /* 调用帧（函数调用栈帧） */
@@ -78,12 +146,46 @@ typedef struct {
     int global_count;           /* 全局变量数量 */
     
     /* 字符串驻留表 */
-    XrHashMap *strings;         /* 字符串驻留表 */
+    StringPool strings;         /* 字符串池（驻留表 + 长字符串） */
+    XrSlab slab;                /* 定长对象的slab分配器（upvalue/闭包/实例/字符串） */
     
-    /* GC对象链表 */
-    XrObject *objects;          /* 所有对象的链表 */
-    size_t bytes_allocated;     /* 已分配字节数 */
-    size_t next_gc;             /* 下次GC阈值 */
+    /* GC（分代标记-清除，见xvm_gc.c） */
+    XrObject *objects;          /* 老年代值对象链表（闭包/数组/Map/类/实例） */
+    XrObject *young[GC_PROMOTE_AGE]; /* 年轻代：young[k]中的对象熬过了k次minor GC */
+    XrObject *upvalues;         /* upvalue链表（只经由闭包引用） */
+    XrObject *methods;          /* 方法对象链表（只经由类引用） */
+    XrObject **gray;            /* 标记栈；GC之间保存全部老年代对象，完整GC据此清除标记 */
+    int gray_count;             /* 标记栈中的对象数量 */
+    int gray_capacity;          /* 标记栈容量 */
+    XrObject **remembered;      /* 记忆集：写入过年轻值的老对象 */
+    int remembered_count;       /* 记忆集中的对象数量 */
+    int remembered_capacity;    /* 记忆集容量 */
+    int *remembered_index;      /* 记忆集的指针散列（存下标+1，0为空），保证每个对象只记一次 */
+    int remembered_index_capacity; /* 散列槽位数（记忆集容量的2倍） */
+    XrString *old_strings;      /* 上次GC后的长字符串表头（从它开始都是老字符串） */
+    size_t young_bytes;         /* 年轻代对象的字节数 */
+    size_t string_bytes;        /* 上次GC后字符串池的字节数 */
+    size_t bytes_allocated;     /* 老年代对象的字节数（字符串见strings.bytes） */
+    size_t next_gc;             /* 完整GC阈值 */
+    unsigned int gc_epoch;      /* 已完成的GC轮次（兼作Proto的标记） */
+    unsigned int gc_full_count; /* 其中完整GC的次数 */
+    GcPhase gc_phase;           /* 当前阶段 */
+    int gray_scan;              /* 标记栈中已追踪完（黑色）的对象数量 */
+    int gc_backedges;           /* 增量标记期间累计的循环回跳次数 */
+    size_t next_step;           /* 年轻代字节数超过该值时触发下一步GC */
+    double gc_pause_target_us;  /* 单次停顿目标（微秒），增量标记按它切分 */
+    GcPauseStats gc_pauses;     /* 停顿统计 */
+    bool gc_stress;             /* 压力测试：每个安全点都做一次GC */
+    XrRegion region;            /* 请求级区域（见xr_bc_vm_set_region_mode） */
+    
+    /* 字符串构建器栈（循环内 s = s + x 的降级目标，见OP_SBBEGIN） */
+    XrStringBuilder builders[BUILDERS_MAX];
+    int builder_count;          /* 活跃构建器数量 */
+    
+    /* print输出缓冲（见xr_bc_vm_flush_output） */
+    XrStringBuilder output;     /* 待写出的内容 */
+    XrOutputFn output_fn;       /* 输出目标，NULL表示stdout */
+    void *output_ud;            /* 传给output_fn的用户数据 */
     
     /* 调试选项 */
     bool trace_execution;       /* 是否跟踪执行 */
@@ -113,6 +215,11 @@ void xr_bc_vm_init(VM *vm);
 */
 void xr_bc_vm_free(VM *vm);
 
+/*
+** 重置虚拟机的执行状态（栈、全局变量、构建器、区域），回收不再可达的对象
+*/
+void xr_bc_vm_reset(VM *vm);
+
 /*
 ** 执行源代码
 ** @param source 源代码字符串
@@ -127,6 +234,30 @@ InterpretResult xr_bc_interpret(const char *source);
 */
 InterpretResult xr_bc_interpret_proto(VM *vm, Proto *proto);
 
+/* ========== 输出API ========== */
+
+/*
+** 设置print输出目标
+** fn为NULL时恢复为stdout；已缓冲的内容先写到原目标
+*/
+void xr_bc_vm_set_output(VM *vm, XrOutputFn fn, void *ud);
+
+/*
+** 写出print缓冲区
+** 执行结束、运行时错误和缓冲区满时自动调用
+*/
+void xr_bc_vm_flush_output(VM *vm);
+
+/* ========== 区域模式API ========== */
+
+/*
+** 开关区域模式（短脚本反复执行的场景，如每个请求跑一段脚本）
+** 开启后每次xr_bc_interpret_proto新建的对象都在一个区域里，执行期间不做GC；
+** 结束后用xr_bc_region_export取出需要的值，再用xr_bc_region_reset整体丢弃
+** 关闭时先重置仍打开的区域
+*/
+void xr_bc_vm_set_region_mode(VM *vm, bool enabled);
+
 /* ========== C函数API ========== */
 
 /*
@@ -4,6 +4,7 @@
 */
 
 #include "xvm_context.h"
+#include "xvm_gc.h"
 #include "xmem.h"
 #include <stdio.h>
 #include <string.h>
@@ -76,12 +77,10 @@ VMContext* xr_vm_context_wrap(VM *vm, bool take_ownership) {
 void xr_vm_context_free(VMContext *ctx) {
     if (!ctx) return;
     
-    /* 如果拥有VM，则释放VM */
+    /* 如果拥有VM，则释放VM：对象、字符串池和slab一并归还，
+    ** 当前字符串池不再指向这块内存 */
     if (ctx->owns_vm && ctx->vm) {
-        /* 注意：这里应该调用xr_bc_vm_free，但它使用全局vm
-         * 实际使用时需要修改xr_bc_vm_free接受VM*参数
-         * 现在先简单释放内存
-         */
+        xr_bc_vm_free(ctx->vm);
         xmem_free(ctx->vm);
     }
     
@@ -101,10 +100,7 @@ void xr_vm_context_reset(VMContext *ctx) {
     ctx->execution_time = 0.0;
     
     /* 重置VM状态 */
-    ctx->vm->stack_top = ctx->vm->stack;
-    ctx->vm->frame_count = 0;
-    ctx->vm->open_upvalues = NULL;
-    ctx->vm->global_count = 0;
+    xr_bc_vm_reset(ctx->vm);
 }
 
 /* ========== VM操作 ========== */
@@ -115,33 +111,8 @@ void xr_vm_context_reset(VMContext *ctx) {
 void xr_vm_ctx_init(VMContext *ctx) {
     if (!ctx || !ctx->vm) return;
     
-    VM *vm = ctx->vm;
-    
-    /* 初始化栈 */
-    vm->stack_top = vm->stack;
-    
-    /* 初始化调用帧 */
-    vm->frame_count = 0;
-    
-    /* 初始化upvalue链表 */
-    vm->open_upvalues = NULL;
-    
-    /* 初始化全局变量 */
-    vm->global_count = 0;
-    for (int i = 0; i < 256; i++) {
-        vm->globals_array[i] = xr_null();
-    }
-    
-    /* 初始化字符串驻留表 */
-    vm->strings = NULL;  /* 延迟初始化 */
-    
-    /* 初始化GC */
-    vm->objects = NULL;
-    vm->bytes_allocated = 0;
-    vm->next_gc = 1024 * 1024;  /* 1MB */
-    
-    /* 初始化调试选项 */
-    vm->trace_execution = false;
+    /* 与独立VM相同的初始化；上下文自己的字段在创建时已设置 */
+    xr_bc_vm_init(ctx->vm);
 }
 
 /*
@@ -256,6 +227,22 @@ void xr_vm_ctx_get_stats(VMContext *ctx,
     if (out_time) *out_time = ctx->execution_time;
 }
 
+/*
+** 获取GC停顿统计
+*/
+void xr_vm_ctx_get_gc_pauses(VMContext *ctx, GcPauseStats *out) {
+    if (!ctx || !ctx->vm || !out) return;
+    *out = ctx->vm->gc_pauses;
+}
+
+/*
+** 设置GC单次停顿目标
+*/
+void xr_vm_ctx_set_gc_pause_target(VMContext *ctx, double target_us) {
+    if (!ctx || !ctx->vm) return;
+    ctx->vm->gc_pause_target_us = target_us;
+}
+
 /*
 ** 打印统计信息
 */
@@ -272,6 +259,20 @@ void xr_vm_ctx_print_stats(VMContext *ctx) {
         printf("Bytes allocated: %zu\n", ctx->vm->bytes_allocated);
         printf("Stack depth: %ld\n", ctx->vm->stack_top - ctx->vm->stack);
         printf("Call depth: %d\n", ctx->vm->frame_count);
+        
+        GcPauseStats *pauses = &ctx->vm->gc_pauses;
+        printf("GC pauses: %u (max %.1f us, total %.1f us)\n",
+               pauses->count, pauses->max_us, pauses->total_us);
+        for (int i = 0; i < GC_PAUSE_BUCKETS; i++) {
+            if (pauses->histogram[i] == 0) continue;
+            if (i == 0) {
+                printf("  < 1 us: %u\n", pauses->histogram[i]);
+            } else if (i == GC_PAUSE_BUCKETS - 1) {
+                printf("  >= %u us: %u\n", 1u << (i - 1), pauses->histogram[i]);
+            } else {
+                printf("  %u-%u us: %u\n", 1u << (i - 1), 1u << i, pauses->histogram[i]);
+            }
+        }
     }
 }
 
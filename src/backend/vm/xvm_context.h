@@ -143,6 +143,21 @@ void xr_vm_ctx_get_stats(VMContext *ctx,
                         size_t *out_calls,
                         double *out_time);
 
+/*
+** 获取GC停顿统计（含停顿时长直方图）
+** @param ctx VM上下文
+** @param out 输出：停顿统计
+*/
+void xr_vm_ctx_get_gc_pauses(VMContext *ctx, GcPauseStats *out);
+
+/*
+** 设置GC单次停顿目标
+** @param ctx VM上下文
+** @param target_us 停顿目标（微秒），增量标记每步不超过它
+** 只约束标记：完整GC最后的清扫在一次停顿里做完，不受它限制
+*/
+void xr_vm_ctx_set_gc_pause_target(VMContext *ctx, double target_us);
+
 /*
 ** 打印统计信息
 ** @param ctx VM上下文
@@ -0,0 +1,1454 @@
+/*
+** xvm_gc.c
+** Xray 寄存器虚拟机的垃圾回收器实现
+**
+** 分代不移动对象：VM持有对象的裸指针，对象又由各自的构造函数
+** 分配，无法像复制式新生代那样搬迁，于是用粘性标记位区分代：
+**   - 已标记 = 老年代。标记在GC之后保留，minor GC遇到老对象直接跳过
+**   - 未标记 = 年轻代。登记的年轻对象按年龄放在young[]链表里，
+**     熬过一次minor GC就移到下一条链表，到GC_PROMOTE_AGE晋升老年代
+**   - 字符串和upvalue、方法一旦被标记就算老年代
+**
+** minor GC：
+**   1. 标记根、全部upvalue的值（upvalue只在完整GC时回收）、
+**      记忆集中的老对象，然后追踪新标记的对象（只触及年轻对象）
+**   2. 清扫年轻代链表和新登记的长字符串，存活者升一级年龄；
+**      未晋升的存活者清除标记，仍是年轻对象
+**   3. 重建记忆集：保留仍引用年轻对象的老对象和晋升对象
+**
+** 完整GC：清除全部标记后重新标记，存活者都成为老年代。标记是增量的：
+**   1. 开始：清除标记，标记根，进入GC_MARK阶段
+**   2. 每步：从gray_scan起追踪标记栈（之前的是黑色对象），
+**      每GC_STEP_BATCH个对象检查一次是否超出停顿目标
+**   3. 期间新登记的对象直接置灰；写屏障把写入黑色对象的白色值置灰；
+**      C函数修改过的参数对象重新置灰
+**   4. 结束（原子）：重新扫描根和已标记upvalue的值，追踪完标记栈，
+**      清理WeakMap，清扫全部链表和字符串池
+** 增量标记期间不做minor GC：此时标记位表示颜色而不是年龄。
+**
+** 标记栈在GC之间保存全部老年代对象：VM之外创建的对象（如C函数
+** 返回的数组）不在链表上，完整GC开始时也要据此清除它们的标记。
+**
+** 区域模式：一次执行的对象全都短命，追踪它们是白费功夫。打开区域时
+** 年轻对象先全部晋升（此后执行前就有的对象都带标记），VM的链表换成
+** 空表，slab和字符串池换成区域自己的。执行期间不做GC：
+**   - 新对象照常登记，链表上只有区域对象；定长对象和短字符串落在
+**     区域的slab里，字符串驻留在区域的池里（与VM池中的同内容字符串
+**     按内容相等）
+**   - 区域对象都未标记，往执行前的对象写入区域值会照常经过写屏障，
+**     记忆集里就是全部可能引用区域的旧对象
+** 重置时把全局变量、记忆集中的对象和旧upvalue里的区域值导出（深复制到
+** VM的堆里），逐个释放持有xmem内存的区域对象，其余随slab的页整体归还。
+*/
+
+/* clock_gettime/CLOCK_MONOTONIC 在严格C99下需要POSIX声明 */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xvm_gc.h"
+#include "xmem.h"
+#include "xstring.h"
+#include "xarray.h"
+#include "xmap.h"
+#include "xclass.h"
+#include "xinstance.h"
+#include "xmethod.h"
+#include "xhash.h"
+#include <string.h>
+#include <time.h>
+
+/* 标记栈初始容量 */
+#define GRAY_INIT_CAPACITY 64
+
+/* ========== 初始化和释放 ========== */
+
+/*
+** 初始化GC状态
+*/
+void xr_bc_gc_init(VM *vm) {
+    vm->objects = NULL;
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        vm->young[age] = NULL;
+    }
+    vm->upvalues = NULL;
+    vm->methods = NULL;
+    vm->gray = NULL;
+    vm->gray_count = 0;
+    vm->gray_capacity = 0;
+    vm->remembered = NULL;
+    vm->remembered_count = 0;
+    vm->remembered_capacity = 0;
+    vm->remembered_index = NULL;
+    vm->remembered_index_capacity = 0;
+    vm->old_strings = vm->strings.long_strings;
+    vm->young_bytes = 0;
+    vm->string_bytes = vm->strings.bytes;
+    vm->bytes_allocated = 0;
+    vm->next_gc = GC_MIN_HEAP;
+    vm->gc_epoch = 0;
+    vm->gc_full_count = 0;
+    vm->gc_phase = GC_PAUSE;
+    vm->gray_scan = 0;
+    vm->gc_backedges = 0;
+    vm->next_step = GC_NURSERY_SIZE;
+    vm->gc_pause_target_us = GC_PAUSE_TARGET_US;
+    memset(&vm->gc_pauses, 0, sizeof(vm->gc_pauses));
+#ifdef XR_GC_STRESS
+    vm->gc_stress = true;
+#else
+    vm->gc_stress = false;
+#endif
+    memset(&vm->region, 0, sizeof(vm->region));
+}
+
+/*
+** 释放值对象（按对象类型分派）
+*/
+static void free_object(XrObject *object) {
+    switch (object->type) {
+        case XR_TFUNCTION:
+            xr_bc_closure_free((XrClosure*)object);
+            break;
+        case XR_TARRAY:
+            xr_array_free((XrArray*)object);
+            break;
+        case XR_TMAP:
+            xr_map_free((XrMap*)object);
+            break;
+        case XR_TCLASS:
+            xr_class_free((XrClass*)object);
+            break;
+        case XR_TINSTANCE:
+            xr_instance_free((XrInstance*)object);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+** 释放链表上的所有值对象
+*/
+static void free_objects(XrObject *object) {
+    while (object != NULL) {
+        XrObject *next = object->next;
+        free_object(object);
+        object = next;
+    }
+}
+
+/*
+** 释放所有登记的对象
+*/
+void xr_bc_gc_free_all(VM *vm) {
+    free_objects(vm->objects);
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        free_objects(vm->young[age]);
+    }
+    
+    XrObject *object = vm->upvalues;
+    while (object != NULL) {
+        XrObject *next = object->next;
+        xr_bc_upvalue_free((XrUpvalue*)object);
+        object = next;
+    }
+    
+    object = vm->methods;
+    while (object != NULL) {
+        XrObject *next = object->next;
+        xr_method_free((XrMethod*)object);
+        object = next;
+    }
+    
+    if (vm->gray != NULL) {
+        xmem_free(vm->gray);
+    }
+    if (vm->remembered != NULL) {
+        xmem_free(vm->remembered);
+    }
+    if (vm->remembered_index != NULL) {
+        xmem_free(vm->remembered_index);
+    }
+    xr_bc_gc_init(vm);
+}
+
+/* ========== 对象登记 ========== */
+
+/* 标记函数（见下文），增量标记期间新登记的对象直接标记 */
+static void mark_object(VM *vm, XrObject *object);
+static void mark_upvalue(VM *vm, XrUpvalue *upvalue);
+static void mark_method(VM *vm, XrMethod *method);
+
+/*
+** 值对象当前占用的字节数（估算，只用于决定GC时机）
+*/
+static size_t object_size(XrObject *object) {
+    switch (object->type) {
+        case XR_TFUNCTION: {
+            XrClosure *closure = (XrClosure*)object;
+            return sizeof(XrClosure) + sizeof(XrUpvalue*) * closure->upvalue_count;
+        }
+        case XR_TARRAY: {
+            XrArray *array = (XrArray*)object;
+            /* 共享存储由持有它的数组分摊，这里不重复计算 */
+            return sizeof(XrArray) +
+                   (array->shared != NULL ? 0 : sizeof(XrValue) * array->capacity);
+        }
+        case XR_TMAP: {
+            XrMap *map = (XrMap*)object;
+            return sizeof(XrMap) +
+                   sizeof(XrMapEntry) * map->usable +
+                   (size_t)map->capacity * (map->index_width + 1) +
+                   sizeof(XrValue) * map->array_capacity;
+        }
+        case XR_TCLASS: {
+            XrClass *cls = (XrClass*)object;
+            return sizeof(XrClass) +
+                   sizeof(XrMethod*) * cls->method_count +
+                   (sizeof(char*) + sizeof(XrTypeInfo*)) * cls->field_count;
+        }
+        case XR_TINSTANCE: {
+            XrInstance *inst = (XrInstance*)object;
+            return sizeof(XrInstance) + sizeof(XrValue) * inst->klass->field_count;
+        }
+        default:
+            return sizeof(XrObject);
+    }
+}
+
+/*
+** 登记值对象（进入年轻代）
+*/
+void xr_bc_gc_track(VM *vm, XrObject *object) {
+    object->marked = false;
+    object->next = vm->young[0];
+    vm->young[0] = object;
+    vm->young_bytes += object_size(object);
+    if (vm->gc_phase == GC_MARK) {
+        mark_object(vm, object);
+    }
+}
+
+/*
+** 登记upvalue
+*/
+void xr_bc_gc_track_upvalue(VM *vm, XrUpvalue *upvalue) {
+    upvalue->header.marked = false;
+    upvalue->header.next = vm->upvalues;
+    vm->upvalues = (XrObject*)upvalue;
+    vm->bytes_allocated += sizeof(XrUpvalue);
+    if (vm->gc_phase == GC_MARK) {
+        mark_upvalue(vm, upvalue);
+    }
+}
+
+/*
+** 登记方法对象
+*/
+void xr_bc_gc_track_method(VM *vm, XrMethod *method) {
+    method->header.marked = false;
+    method->header.next = vm->methods;
+    vm->methods = (XrObject*)method;
+    vm->bytes_allocated += sizeof(XrMethod);
+    if (vm->gc_phase == GC_MARK) {
+        mark_method(vm, method);
+    }
+}
+
+/* ========== 标记 ========== */
+
+/*
+** 对象数组扩容（标记栈和记忆集共用）
+*/
+static XrObject **grow_objects(XrObject **array, int *capacity) {
+    int new_capacity = *capacity < GRAY_INIT_CAPACITY
+                     ? GRAY_INIT_CAPACITY : *capacity * 2;
+    array = (XrObject**)xmem_realloc(
+        array,
+        sizeof(XrObject*) * (*capacity),
+        sizeof(XrObject*) * new_capacity
+    );
+    *capacity = new_capacity;
+    return array;
+}
+
+/*
+** 压入标记栈（对象变为灰色）
+*/
+static void push_gray(VM *vm, XrObject *object) {
+    if (vm->gray_count == vm->gray_capacity) {
+        vm->gray = grow_objects(vm->gray, &vm->gray_capacity);
+    }
+    vm->gray[vm->gray_count++] = object;
+}
+
+/*
+** 标记对象并压入标记栈，之后由trace_object扫描它的引用
+*/
+static void mark_object(VM *vm, XrObject *object) {
+    if (object == NULL || object->marked) return;
+    object->marked = true;
+    push_gray(vm, object);
+}
+
+/*
+** 标记值（字符串只置标记位；切片字符串连同父串，父串没有引用）
+*/
+static void mark_value(VM *vm, XrValue value) {
+    if (xr_isnull(value) || xr_isbool(value) ||
+        xr_isint(value) || xr_isfloat(value)) {
+        return;
+    }
+    if (xr_isstring(value)) {
+        XrString *str = xr_tostring(value);
+        str->header.marked = true;
+        if (xr_string_is_slice(str)) {
+            xr_string_ref(str)->parent->header.marked = true;
+        }
+        return;
+    }
+    mark_object(vm, (XrObject*)xr_toobj(value));
+}
+
+/*
+** 标记函数原型的常量和嵌套原型
+** 同一个Proto可能被很多闭包引用，用轮次号保证每轮只扫描一次
+*/
+static void mark_proto(VM *vm, Proto *proto) {
+    if (proto == NULL || proto->gc_epoch == vm->gc_epoch) return;
+    proto->gc_epoch = vm->gc_epoch;
+    
+    if (proto->name != NULL) {
+        proto->name->header.marked = true;
+    }
+    for (int i = 0; i < proto->constants.count; i++) {
+        mark_value(vm, proto->constants.values[i]);
+    }
+    
+    /* 嵌套原型之后可能被OP_CLOSURE实例化，常量必须保留 */
+    for (int i = 0; i < proto->sizeprotos; i++) {
+        mark_proto(vm, proto->protos[i]);
+    }
+}
+
+/*
+** 标记upvalue（不入标记栈，完整GC开始时按链表复位）
+*/
+static void mark_upvalue(VM *vm, XrUpvalue *upvalue) {
+    if (upvalue == NULL || upvalue->header.marked) return;
+    upvalue->header.marked = true;
+    mark_value(vm, *upvalue->location);
+}
+
+/*
+** 标记方法（不入标记栈，完整GC开始时按链表复位）
+*/
+static void mark_method(VM *vm, XrMethod *method) {
+    if (method == NULL || method->header.marked) return;
+    method->header.marked = true;
+    
+    /* 方法的func实际是Proto* */
+    mark_proto(vm, (Proto*)method->func);
+}
+
+/*
+** WeakMap键的存活判定（非对象键和字符串键不会失效）
+*/
+static bool weak_key_alive(XrValue key, void *ud) {
+    (void)ud;
+    if (xr_isnull(key) || xr_isbool(key) ||
+        xr_isint(key) || xr_isfloat(key) || xr_isstring(key)) {
+        return true;
+    }
+    XrObject *object = (XrObject*)xr_toobj(key);
+    return object == NULL || object->marked;
+}
+
+/*
+** 扫描对象的引用
+** minor GC不清理WeakMap，键一律当作强引用，留到完整GC再判定
+*/
+static void trace_object(VM *vm, XrObject *object, bool minor) {
+    switch (object->type) {
+        case XR_TFUNCTION: {
+            XrClosure *closure = (XrClosure*)object;
+            mark_proto(vm, closure->proto);
+            for (int i = 0; i < closure->upvalue_count; i++) {
+                mark_upvalue(vm, closure->upvalues[i]);
+            }
+            break;
+        }
+        case XR_TARRAY: {
+            XrArray *array = (XrArray*)object;
+            for (size_t i = 0; i < array->count; i++) {
+                mark_value(vm, array->elements[i]);
+            }
+            break;
+        }
+        case XR_TMAP: {
+            /* WeakMap不标记对象键，键的存活由其他引用决定；
+            ** 字符串按值比较，当作普通键（同Lua）。
+            ** 值按ephemeron处理：键尚未标记时先不标记值，
+            ** 否则引用自身键的值会让键永远存活，由finish_mark补标记 */
+            XrMap *map = (XrMap*)object;
+            bool weak = !minor && xr_map_is_weak(map);
+            uint32_t cursor = 0;
+            XrValue key, value;
+            while (xr_map_next(map, &cursor, &key, &value)) {
+                if (weak && !weak_key_alive(key, NULL)) {
+                    continue;
+                }
+                if (!weak || xr_isstring(key)) {
+                    mark_value(vm, key);
+                }
+                mark_value(vm, value);
+            }
+            break;
+        }
+        case XR_TCLASS: {
+            XrClass *cls = (XrClass*)object;
+            mark_object(vm, (XrObject*)cls->super);
+            for (int i = 0; i < cls->method_count; i++) {
+                mark_method(vm, cls->methods[i]);
+            }
+            break;
+        }
+        case XR_TINSTANCE: {
+            XrInstance *inst = (XrInstance*)object;
+            mark_object(vm, (XrObject*)inst->klass);
+            for (int i = 0; i < inst->klass->field_count; i++) {
+                mark_value(vm, inst->fields[i]);
+            }
+            break;
+        }
+        default:
+            /* C函数等没有引用 */
+            break;
+    }
+}
+
+/*
+** 寄存器栈的活动区上界：所有调用帧寄存器窗口的最高处
+*/
+static XrValue *stack_live_top(VM *vm) {
+    XrValue *top = vm->stack_top;
+    for (int i = 0; i < vm->frame_count; i++) {
+        BcCallFrame *frame = &vm->frames[i];
+        XrValue *frame_top = frame->base + frame->closure->proto->maxstacksize;
+        if (frame_top > top) {
+            top = frame_top;
+        }
+    }
+    if (top > vm->stack + STACK_MAX) {
+        top = vm->stack + STACK_MAX;
+    }
+    return top;
+}
+
+/*
+** 标记根
+*/
+static void mark_roots(VM *vm) {
+    /* 寄存器栈 */
+    XrValue *top = stack_live_top(vm);
+    for (XrValue *slot = vm->stack; slot < top; slot++) {
+        mark_value(vm, *slot);
+    }
+    
+    /* 活动区以上的旧值清空：之后的调用帧会把这些寄存器
+    ** 当作根，而它们引用的对象本轮可能已被释放 */
+    for (XrValue *slot = top; slot < vm->stack + STACK_MAX; slot++) {
+        *slot = xr_null();
+    }
+    
+    /* 调用帧 */
+    for (int i = 0; i < vm->frame_count; i++) {
+        mark_object(vm, (XrObject*)vm->frames[i].closure);
+    }
+    
+    /* 全局变量 */
+    for (int i = 0; i < 256; i++) {
+        mark_value(vm, vm->globals_array[i]);
+    }
+    
+    /* 开放upvalue */
+    for (XrUpvalue *upvalue = vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
+        mark_upvalue(vm, upvalue);
+    }
+}
+
+/*
+** 追踪标记栈中from之后的对象（扫描过程中标记栈会继续增长）
+*/
+static void trace_gray(VM *vm, int from, bool minor) {
+    for (int i = from; i < vm->gray_count; i++) {
+        trace_object(vm, vm->gray[i], minor);
+    }
+}
+
+/* ========== 记忆集 ========== */
+
+/*
+** 在记忆集散列中查找对象：返回它所在的槽位，或应插入的空槽位
+** 散列容量是记忆集容量的2倍，总有空槽
+*/
+static int *remembered_slot(VM *vm, XrObject *object) {
+    uint32_t mask = (uint32_t)vm->remembered_index_capacity - 1;
+    uint32_t i = xr_hash_pointer(object) & mask;
+    while (vm->remembered_index[i] != 0 &&
+           vm->remembered[vm->remembered_index[i] - 1] != object) {
+        i = (i + 1) & mask;
+    }
+    return &vm->remembered_index[i];
+}
+
+/*
+** 按记忆集的当前内容重建散列（记忆集被过滤或清空之后）
+*/
+static void remembered_reindex(VM *vm) {
+    if (vm->remembered_index == NULL) return;
+    memset(vm->remembered_index, 0, sizeof(int) * vm->remembered_index_capacity);
+    for (int i = 0; i < vm->remembered_count; i++) {
+        *remembered_slot(vm, vm->remembered[i]) = i + 1;
+    }
+}
+
+/*
+** 把老对象记入记忆集，已在其中的不再重复记入
+** C函数调用后每个老参数都会经过这里，只和上一项比较挡不住A,B,A,B…交替
+*/
+void xr_bc_gc_remember(VM *vm, XrObject *object) {
+    if (vm->gc_phase == GC_MARK) {
+        push_gray(vm, object);
+        return;
+    }
+    if (vm->remembered_count == vm->remembered_capacity) {
+        int old_capacity = vm->remembered_index_capacity;
+        vm->remembered = grow_objects(vm->remembered, &vm->remembered_capacity);
+        vm->remembered_index_capacity = vm->remembered_capacity * 2;
+        vm->remembered_index = (int*)xmem_realloc(
+            vm->remembered_index,
+            sizeof(int) * old_capacity,
+            sizeof(int) * vm->remembered_index_capacity
+        );
+        remembered_reindex(vm);
+    }
+    
+    int *slot = remembered_slot(vm, object);
+    if (*slot != 0) return;
+    vm->remembered[vm->remembered_count++] = object;
+    *slot = vm->remembered_count;
+}
+
+/*
+** 写屏障的慢速路径
+*/
+void xr_bc_gc_barrier_slow(VM *vm, XrObject *target, XrValue value) {
+    if (vm->gc_phase == GC_MARK) {
+        mark_value(vm, value);
+    } else {
+        xr_bc_gc_remember(vm, target);
+    }
+}
+
+/*
+** 对象是否直接引用年轻对象（minor GC之后决定是否留在记忆集）
+** 闭包不用检查：它的upvalue在minor GC中都当作根
+*/
+static bool has_young_child(XrObject *object) {
+    switch (object->type) {
+        case XR_TARRAY: {
+            XrArray *array = (XrArray*)object;
+            for (size_t i = 0; i < array->count; i++) {
+                if (xr_bc_gc_is_young(array->elements[i])) return true;
+            }
+            return false;
+        }
+        case XR_TMAP: {
+            XrMap *map = (XrMap*)object;
+            uint32_t cursor = 0;
+            XrValue key, value;
+            while (xr_map_next(map, &cursor, &key, &value)) {
+                if (xr_bc_gc_is_young(key) || xr_bc_gc_is_young(value)) return true;
+            }
+            return false;
+        }
+        case XR_TCLASS: {
+            XrClass *cls = (XrClass*)object;
+            return cls->super != NULL && !cls->super->header.marked;
+        }
+        case XR_TINSTANCE: {
+            XrInstance *inst = (XrInstance*)object;
+            if (!inst->klass->header.marked) return true;
+            for (int i = 0; i < inst->klass->field_count; i++) {
+                if (xr_bc_gc_is_young(inst->fields[i])) return true;
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
+/* ========== 清除 ========== */
+
+/*
+** 字符串存活判定（标记保留，存活的字符串成为老年代）
+*/
+static bool string_alive(XrString *str, void *ud) {
+    (void)ud;
+    return str->header.marked;
+}
+
+/*
+** 清扫值对象链表，存活者移入老年代链表
+** 返回释放数量，存活字节数累加到live
+*/
+static size_t sweep_objects(VM *vm, XrObject *object, size_t *live) {
+    size_t freed = 0;
+    while (object != NULL) {
+        XrObject *next = object->next;
+        if (object->marked) {
+            *live += object_size(object);
+            object->next = vm->objects;
+            vm->objects = object;
+        } else {
+            free_object(object);
+            freed++;
+        }
+        object = next;
+    }
+    return freed;
+}
+
+/*
+** 清扫年轻代链表：到龄的存活者晋升（保留标记），
+** 其余存活者年龄加一并清除标记
+*/
+static size_t sweep_young(VM *vm) {
+    size_t freed = 0;
+    vm->young_bytes = 0;
+    
+    /* 从最老的一级开始，移入下一级的对象不会被重复处理 */
+    for (int age = GC_PROMOTE_AGE - 1; age >= 0; age--) {
+        XrObject *object = vm->young[age];
+        vm->young[age] = NULL;
+        while (object != NULL) {
+            XrObject *next = object->next;
+            if (!object->marked) {
+                free_object(object);
+                freed++;
+            } else if (age + 1 == GC_PROMOTE_AGE) {
+                vm->bytes_allocated += object_size(object);
+                object->next = vm->objects;
+                vm->objects = object;
+            } else {
+                object->marked = false;
+                vm->young_bytes += object_size(object);
+                object->next = vm->young[age + 1];
+                vm->young[age + 1] = object;
+            }
+            object = next;
+        }
+    }
+    return freed;
+}
+
+/*
+** 清扫upvalue链表（存活者保留标记）
+*/
+static size_t sweep_upvalues(VM *vm, size_t *live) {
+    size_t freed = 0;
+    XrObject **link = &vm->upvalues;
+    while (*link != NULL) {
+        XrObject *object = *link;
+        if (object->marked) {
+            *live += sizeof(XrUpvalue);
+            link = &object->next;
+        } else {
+            *link = object->next;
+            xr_bc_upvalue_free((XrUpvalue*)object);
+            freed++;
+        }
+    }
+    return freed;
+}
+
+/*
+** 清扫方法链表（存活者保留标记）
+*/
+static size_t sweep_methods(VM *vm, size_t *live) {
+    size_t freed = 0;
+    XrObject **link = &vm->methods;
+    while (*link != NULL) {
+        XrObject *object = *link;
+        if (object->marked) {
+            *live += sizeof(XrMethod);
+            link = &object->next;
+        } else {
+            *link = object->next;
+            xr_method_free((XrMethod*)object);
+            freed++;
+        }
+    }
+    return freed;
+}
+
+/* ========== 回收 ========== */
+
+/*
+** 清除全部标记（完整GC之前）：老年代对象、upvalue、方法、字符串
+** 年轻对象在GC之间总是未标记的
+*/
+static void clear_marks(VM *vm) {
+    for (int i = 0; i < vm->gray_count; i++) {
+        vm->gray[i]->marked = false;
+    }
+    vm->gray_count = 0;
+    vm->gray_scan = 0;
+    
+    for (XrObject *object = vm->upvalues; object != NULL; object = object->next) {
+        object->marked = false;
+    }
+    for (XrObject *object = vm->methods; object != NULL; object = object->next) {
+        object->marked = false;
+    }
+    xr_string_pool_clear_marks();
+}
+
+/*
+** 一次GC结束时记下字符串池的状态，之后新增的都是年轻字符串
+*/
+static void finish_cycle(VM *vm) {
+    vm->old_strings = vm->strings.long_strings;
+    vm->string_bytes = vm->strings.bytes;
+    vm->next_step = GC_NURSERY_SIZE;
+}
+
+/*
+** 老年代是否超过了完整GC阈值
+*/
+static bool old_generation_full(VM *vm) {
+    return vm->bytes_allocated + vm->strings.bytes > vm->next_gc;
+}
+
+/*
+** 开始完整GC：清除标记，标记根，进入增量标记阶段
+*/
+static void begin_mark(VM *vm) {
+    vm->gc_epoch++;
+    vm->gc_full_count++;
+    
+    /* 记忆集只对分代有意义，标记结束后所有存活者都是老对象 */
+    clear_marks(vm);
+    vm->remembered_count = 0;
+    remembered_reindex(vm);
+    
+    mark_roots(vm);
+    vm->gc_phase = GC_MARK;
+    vm->gc_backedges = 0;
+}
+
+/*
+** 追踪至多budget个灰色对象，返回标记栈是否已追踪完
+*/
+static bool mark_some(VM *vm, int budget) {
+    while (budget > 0 && vm->gray_scan < vm->gray_count) {
+        trace_object(vm, vm->gray[vm->gray_scan++], false);
+        budget--;
+    }
+    return vm->gray_scan == vm->gray_count;
+}
+
+/*
+** 标记WeakMap中键已存活的条目的值，返回是否有新对象进入标记栈
+** 值可能让别的WeakMap键存活，finish_mark反复调用直到不动点
+*/
+static bool mark_ephemerons(VM *vm) {
+    int gray_before = vm->gray_count;
+    for (int i = 0; i < gray_before; i++) {
+        XrObject *object = vm->gray[i];
+        if (object->type != XR_TMAP || !xr_map_is_weak((XrMap*)object)) {
+            continue;
+        }
+        uint32_t cursor = 0;
+        XrValue key, value;
+        while (xr_map_next((XrMap*)object, &cursor, &key, &value)) {
+            if (weak_key_alive(key, NULL)) {
+                mark_value(vm, value);
+            }
+        }
+    }
+    return vm->gray_count > gray_before;
+}
+
+/*
+** 结束完整GC（原子阶段）：补标记，清理WeakMap，清扫
+*/
+static size_t finish_mark(VM *vm) {
+    /* 1. 根和upvalue的写入没有屏障，重新扫描后追踪完 */
+    mark_roots(vm);
+    for (XrObject *object = vm->upvalues; object != NULL; object = object->next) {
+        if (object->marked) {
+            mark_value(vm, *((XrUpvalue*)object)->location);
+        }
+    }
+    do {
+        while (!mark_some(vm, GC_STEP_BATCH)) {
+            /* 追踪过程中标记栈继续增长 */
+        }
+    } while (mark_ephemerons(vm));
+    vm->gc_phase = GC_PAUSE;
+    
+    /* 2. WeakMap要在键对象释放之前判定 */
+    for (int i = 0; i < vm->gray_count; i++) {
+        XrObject *object = vm->gray[i];
+        if (object->type == XR_TMAP && xr_map_is_weak((XrMap*)object)) {
+            xr_map_sweep_weak((XrMap*)object, weak_key_alive, NULL);
+        }
+    }
+    
+    /* 3. 清扫：存活者保留标记，全部成为老年代 */
+    size_t live = 0;
+    XrObject *objects = vm->objects;
+    vm->objects = NULL;
+    size_t freed = sweep_objects(vm, objects, &live);
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        freed += sweep_objects(vm, vm->young[age], &live);
+        vm->young[age] = NULL;
+    }
+    freed += sweep_upvalues(vm, &live);
+    freed += sweep_methods(vm, &live);
+    freed += xr_string_pool_sweep(string_alive, NULL);
+    
+    finish_cycle(vm);
+    
+    vm->young_bytes = 0;
+    vm->bytes_allocated = live;
+    vm->next_gc = (live + vm->strings.bytes) * GC_HEAP_GROW_FACTOR;
+    if (vm->next_gc < GC_MIN_HEAP) {
+        vm->next_gc = GC_MIN_HEAP;
+    }
+    
+    return freed;
+}
+
+/*
+** 当前时间（微秒）：停顿预算和统计都按单调的墙钟计算
+** clock()是进程CPU时间，粒度也比1ms的停顿目标粗，只在没有单调时钟时退用
+*/
+static double gc_now_us(void) {
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#else
+    return (double)clock() * 1000000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+/*
+** 增量标记一步：直到标记栈追踪完或超出停顿目标
+** 压力测试模式下每步只追踪一个对象
+*/
+static void mark_step(VM *vm, double start) {
+    double limit = start + vm->gc_pause_target_us;
+    int budget = vm->gc_stress ? 1 : GC_STEP_BATCH;
+    
+    while (!mark_some(vm, budget)) {
+        if (vm->gc_stress || gc_now_us() >= limit) {
+            vm->next_step = xr_bc_gc_young_bytes(vm) + GC_STEP_SIZE;
+            return;
+        }
+    }
+    finish_mark(vm);
+}
+
+/*
+** minor GC
+*/
+static size_t collect_young(VM *vm) {
+    vm->gc_epoch++;
+    
+    /* 1. 标记：标记栈前部是老年代对象，新标记的从base开始 */
+    int base = vm->gray_count;
+    mark_roots(vm);
+    for (XrObject *object = vm->upvalues; object != NULL; object = object->next) {
+        mark_value(vm, *((XrUpvalue*)object)->location);
+    }
+    for (int i = 0; i < vm->remembered_count; i++) {
+        trace_object(vm, vm->remembered[i], true);
+    }
+    trace_gray(vm, base, true);
+    
+    /* 2. 清扫年轻代，驻留字符串留给完整GC */
+    size_t freed = sweep_young(vm);
+    freed += xr_string_pool_sweep_since(vm->old_strings, string_alive, NULL);
+    finish_cycle(vm);
+    
+    /* 3. 重建记忆集：老对象和晋升对象可能仍引用年轻对象 */
+    int remembered = 0;
+    for (int i = 0; i < vm->remembered_count; i++) {
+        if (has_young_child(vm->remembered[i])) {
+            vm->remembered[remembered++] = vm->remembered[i];
+        }
+    }
+    vm->remembered_count = remembered;
+    remembered_reindex(vm);
+    
+    /* 标记栈只保留仍带标记的（晋升和未登记的）对象 */
+    int old_count = base;
+    for (int i = base; i < vm->gray_count; i++) {
+        XrObject *object = vm->gray[i];
+        if (!object->marked) continue;
+        vm->gray[old_count++] = object;
+        if (has_young_child(object)) {
+            xr_bc_gc_remember(vm, object);
+        }
+    }
+    vm->gray_count = old_count;
+    
+    return freed;
+}
+
+/*
+** 记录一次停顿
+*/
+static void record_pause(VM *vm, double start) {
+    double us = gc_now_us() - start;
+    GcPauseStats *stats = &vm->gc_pauses;
+    
+    int bucket = 0;
+    for (double bound = 1.0; us >= bound && bucket < GC_PAUSE_BUCKETS - 1; bound *= 2) {
+        bucket++;
+    }
+    stats->histogram[bucket]++;
+    stats->count++;
+    stats->total_us += us;
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+}
+
+/*
+** GC期间切换到本VM的字符串池和slab：清扫释放的字符串和对象都属于它们
+*/
+typedef struct {
+    StringPool *pool;
+    XrSlab *slab;
+} GcScope;
+
+static GcScope gc_enter(VM *vm) {
+    GcScope scope = { xr_string_pool_current(), xr_slab_current() };
+    xr_string_pool_use(&vm->strings);
+    xr_slab_use(&vm->slab);
+    return scope;
+}
+
+static void gc_leave(GcScope scope) {
+    xr_string_pool_use(scope.pool);
+    xr_slab_use(scope.slab);
+}
+
+/*
+** 执行一次完整的标记-清除
+*/
+size_t xr_bc_gc_collect(VM *vm) {
+    if (vm->region.active) return 0;
+    
+    double start = gc_now_us();
+    GcScope scope = gc_enter(vm);
+    
+    if (vm->gc_phase != GC_MARK) {
+        begin_mark(vm);
+    }
+    size_t freed = finish_mark(vm);
+    
+    gc_leave(scope);
+    record_pause(vm, start);
+    return freed;
+}
+
+/*
+** 执行一次minor GC
+*/
+size_t xr_bc_gc_collect_young(VM *vm) {
+    if (vm->region.active) return 0;
+    if (vm->gc_phase == GC_MARK) {
+        return xr_bc_gc_collect(vm);
+    }
+    
+    double start = gc_now_us();
+    GcScope scope = gc_enter(vm);
+    
+    size_t freed = collect_young(vm);
+    
+    gc_leave(scope);
+    record_pause(vm, start);
+    return freed;
+}
+
+/*
+** 安全点触发的一步GC
+*/
+void xr_bc_gc_step(VM *vm) {
+    if (vm->region.active) return;
+    
+    double start = gc_now_us();
+    GcScope scope = gc_enter(vm);
+    
+    if (vm->gc_phase == GC_MARK) {
+        mark_step(vm, start);
+    } else if (old_generation_full(vm) ||
+               (vm->gc_stress && (vm->gc_epoch + 1) % GC_STRESS_FULL_INTERVAL == 0)) {
+        begin_mark(vm);
+        mark_step(vm, start);
+    } else {
+        collect_young(vm);
+        
+        /* 晋升使老年代超过阈值：下一个安全点开始完整GC */
+        if (old_generation_full(vm)) {
+            vm->next_step = 0;
+        }
+    }
+    
+    gc_leave(scope);
+    record_pause(vm, start);
+}
+
+/* ========== 区域模式 ========== */
+
+/*
+** 打开区域
+*/
+void xr_bc_region_begin(VM *vm, Proto *proto) {
+    XrRegion *region = &vm->region;
+    if (region->active) {
+        xr_bc_region_reset(vm);
+    }
+    
+    /* 1. 区域期间不能有进行中的标记：新对象会被置灰，重置后留下悬空指针
+    ** 导出的副本只在这里按阈值做完整GC；顶层proto还没有闭包引用，
+    ** 它的常量要先标记上 */
+    if (vm->gc_phase == GC_MARK || old_generation_full(vm)) {
+        double start = gc_now_us();
+        GcScope scope = gc_enter(vm);
+        if (vm->gc_phase != GC_MARK) {
+            begin_mark(vm);
+        }
+        mark_proto(vm, proto);
+        finish_mark(vm);
+        gc_leave(scope);
+        record_pause(vm, start);
+    }
+    
+    /* 2. 年轻对象直接晋升：执行前的对象都带标记，区域值写进去才会进入记忆集
+    ** 它们可能引用年轻字符串，先记入记忆集 */
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        XrObject *object = vm->young[age];
+        vm->young[age] = NULL;
+        while (object != NULL) {
+            XrObject *next = object->next;
+            object->marked = true;
+            vm->bytes_allocated += object_size(object);
+            object->next = vm->objects;
+            vm->objects = object;
+            push_gray(vm, object);
+            xr_bc_gc_remember(vm, object);
+            object = next;
+        }
+    }
+    vm->young_bytes = 0;
+    
+    /* 3. 换上空链表、区域的slab和字符串池 */
+    region->upvalues = vm->upvalues;
+    region->methods = vm->methods;
+    region->bytes_allocated = vm->bytes_allocated;
+    vm->upvalues = NULL;
+    vm->methods = NULL;
+    region->exported = NULL;
+    region->exported_bytes = 0;
+    
+    xr_slab_init(&region->slab);
+    memset(&region->strings, 0, sizeof(region->strings));
+    xr_slab_use(&region->slab);
+    xr_string_pool_use(&region->strings);
+    region->active = true;
+}
+
+/*
+** 索引的槽位（指针至少按16字节对齐，低位不参与哈希）
+*/
+static size_t region_index_slot(const void *ptr, size_t mask) {
+    uint64_t h = (uint64_t)((uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & mask;
+}
+
+/*
+** 查找索引中的对象，返回它的值槽（没有时返回NULL）
+*/
+static void **region_index_find(XrRegion *region, const void *ptr) {
+    if (region->index_count == 0) return NULL;
+    
+    size_t mask = region->index_capacity - 1;
+    size_t slot = region_index_slot(ptr, mask);
+    while (region->index_keys[slot] != NULL) {
+        if (region->index_keys[slot] == ptr) {
+            return &region->index_values[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+/*
+** 加入索引（负载因子不超过0.5，建立时已按数量分配好容量）
+*/
+static void region_index_insert(XrRegion *region, void *ptr) {
+    size_t mask = region->index_capacity - 1;
+    size_t slot = region_index_slot(ptr, mask);
+    while (region->index_keys[slot] != NULL) {
+        slot = (slot + 1) & mask;
+    }
+    region->index_keys[slot] = ptr;
+    region->index_values[slot] = NULL;
+    region->index_count++;
+}
+
+/*
+** 区域对象是否需要加入索引：slab中的直接按页判定
+*/
+static bool region_needs_index(XrRegion *region, const void *ptr) {
+    return !xr_slab_owns(&region->slab, ptr);
+}
+
+/*
+** 建立索引：执行结束后区域不再增长，只建一次
+*/
+static void region_build_index(VM *vm) {
+    XrRegion *region = &vm->region;
+    if (region->index_capacity != 0) return;
+    
+    size_t count = 0;
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        for (XrObject *object = vm->young[age]; object != NULL; object = object->next) {
+            if (region_needs_index(region, object)) count++;
+        }
+    }
+    StringPool *pool = &region->strings;
+    for (XrString *str = pool->long_strings; str != NULL; str = (XrString*)str->header.next) {
+        if (region_needs_index(region, str)) count++;
+    }
+    for (size_t i = 0; i < pool->capacity; i++) {
+        if (pool->entries[i] != NULL && region_needs_index(region, pool->entries[i])) count++;
+    }
+    
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    region->index_keys = (void**)xmem_alloc(sizeof(void*) * capacity);
+    region->index_values = (void**)xmem_alloc(sizeof(void*) * capacity);
+    memset(region->index_keys, 0, sizeof(void*) * capacity);
+    region->index_capacity = capacity;
+    region->index_count = 0;
+    
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        for (XrObject *object = vm->young[age]; object != NULL; object = object->next) {
+            if (region_needs_index(region, object)) region_index_insert(region, object);
+        }
+    }
+    for (XrString *str = pool->long_strings; str != NULL; str = (XrString*)str->header.next) {
+        if (region_needs_index(region, str)) region_index_insert(region, str);
+    }
+    for (size_t i = 0; i < pool->capacity; i++) {
+        if (pool->entries[i] != NULL && region_needs_index(region, pool->entries[i])) {
+            region_index_insert(region, pool->entries[i]);
+        }
+    }
+}
+
+/*
+** 指针是否属于区域
+*/
+static bool region_owns(XrRegion *region, const void *ptr) {
+    return xr_slab_owns(&region->slab, ptr) || region_index_find(region, ptr) != NULL;
+}
+
+/*
+** 值是否引用区域中的字符串或对象
+*/
+static bool region_holds(XrRegion *region, XrValue value) {
+    if (xr_isnull(value) || xr_isbool(value) ||
+        xr_isint(value) || xr_isfloat(value)) {
+        return false;
+    }
+    if (xr_isstring(value)) {
+        return region_owns(region, xr_tostring(value));
+    }
+    void *object = xr_toobj(value);
+    return object != NULL && region_owns(region, object);
+}
+
+/*
+** 导出的副本进入VM的年轻代（重置之前先挂在区域上）
+*/
+static void region_track_export(VM *vm, XrObject *object) {
+    object->marked = false;
+    object->next = vm->region.exported;
+    vm->region.exported = object;
+    vm->region.exported_bytes += object_size(object);
+}
+
+/*
+** 导出一个值（调用者已切换到VM的slab和字符串池）
+** 副本先记入索引再复制内容，环和共享的子对象只复制一次
+*/
+static XrValue region_export(VM *vm, XrValue value) {
+    XrRegion *region = &vm->region;
+    if (!region_holds(region, value)) {
+        return value;
+    }
+    if (xr_isstring(value)) {
+        XrString *str = xr_tostring(value);
+        return xr_string_value(xr_string_make(xr_string_data(str), str->length));
+    }
+    
+    XrObject *object = (XrObject*)xr_toobj(value);
+    void **copy = region_index_find(region, object);
+    if (copy != NULL && *copy != NULL) {
+        return object->type == XR_TARRAY ? xr_value_from_array((XrArray*)*copy)
+                                         : xr_value_from_map((XrMap*)*copy);
+    }
+    void *unused = NULL;
+    if (copy == NULL) {
+        copy = &unused;  /* 在slab中的对象不进索引，不做去重 */
+    }
+    
+    switch (object->type) {
+        case XR_TARRAY: {
+            XrArray *array = (XrArray*)object;
+            XrArray *result = xr_array_with_capacity((int)array->count);
+            result->element_type = array->element_type;
+            *copy = result;
+            for (size_t i = 0; i < array->count; i++) {
+                xr_array_push(result, region_export(vm, array->elements[i]));
+            }
+            region_track_export(vm, (XrObject*)result);
+            return xr_value_from_array(result);
+        }
+        case XR_TMAP: {
+            XrMap *map = (XrMap*)object;
+            XrMap *result = xr_map_is_weak(map) ? xr_map_new_weak() : xr_map_new();
+            *copy = result;
+            uint32_t cursor = 0;
+            XrValue key, item;
+            while (xr_map_next(map, &cursor, &key, &item)) {
+                XrValue exported = region_export(vm, key);
+                if (!xr_isnull(exported)) {
+                    xr_map_set(result, exported, region_export(vm, item));
+                }
+            }
+            region_track_export(vm, (XrObject*)result);
+            return xr_value_from_map(result);
+        }
+        default:
+            /* 闭包、类、实例的代码和布局都属于这次执行 */
+            return xr_null();
+    }
+}
+
+/*
+** 导出区域中的值
+*/
+XrValue xr_bc_region_export(VM *vm, XrValue value) {
+    if (!vm->region.active) {
+        return value;
+    }
+    region_build_index(vm);
+    
+    GcScope scope = gc_enter(vm);
+    XrValue result = region_export(vm, value);
+    gc_leave(scope);
+    return result;
+}
+
+/*
+** 把执行前就有的对象中引用区域的值换成导出的副本
+*/
+static void region_detach_object(VM *vm, XrObject *object) {
+    XrRegion *region = &vm->region;
+    switch (object->type) {
+        case XR_TARRAY: {
+            XrArray *array = (XrArray*)object;
+            for (size_t i = 0; i < array->count; i++) {
+                if (region_holds(region, array->elements[i])) {
+                    xr_array_set(array, (int)i, region_export(vm, array->elements[i]));
+                }
+            }
+            break;
+        }
+        case XR_TMAP: {
+            /* 键可能也在区域里：先收集，遍历结束后再删除和重新插入 */
+            XrMap *map = (XrMap*)object;
+            XrValue *pairs = NULL;
+            int count = 0;
+            int capacity = 0;
+            uint32_t cursor = 0;
+            XrValue key, value;
+            while (xr_map_next(map, &cursor, &key, &value)) {
+                if (!region_holds(region, key) && !region_holds(region, value)) continue;
+                if (count + 2 > capacity) {
+                    int new_capacity = capacity == 0 ? 16 : capacity * 2;
+                    pairs = (XrValue*)xmem_realloc(pairs, sizeof(XrValue) * capacity,
+                                                   sizeof(XrValue) * new_capacity);
+                    capacity = new_capacity;
+                }
+                pairs[count++] = key;
+                pairs[count++] = value;
+            }
+            for (int i = 0; i < count; i += 2) {
+                XrValue exported = pairs[i];
+                if (region_holds(region, pairs[i])) {
+                    xr_map_delete(map, pairs[i]);
+                    exported = region_export(vm, pairs[i]);
+                }
+                if (!xr_isnull(exported)) {
+                    xr_map_set(map, exported, region_export(vm, pairs[i + 1]));
+                }
+            }
+            if (pairs != NULL) {
+                xmem_free(pairs);
+            }
+            break;
+        }
+        case XR_TINSTANCE: {
+            XrInstance *inst = (XrInstance*)object;
+            for (int i = 0; i < inst->klass->field_count; i++) {
+                inst->fields[i] = region_export(vm, inst->fields[i]);
+            }
+            break;
+        }
+        default:
+            /* 闭包经由upvalue引用值，类不会被脚本改写 */
+            break;
+    }
+}
+
+/*
+** 区域对象是否另外持有xmem内存，需要逐个释放
+** slab中的闭包只有upvalue数组可能超出slab的尺寸级
+*/
+static bool region_needs_free(XrRegion *region, XrObject *object) {
+    if (!xr_slab_owns(&region->slab, object)) return true;
+    if (object->type == XR_TFUNCTION) {
+        XrClosure *closure = (XrClosure*)object;
+        return closure->upvalues != NULL &&
+               !xr_slab_owns(&region->slab, closure->upvalues);
+    }
+    return false;
+}
+
+/*
+** 重置区域
+*/
+void xr_bc_region_reset(VM *vm) {
+    XrRegion *region = &vm->region;
+    if (!region->active) return;
+    region_build_index(vm);
+    
+    /* 1. 导出仍被VM之外的状态引用的区域值 */
+    GcScope scope = gc_enter(vm);
+    for (int i = 0; i < 256; i++) {
+        vm->globals_array[i] = region_export(vm, vm->globals_array[i]);
+    }
+    for (int i = 0; i < vm->remembered_count; i++) {
+        region_detach_object(vm, vm->remembered[i]);
+    }
+    for (XrObject *object = region->upvalues; object != NULL; object = object->next) {
+        XrUpvalue *upvalue = (XrUpvalue*)object;
+        if (upvalue->location == &upvalue->closed) {
+            upvalue->closed = region_export(vm, upvalue->closed);
+        }
+    }
+    
+    /* 2. 释放持有xmem内存的区域对象和字符串，其余随slab整体归还 */
+    xr_slab_use(&region->slab);
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        XrObject *object = vm->young[age];
+        while (object != NULL) {
+            XrObject *next = object->next;
+            if (region_needs_free(region, object)) {
+                free_object(object);
+            }
+            object = next;
+        }
+    }
+    for (XrObject *object = vm->upvalues; object != NULL; ) {
+        XrObject *next = object->next;
+        if (!xr_slab_owns(&region->slab, object)) {
+            xr_bc_upvalue_free((XrUpvalue*)object);
+        }
+        object = next;
+    }
+    for (XrObject *object = vm->methods; object != NULL; ) {
+        XrObject *next = object->next;
+        xr_method_free((XrMethod*)object);
+        object = next;
+    }
+    
+    StringPool *pool = &region->strings;
+    for (XrString *str = pool->long_strings; str != NULL; ) {
+        XrString *next = (XrString*)str->header.next;
+        if (!xr_slab_owns(&region->slab, str)) {
+            xr_string_free(str);
+        }
+        str = next;
+    }
+    for (size_t i = 0; i < pool->capacity; i++) {
+        XrString *str = pool->entries[i];
+        if (str != NULL && !xr_slab_owns(&region->slab, str)) {
+            xr_string_free(str);
+        }
+    }
+    if (pool->entries != NULL) {
+        xmem_free(pool->entries);
+    }
+    memset(pool, 0, sizeof(StringPool));
+    
+    xr_slab_use(&vm->slab);
+    xr_slab_free_all(&region->slab);
+    if (region->index_keys != NULL) {
+        xmem_free(region->index_keys);
+        xmem_free(region->index_values);
+    }
+    region->index_keys = NULL;
+    region->index_values = NULL;
+    region->index_count = 0;
+    region->index_capacity = 0;
+    
+    /* 3. 恢复VM的链表，导出的副本成为年轻对象 */
+    for (int age = 0; age < GC_PROMOTE_AGE; age++) {
+        vm->young[age] = NULL;
+    }
+    vm->young[0] = region->exported;
+    vm->young_bytes = region->exported_bytes;
+    vm->upvalues = region->upvalues;
+    vm->methods = region->methods;
+    vm->bytes_allocated = region->bytes_allocated;
+    region->exported = NULL;
+    region->exported_bytes = 0;
+    
+    /* 4. 执行状态里不能留下区域的指针 */
+    vm->stack_top = vm->stack;
+    vm->frame_count = 0;
+    vm->open_upvalues = NULL;
+    vm->builder_count = 0;
+    region->active = false;
+    
+    /* 恢复调用者的选择，原先选中的区域已不存在 */
+    if (scope.pool == &region->strings) scope.pool = &vm->strings;
+    if (scope.slab == &region->slab) scope.slab = &vm->slab;
+    gc_leave(scope);
+}
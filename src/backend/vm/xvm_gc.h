@@ -0,0 +1,198 @@
+/*
+** xvm_gc.h
+** Xray 寄存器虚拟机的垃圾回收器
+**
+** 精确的分代标记-清除GC：
+**   - 根：寄存器栈、调用帧的闭包、全局变量数组、开放upvalue
+**   - 常量：从闭包和方法到达的Proto（含嵌套Proto）的常量表
+**   - 对象：数组、Map、实例、类、闭包、upvalue、方法
+**   - 字符串：标记后交给字符串池清扫（驻留表对GC是弱引用），
+**     切片字符串连同父串一起标记
+**
+** 分代（对象不移动）：
+**   - 标记位是粘性的：已标记 = 老年代，未标记 = 年轻代
+**   - 新对象进入年轻代，熬过GC_PROMOTE_AGE次minor GC后晋升
+**   - minor GC只标记和清扫年轻代，老对象当作已标记直接跳过；
+**     老对象指向年轻对象的引用由写屏障记入记忆集
+**   - 老年代超过阈值时做完整GC
+**
+** 完整GC的标记是增量的三色标记：
+**   - 白 = 未标记，灰 = 已标记但在标记栈中待追踪，黑 = 已追踪
+**   - 标记分摊到安全点和循环回跳上，每步不超过停顿目标
+**   - 清扫不分步：最后一步在同一次停顿里重扫根、清扫对象链表和字符串池，
+**     这一步的时长与堆大小成正比，不受停顿目标约束
+**   - Dijkstra写屏障：往已标记对象写入白色值时把值置灰
+**   - 根和upvalue没有写屏障，标记结束时重新扫描一遍再清扫
+**
+** 只在VM的安全点触发（分配对象的指令把结果写入寄存器之后），
+** 此时所有存活值都能从根找到，C局部变量里没有未登记的对象。
+**
+** 区域模式（见xr_bc_vm_set_region_mode）：一次执行期间不做GC，
+** 新对象和字符串记在区域里，执行结束后整体丢弃。
+**
+** 参考：clox的GC、Lua 5.4的lgc.c（分代模式）
+*/
+
+#ifndef xvm_gc_h
+#define xvm_gc_h
+
+#include "xvm.h"
+
+struct XrMethod;  /* 见xmethod.h */
+
+/* ========== 初始化和释放 ========== */
+
+/*
+** 初始化GC状态
+** 定义XR_GC_STRESS时默认开启压力测试模式
+*/
+void xr_bc_gc_init(VM *vm);
+
+/*
+** 释放所有登记的对象和标记栈（VM销毁时调用）
+*/
+void xr_bc_gc_free_all(VM *vm);
+
+/* ========== 对象登记 ========== */
+
+/*
+** 登记VM创建的值对象（闭包、数组、Map、类、实例）
+** 对象占用的字节数计入下次GC的触发量
+*/
+void xr_bc_gc_track(VM *vm, XrObject *object);
+
+/*
+** 登记upvalue
+*/
+void xr_bc_gc_track_upvalue(VM *vm, XrUpvalue *upvalue);
+
+/*
+** 登记方法对象
+*/
+void xr_bc_gc_track_method(VM *vm, struct XrMethod *method);
+
+/* ========== 写屏障 ========== */
+
+/*
+** 值是否引用年轻代对象（未标记的字符串或对象）
+*/
+static inline bool xr_bc_gc_is_young(XrValue value) {
+    if (xr_isnull(value) || xr_isbool(value) ||
+        xr_isint(value) || xr_isfloat(value)) {
+        return false;
+    }
+    if (xr_isstring(value)) {
+        return !xr_tostring(value)->header.marked;
+    }
+    XrObject *object = (XrObject*)xr_toobj(value);
+    return object != NULL && !object->marked;
+}
+
+/*
+** 把老对象记入记忆集（下次minor GC时重新扫描它）
+** 增量标记期间改为把对象重新置灰
+*/
+void xr_bc_gc_remember(VM *vm, XrObject *object);
+
+/*
+** 写屏障的慢速路径：增量标记期间把value置灰，否则记住target
+*/
+void xr_bc_gc_barrier_slow(VM *vm, XrObject *target, XrValue value);
+
+/*
+** 写屏障：往target写入value之后调用
+** target已标记（老对象/黑色对象）而value未标记时才进入慢速路径
+*/
+static inline void xr_bc_gc_barrier(VM *vm, XrObject *target, XrValue value) {
+    if (target->marked && xr_bc_gc_is_young(value)) {
+        xr_bc_gc_barrier_slow(vm, target, value);
+    }
+}
+
+/*
+** C函数可能不经写屏障修改参数对象，调用后把老年代参数整个记入记忆集
+*/
+static inline void xr_bc_gc_barrier_arg(VM *vm, XrValue value) {
+    if (xr_isnull(value) || xr_isbool(value) || xr_isint(value) ||
+        xr_isfloat(value) || xr_isstring(value)) {
+        return;
+    }
+    XrObject *object = (XrObject*)xr_toobj(value);
+    if (object != NULL && object->marked) {
+        xr_bc_gc_remember(vm, object);
+    }
+}
+
+/* ========== 回收 ========== */
+
+/*
+** 执行一次完整的标记-清除（全部对象都成为老年代）
+** 增量标记进行中时一次做完剩余的标记
+** 返回：
+**   释放的对象数量（含字符串）
+*/
+size_t xr_bc_gc_collect(VM *vm);
+
+/*
+** 执行一次minor GC：只回收年轻代
+** 增量标记进行中时改为完成这次完整GC
+** 返回：
+**   释放的对象数量（含字符串）
+*/
+size_t xr_bc_gc_collect_young(VM *vm);
+
+/*
+** 安全点触发的一步GC，停顿时长计入统计：
+**   - 增量标记进行中：继续标记，直到标记栈为空或用完停顿目标；
+**     标记栈追踪完的那一步接着完成清扫，停顿可能超出目标
+**   - 老年代超过阈值：开始增量标记
+**   - 否则做minor GC
+** （压力测试模式下每GC_STRESS_FULL_INTERVAL次开始一次完整GC，
+**   每步只追踪一个对象，让标记和程序尽量交错）
+*/
+void xr_bc_gc_step(VM *vm);
+
+/*
+** 上次GC以来新分配的字节数（年轻代对象和新字符串）
+*/
+static inline size_t xr_bc_gc_young_bytes(VM *vm) {
+    return vm->young_bytes + (vm->strings.bytes - vm->string_bytes);
+}
+
+/*
+** 是否该做下一步GC（压力测试模式下总是，区域打开时从不）
+** 平时年轻代超过GC_NURSERY_SIZE时触发，增量标记期间每GC_STEP_SIZE触发
+*/
+static inline bool xr_bc_gc_needed(VM *vm) {
+    return !vm->region.active &&
+           (vm->gc_stress || xr_bc_gc_young_bytes(vm) > vm->next_step);
+}
+
+/* ========== 区域模式 ========== */
+
+/*
+** 打开区域（区域模式下由xr_bc_interpret_proto在创建顶层闭包之前调用）
+** 之前的区域还没重置时先重置；有进行中的增量标记或老年代超过阈值时
+** 先做完整GC（proto的常量算作根），年轻对象全部晋升，
+** 之后新建的对象和字符串都归区域
+*/
+void xr_bc_region_begin(VM *vm, Proto *proto);
+
+/*
+** 把区域中的值复制到VM的堆里（执行结束之后、重置之前调用）
+** 字符串、数组、Map按内容深复制，同一个对象只复制一次（保留共享和环）；
+** 闭包、类、实例不能导出，得到null。不属于区域的值原样返回
+*/
+XrValue xr_bc_region_export(VM *vm, XrValue value);
+
+/*
+** 重置区域：丢弃本次执行新建的全部对象和字符串
+**   - 全局变量、执行前就有的对象和upvalue中引用区域的值先自动导出
+**   - 只有另外持有xmem内存的对象（数组、Map、类、大块）逐个释放，
+**     slab中的对象随区域的页整体归还
+**   - 调用帧、开放upvalue、构建器清空
+** 没有打开的区域时什么也不做
+*/
+void xr_bc_region_reset(VM *vm);
+
+#endif /* xvm_gc_h */
@@ -13,16 +13,59 @@
 /* 程序节点初始容量 */
 #define INITIAL_CAPACITY 8
 
+/* ========== 节点内存 ========== */
+
 /*
-** 分配 AST 节点内存
-** 返回新分配的节点指针
+** 为节点分配内存
+** xr_parse期间从解析会话的arena分配，整棵树随arena一次释放
 */
-static AstNode *alloc_node(XrayState *X, AstNodeType type, int line) {
-    AstNode *node = (AstNode *)malloc(sizeof(AstNode));
-    if (node == NULL) {
+void *xr_ast_alloc(XrayState *X, size_t size) {
+    XrArena *arena = xr_arena_current();
+    if (arena != NULL) {
+        return xr_arena_alloc(arena, size);
+    }
+    
+    void *ptr = malloc(size);
+    if (ptr == NULL) {
         fprintf(stderr, "内存分配失败\n");
         exit(1);
     }
+    return ptr;
+}
+
+/*
+** 调整数组大小
+*/
+void *xr_ast_realloc(XrayState *X, void *ptr, size_t old_size, size_t new_size) {
+    XrArena *arena = xr_arena_current();
+    if (arena != NULL) {
+        return xr_arena_realloc(arena, ptr, old_size, new_size);
+    }
+    
+    void *grown = realloc(ptr, new_size);
+    if (grown == NULL) {
+        fprintf(stderr, "内存分配失败\n");
+        exit(1);
+    }
+    return grown;
+}
+
+/*
+** 复制名称
+*/
+char *xr_ast_strndup(XrayState *X, const char *chars, size_t length) {
+    char *copy = (char *)xr_ast_alloc(X, length + 1);
+    memcpy(copy, chars, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/*
+** 分配 AST 节点内存
+** 返回新分配的节点指针
+*/
+static AstNode *alloc_node(XrayState *X, AstNodeType type, int line) {
+    AstNode *node = (AstNode *)xr_ast_alloc(X, sizeof(AstNode));
     node->type = type;
     node->line = line;
     return node;
@@ -85,7 +128,7 @@ AstNode *xr_ast_template_string(XrayState *X, AstNode **parts, int part_count, i
     AstNode *node = alloc_node(X, AST_TEMPLATE_STRING, line);
     
     /* 分配并复制parts数组 */
-    node->as.template_str.parts = (AstNode**)malloc(sizeof(AstNode*) * part_count);
+    node->as.template_str.parts = (AstNode**)xr_ast_alloc(X, sizeof(AstNode*) * part_count);
     for (int i = 0; i < part_count; i++) {
         node->as.template_str.parts[i] = parts[i];
     }
@@ -172,6 +215,7 @@ AstNode *xr_ast_program(XrayState *X) {
     node->as.program.statements = NULL;
     node->as.program.count = 0;
     node->as.program.capacity = 0;
+    node->as.program.arena = NULL;
     return node;
 }
 
@@ -186,16 +230,12 @@ void xr_ast_program_add(XrayState *X, AstNode *program, AstNode *stmt) {
         int new_capacity = old_capacity < INITIAL_CAPACITY ? 
                           INITIAL_CAPACITY : old_capacity * 2;
         
-        program->as.program.statements = (AstNode **)realloc(
-            program->as.program.statements,
+        program->as.program.statements = (AstNode **)xr_ast_realloc(
+            X, program->as.program.statements,
+            sizeof(AstNode *) * old_capacity,
             sizeof(AstNode *) * new_capacity
         );
         
-        if (program->as.program.statements == NULL) {
-            fprintf(stderr, "内存分配失败\n");
-            exit(1);
-        }
-        
         program->as.program.capacity = new_capacity;
     }
     
@@ -227,16 +267,12 @@ void xr_ast_block_add(XrayState *X, AstNode *block, AstNode *stmt) {
         int new_capacity = old_capacity < INITIAL_CAPACITY ? 
                           INITIAL_CAPACITY : old_capacity * 2;
         
-        block->as.block.statements = (AstNode **)realloc(
-            block->as.block.statements,
+        block->as.block.statements = (AstNode **)xr_ast_realloc(
+            X, block->as.block.statements,
+            sizeof(AstNode *) * old_capacity,
             sizeof(AstNode *) * new_capacity
         );
         
-        if (block->as.block.statements == NULL) {
-            fprintf(stderr, "内存分配失败\n");
-            exit(1);
-        }
-        
         block->as.block.capacity = new_capacity;
     }
     
@@ -255,7 +291,7 @@ void xr_ast_block_add(XrayState *X, AstNode *block, AstNode *stmt) {
 AstNode *xr_ast_var_decl(XrayState *X, const char *name, 
                          AstNode *initializer, bool is_const, int line) {
     AstNode *node = alloc_node(X, is_const ? AST_CONST_DECL : AST_VAR_DECL, line);
-    node->as.var_decl.name = strdup(name);
+    node->as.var_decl.name = xr_ast_strndup(X, name, strlen(name));
     node->as.var_decl.initializer = initializer;
     node->as.var_decl.is_const = is_const;
     
@@ -273,7 +309,7 @@ AstNode *xr_ast_var_decl(XrayState *X, const char *name,
 */
 AstNode *xr_ast_variable(XrayState *X, const char *name, int line) {
     AstNode *node = alloc_node(X, AST_VARIABLE, line);
-    node->as.variable.name = strdup(name);
+    node->as.variable.name = xr_ast_strndup(X, name, strlen(name));
     
     if (node->as.variable.name == NULL) {
         fprintf(stderr, "内存分配失败\n");
@@ -291,7 +327,7 @@ AstNode *xr_ast_variable(XrayState *X, const char *name, int line) {
 AstNode *xr_ast_assignment(XrayState *X, const char *name, 
                            AstNode *value, int line) {
     AstNode *node = alloc_node(X, AST_ASSIGNMENT, line);
-    node->as.assignment.name = strdup(name);
+    node->as.assignment.name = xr_ast_strndup(X, name, strlen(name));
     node->as.assignment.value = value;
     
     if (node->as.assignment.name == NULL) {
@@ -350,6 +386,32 @@ AstNode *xr_ast_for_stmt(XrayState *X, AstNode *initializer,
     return node;
 }
 
+/*
+** 创建 for-in 循环节点
+** key_name: 第一个变量名
+** value_name: 第二个变量名（可选）
+** iterable: 被迭代的表达式
+** body: 循环体（必须是 block）
+*/
+AstNode *xr_ast_for_in_stmt(XrayState *X, const char *key_name, 
+                            const char *value_name, AstNode *iterable, 
+                            AstNode *body, int line) {
+    AstNode *node = alloc_node(X, AST_FOR_IN_STMT, line);
+    node->as.for_in_stmt.key_name = xr_ast_strndup(X, key_name, strlen(key_name));
+    node->as.for_in_stmt.value_name = value_name ?
+        xr_ast_strndup(X, value_name, strlen(value_name)) : NULL;
+    node->as.for_in_stmt.iterable = iterable;
+    node->as.for_in_stmt.body = body;
+    
+    if (node->as.for_in_stmt.key_name == NULL ||
+        (value_name != NULL && node->as.for_in_stmt.value_name == NULL)) {
+        fprintf(stderr, "内存分配失败\n");
+        exit(1);
+    }
+    
+    return node;
+}
+
 /*
 ** 创建 break 语句节点
 */
@@ -383,16 +445,14 @@ AstNode *xr_ast_function_decl(XrayState *X, const char *name,
     AstNode *node = alloc_node(X, AST_FUNCTION_DECL, line);
     
     /* 复制函数名 */
-    node->as.function_decl.name = (char *)malloc(strlen(name) + 1);
-    strcpy(node->as.function_decl.name, name);
+    node->as.function_decl.name = xr_ast_strndup(X, name, strlen(name));
     
     /* 复制参数列表 */
     node->as.function_decl.param_count = param_count;
     if (param_count > 0) {
-        node->as.function_decl.parameters = (char **)malloc(sizeof(char *) * param_count);
+        node->as.function_decl.parameters = (char **)xr_ast_alloc(X, sizeof(char *) * param_count);
         for (int i = 0; i < param_count; i++) {
-            node->as.function_decl.parameters[i] = (char *)malloc(strlen(parameters[i]) + 1);
-            strcpy(node->as.function_decl.parameters[i], parameters[i]);
+            node->as.function_decl.parameters[i] = xr_ast_strndup(X, parameters[i], strlen(parameters[i]));
         }
     } else {
         node->as.function_decl.parameters = NULL;
@@ -418,10 +478,9 @@ AstNode *xr_ast_function_expr(XrayState *X, char **parameters, int param_count,
     /* 复制参数列表 */
     node->as.function_expr.param_count = param_count;
     if (param_count > 0) {
-        node->as.function_expr.parameters = (char **)malloc(sizeof(char *) * param_count);
+        node->as.function_expr.parameters = (char **)xr_ast_alloc(X, sizeof(char *) * param_count);
         for (int i = 0; i < param_count; i++) {
-            node->as.function_expr.parameters[i] = (char *)malloc(strlen(parameters[i]) + 1);
-            strcpy(node->as.function_expr.parameters[i], parameters[i]);
+            node->as.function_expr.parameters[i] = xr_ast_strndup(X, parameters[i], strlen(parameters[i]));
         }
     } else {
         node->as.function_expr.parameters = NULL;
@@ -445,7 +504,7 @@ AstNode *xr_ast_call_expr(XrayState *X, AstNode *callee,
     
     /* 复制参数列表 */
     if (arg_count > 0) {
-        node->as.call_expr.arguments = (AstNode **)malloc(sizeof(AstNode *) * arg_count);
+        node->as.call_expr.arguments = (AstNode **)xr_ast_alloc(X, sizeof(AstNode *) * arg_count);
         for (int i = 0; i < arg_count; i++) {
             node->as.call_expr.arguments[i] = arguments[i];
         }
@@ -479,7 +538,7 @@ AstNode *xr_ast_array_literal(XrayState *X, AstNode **elements, int count, int l
     
     /* 复制元素数组 */
     if (count > 0) {
-        node->as.array_literal.elements = (AstNode **)malloc(sizeof(AstNode *) * count);
+        node->as.array_literal.elements = (AstNode **)xr_ast_alloc(X, sizeof(AstNode *) * count);
         for (int i = 0; i < count; i++) {
             node->as.array_literal.elements[i] = elements[i];
         }
@@ -502,8 +561,8 @@ AstNode *xr_ast_map_literal(XrayState *X, AstNode **keys, AstNode **values, int
     
     /* 复制键数组 */
     if (count > 0) {
-        node->as.map_literal.keys = (AstNode **)malloc(sizeof(AstNode *) * count);
-        node->as.map_literal.values = (AstNode **)malloc(sizeof(AstNode *) * count);
+        node->as.map_literal.keys = (AstNode **)xr_ast_alloc(X, sizeof(AstNode *) * count);
+        node->as.map_literal.values = (AstNode **)xr_ast_alloc(X, sizeof(AstNode *) * count);
         for (int i = 0; i < count; i++) {
             node->as.map_literal.keys[i] = keys[i];
             node->as.map_literal.values[i] = values[i];
@@ -550,8 +609,7 @@ AstNode *xr_ast_index_set(XrayState *X, AstNode *array, AstNode *index, AstNode
 AstNode *xr_ast_member_access(XrayState *X, AstNode *object, const char *name, int line) {
     AstNode *node = alloc_node(X, AST_MEMBER_ACCESS, line);
     node->as.member_access.object = object;
-    node->as.member_access.name = (char *)malloc(strlen(name) + 1);
-    strcpy(node->as.member_access.name, name);
+    node->as.member_access.name = xr_ast_strndup(X, name, strlen(name));
     return node;
 }
 
@@ -653,7 +711,7 @@ AstNode *xr_ast_member_set(XrayState *X, AstNode *object, const char *member,
                            AstNode *value, int line) {
     AstNode *node = alloc_node(X, AST_MEMBER_SET, line);
     node->as.member_set.object = object;
-    node->as.member_set.member = strdup(member);  /* 复制字符串，避免悬空指针 */
+    node->as.member_set.member = xr_ast_strndup(X, member, strlen(member));  /* 复制字符串，避免悬空指针 */
     node->as.member_set.value = value;
     return node;
 }
@@ -665,6 +723,17 @@ AstNode *xr_ast_member_set(XrayState *X, AstNode *object, const char *member,
 void xr_ast_free(XrayState *X, AstNode *node) {
     if (node == NULL) return;
     
+    /* xr_parse得到的树：整体归还arena，不逐个释放 */
+    if (node->type == AST_PROGRAM && node->as.program.arena != NULL) {
+        xr_arena_free(node->as.program.arena);
+        return;
+    }
+    
+    /* 解析过程中丢弃的子树：留给arena释放 */
+    if (xr_arena_owns(xr_arena_current(), node)) {
+        return;
+    }
+    
     switch (node->type) {
         /* 字面量节点 */
         case AST_LITERAL_INT:
@@ -768,6 +837,13 @@ void xr_ast_free(XrayState *X, AstNode *node) {
             xr_ast_free(X, node->as.for_stmt.body);
             break;
         
+        case AST_FOR_IN_STMT:
+            free(node->as.for_in_stmt.key_name);
+            free(node->as.for_in_stmt.value_name);
+            xr_ast_free(X, node->as.for_in_stmt.iterable);
+            xr_ast_free(X, node->as.for_in_stmt.body);
+            break;
+        
         case AST_BREAK_STMT:
         case AST_CONTINUE_STMT:
             /* 无需释放额外数据 */
@@ -983,6 +1059,7 @@ const char *xr_ast_typename(AstNodeType type) {
         case AST_IF_STMT:           return "IfStmt";
         case AST_WHILE_STMT:        return "WhileStmt";
         case AST_FOR_STMT:          return "ForStmt";
+        case AST_FOR_IN_STMT:       return "ForInStmt";
         case AST_BREAK_STMT:        return "BreakStmt";
         case AST_CONTINUE_STMT:     return "ContinueStmt";
         case AST_FUNCTION_DECL:     return "FunctionDecl";
@@ -1144,6 +1221,17 @@ void xr_ast_print(AstNode *node, int indent) {
             xr_ast_print(node->as.for_stmt.body, indent + 2);
             break;
         
+        case AST_FOR_IN_STMT:
+            printf("%*s  key: %s\n", indent * 2, "", node->as.for_in_stmt.key_name);
+            if (node->as.for_in_stmt.value_name != NULL) {
+                printf("%*s  value: %s\n", indent * 2, "", node->as.for_in_stmt.value_name);
+            }
+            printf("%*s  iterable:\n", indent * 2, "");
+            xr_ast_print(node->as.for_in_stmt.iterable, indent + 2);
+            printf("%*s  body:\n", indent * 2, "");
+            xr_ast_print(node->as.for_in_stmt.body, indent + 2);
+            break;
+        
         case AST_BREAK_STMT:
         case AST_CONTINUE_STMT:
             /* 无需打印额外信息 */
@@ -9,6 +9,7 @@
 
 #include "xray.h"
 #include "xvalue.h"
+#include "xarena.h"
 #include <stdbool.h>
 
 /* 前向声明 */
@@ -82,6 +83,7 @@ typedef enum {
     AST_IF_STMT,            /* if 语句：if (cond) {...} else {...} */
     AST_WHILE_STMT,         /* while 循环：while (cond) {...} */
     AST_FOR_STMT,           /* for 循环：for (init; cond; update) {...} */
+    AST_FOR_IN_STMT,        /* for-in 循环：for (let k, v in m) {...} */
     AST_BREAK_STMT,         /* break 语句 */
     AST_CONTINUE_STMT,      /* continue 语句 */
     
@@ -141,11 +143,13 @@ typedef struct {
 /*
 ** 程序节点
 ** 包含语句列表
+** xr_parse得到的程序节点持有整棵树所在的arena
 */
 typedef struct {
     AstNode **statements;   /* 语句数组 */
     int count;              /* 语句数量 */
     int capacity;           /* 数组容量 */
+    XrArena *arena;         /* 节点、数组和标识符所在的arena（NULL表示逐个malloc） */
 } ProgramNode;
 
 /*
@@ -223,6 +227,19 @@ typedef struct {
     AstNode *body;          /* 循环体（必须是 block） */
 } ForStmtNode;
 
+/*
+** for-in 循环节点
+** for (let value in iterable) body
+** for (let key, value in iterable) body
+** 单变量时：数组绑定元素，Map绑定键
+*/
+typedef struct {
+    char *key_name;         /* 第一个变量名 */
+    char *value_name;       /* 第二个变量名（可选，NULL表示单变量） */
+    AstNode *iterable;      /* 被迭代的数组或Map */
+    AstNode *body;          /* 循环体（必须是 block） */
+} ForInStmtNode;
+
 /*
 ** break 语句节点
 ** break
@@ -437,6 +454,7 @@ struct AstNode {
         IfStmtNode if_stmt;         /* if 语句 */
         WhileStmtNode while_stmt;   /* while 循环 */
         ForStmtNode for_stmt;       /* for 循环 */
+        ForInStmtNode for_in_stmt;  /* for-in 循环 */
         BreakStmtNode break_stmt;   /* break 语句 */
         ContinueStmtNode continue_stmt; /* continue 语句 */
         FunctionDeclNode function_decl; /* 函数声明 */
@@ -525,6 +543,11 @@ AstNode *xr_ast_for_stmt(XrayState *X, AstNode *initializer,
                          AstNode *condition, AstNode *increment, 
                          AstNode *body, int line);
 
+/* 创建 for-in 循环节点 */
+AstNode *xr_ast_for_in_stmt(XrayState *X, const char *key_name, 
+                            const char *value_name, AstNode *iterable, 
+                            AstNode *body, int line);
+
 /* 创建 break 语句节点 */
 AstNode *xr_ast_break_stmt(XrayState *X, int line);
 
@@ -596,9 +619,26 @@ AstNode *xr_ast_super_call(XrayState *X, const char *method_name,
 AstNode *xr_ast_member_set(XrayState *X, AstNode *object, const char *member,
                            AstNode *value, int line);
 
-/* 释放 AST 节点 */
+/*
+** 释放 AST 节点
+** 持有arena的程序节点整体归还arena；当前arena中的节点随arena释放
+*/
 void xr_ast_free(XrayState *X, AstNode *node);
 
+/* ========== 节点内存 ========== */
+
+/*
+** 为节点分配内存（节点本身、子节点数组、名称等）
+** 有当前arena时从它分配，否则malloc
+*/
+void *xr_ast_alloc(XrayState *X, size_t size);
+
+/* 调整xr_ast_alloc分配的数组大小 */
+void *xr_ast_realloc(XrayState *X, void *ptr, size_t old_size, size_t new_size);
+
+/* 复制length字节的名称 */
+char *xr_ast_strndup(XrayState *X, const char *chars, size_t length);
+
 /* 调试：打印 AST 结构（用于调试和测试） */
 void xr_ast_print(AstNode *node, int indent);
 
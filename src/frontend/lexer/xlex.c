@@ -179,7 +179,11 @@ static TokenType identifier_type(Scanner *scanner) {
             if (scanner->current - scanner->start > 1) {
                 switch (scanner->start[1]) {
                     case 'f': return TK_IF;  /* if */
-                    case 'n': return check_keyword(scanner, 2, 1, "t", TK_TYPE_INT);  /* int */
+                    case 'n':
+                        if (scanner->current - scanner->start == 2) {
+                            return TK_IN;  /* in */
+                        }
+                        return check_keyword(scanner, 2, 1, "t", TK_TYPE_INT);  /* int */
                 }
             }
             break;
@@ -437,6 +441,7 @@ const char *xr_token_name(TokenType type) {
         case TK_ELSE: return "else";
         case TK_WHILE: return "while";
         case TK_FOR: return "for";
+        case TK_IN: return "in";
         case TK_BREAK: return "break";
         case TK_CONTINUE: return "continue";
         case TK_RETURN: return "return";
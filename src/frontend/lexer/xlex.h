@@ -50,6 +50,7 @@ typedef enum {
     TK_ELSE,            /* else */
     TK_WHILE,           /* while */
     TK_FOR,             /* for */
+    TK_IN,              /* in（for-in 循环） */
     TK_BREAK,           /* break */
     TK_CONTINUE,        /* continue */
     TK_RETURN,          /* return */
@@ -8,11 +8,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include "xparse.h"
+#include "xstring.h"
+#include "xslab.h"
 
 /* ========== 前向声明 ========== */
 
 static AstNode *xr_parse_arrow_function_body(Parser *parser, char **params, int param_count, int line);
 static AstNode *xr_parse_template_string(Parser *parser);
+static AstNode *xr_parse_var_rest(Parser *parser, int is_const);
+static AstNode *xr_parse_for_in_rest(Parser *parser, int line);
 
 /* ========== 解析规则表 ========== */
 
@@ -753,6 +757,18 @@ AstNode *xr_parse(XrayState *X, const char *source) {
     Parser parser;
     xr_parser_init(&parser, X, source);
     
+    /* 解析期间所有节点从这个arena分配 */
+    XrArena *arena = xr_arena_new();
+    XrArena *saved_arena = xr_arena_current();
+    xr_arena_use(arena);
+    
+    /* 字面量和名字驻留在默认池里：VM的池会被GC清扫，
+    ** AST和编译出的原型常量却可能比任何一次执行活得久 */
+    StringPool *saved_pool = xr_string_pool_current();
+    XrSlab *saved_slab = xr_slab_current();
+    xr_string_pool_use(NULL);
+    xr_slab_use(NULL);
+    
     /* 创建程序根节点 */
     AstNode *program = xr_ast_program(X);
     
@@ -774,12 +790,17 @@ AstNode *xr_parse(XrayState *X, const char *source) {
         if (parser.had_error) break;
     }
     
+    xr_arena_use(saved_arena);
+    xr_string_pool_use(saved_pool);
+    xr_slab_use(saved_slab);
+    
     /* 如果有错误，释放 AST 并返回 NULL */
     if (parser.had_error) {
-        xr_ast_free(X, program);
+        xr_arena_free(arena);
         return NULL;
     }
     
+    program->as.program.arena = arena;
     return program;
 }
 
@@ -835,7 +856,9 @@ AstNode *xr_parse_assignment(Parser *parser, AstNode *left) {
         AstNode *node = xr_ast_index_set(parser->X, array, index, value, line);
         
         /* 释放原 index_get 节点（但不释放其子节点） */
-        free(left);
+        left->as.index_get.array = NULL;
+        left->as.index_get.index = NULL;
+        xr_ast_free(parser->X, left);
         
         return node;
     }
@@ -852,8 +875,8 @@ AstNode *xr_parse_assignment(Parser *parser, AstNode *left) {
         AstNode *node = xr_ast_member_set(parser->X, object, member, value, line);
         
         /* 释放原 member_access 节点（但不释放其子节点） */
-        free(left->as.member_access.name);
-        free(left);
+        left->as.member_access.object = NULL;
+        xr_ast_free(parser->X, left);
         free(member);
         
         return node;
@@ -873,7 +896,13 @@ AstNode *xr_parse_assignment(Parser *parser, AstNode *left) {
 AstNode *xr_parse_var_declaration(Parser *parser, int is_const) {
     /* 期望变量名 */
     xr_parser_consume(parser, TK_NAME, "期望变量名");
-    
+    return xr_parse_var_rest(parser, is_const);
+}
+
+/*
+** 解析变量名之后的部分（变量名为 parser->previous）
+*/
+static AstNode *xr_parse_var_rest(Parser *parser, int is_const) {
     /* 保存变量名 */
     char *name = (char *)malloc(parser->previous.length + 1);
     memcpy(name, parser->previous.start, parser->previous.length);
@@ -991,6 +1020,7 @@ AstNode *xr_parse_while_statement(Parser *parser) {
 /*
 ** 解析 for 循环
 ** for (init; condition; increment) { ... }
+** for (let k, v in iterable) { ... }
 */
 AstNode *xr_parse_for_statement(Parser *parser) {
     int line = parser->previous.line;
@@ -1004,8 +1034,15 @@ AstNode *xr_parse_for_statement(Parser *parser) {
         /* 省略初始化 */
         initializer = NULL;
     } else if (xr_parser_match(parser, TK_LET)) {
+        xr_parser_consume(parser, TK_NAME, "期望变量名");
+        
+        /* 变量名后是 in 或 ','：for-in 循环 */
+        if (xr_parser_check(parser, TK_IN) || xr_parser_check(parser, TK_COMMA)) {
+            return xr_parse_for_in_rest(parser, line);
+        }
+        
         /* let 声明 */
-        initializer = xr_parse_var_declaration(parser, 0);
+        initializer = xr_parse_var_rest(parser, 0);
         xr_parser_consume(parser, TK_SEMICOLON, "期望 ';' 在 for 循环初始化后");
     } else {
         /* 表达式 */
@@ -1038,6 +1075,47 @@ AstNode *xr_parse_for_statement(Parser *parser) {
     return xr_ast_for_stmt(parser->X, initializer, condition, increment, body, line);
 }
 
+/*
+** 解析 for-in 循环的剩余部分（已消费第一个变量名）
+** for (let value in iterable) { ... }
+** for (let key, value in iterable) { ... }
+*/
+static AstNode *xr_parse_for_in_rest(Parser *parser, int line) {
+    /* 第一个变量名 */
+    char *key_name = (char *)malloc(parser->previous.length + 1);
+    memcpy(key_name, parser->previous.start, parser->previous.length);
+    key_name[parser->previous.length] = '\0';
+    
+    /* 第二个变量名（可选） */
+    char *value_name = NULL;
+    if (xr_parser_match(parser, TK_COMMA)) {
+        xr_parser_consume(parser, TK_NAME, "期望变量名在 ',' 后");
+        value_name = (char *)malloc(parser->previous.length + 1);
+        memcpy(value_name, parser->previous.start, parser->previous.length);
+        value_name[parser->previous.length] = '\0';
+    }
+    
+    xr_parser_consume(parser, TK_IN, "期望 'in' 在 for-in 变量后");
+    AstNode *iterable = xr_parse_expression(parser);
+    xr_parser_consume(parser, TK_RPAREN, "期望 ')' 在 for-in 循环头后");
+    
+    /* 解析循环体（必须是 block） */
+    if (!xr_parser_check(parser, TK_LBRACE)) {
+        xr_parser_error_at_current(parser, "for 语句后面必须使用花括号 { }");
+        free(key_name);
+        free(value_name);
+        xr_ast_free(parser->X, iterable);
+        return NULL;
+    }
+    xr_parser_advance(parser);  /* 消费 '{' */
+    AstNode *body = xr_parse_block(parser);
+    
+    AstNode *node = xr_ast_for_in_stmt(parser->X, key_name, value_name, iterable, body, line);
+    free(key_name);
+    free(value_name);
+    return node;
+}
+
 /*
 ** 解析 break 语句
 */
@@ -1088,19 +1166,18 @@ AstNode *xr_parse_function_declaration(Parser *parser) {
             /* 扩容 */
             if (param_count >= param_capacity) {
                 param_capacity = param_capacity == 0 ? 4 : param_capacity * 2;
-                parameters = (char **)realloc(parameters, sizeof(char *) * param_capacity);
+                parameters = (char **)xr_ast_realloc(parser->X, parameters,
+                                                     sizeof(char *) * param_count,
+                                                     sizeof(char *) * param_capacity);
             }
             
             /* 解析参数名 */
             xr_parser_consume(parser, TK_NAME, "期望参数名");
             Token param_token = parser->previous;
             
-            /* 复制参数名 */
-            char *param_name = (char *)malloc(param_token.length + 1);
-            memcpy(param_name, param_token.start, param_token.length);
-            param_name[param_token.length] = '\0';
-            
-            parameters[param_count++] = param_name;
+            /* 复制参数名（临时数组和参数名都在解析会话的arena中） */
+            parameters[param_count++] = xr_ast_strndup(parser->X, param_token.start,
+                                                       param_token.length);
             
         } while (xr_parser_match(parser, TK_COMMA));
     }
@@ -1140,7 +1217,9 @@ AstNode *xr_parse_call_expr(Parser *parser, AstNode *callee) {
             /* 扩容 */
             if (arg_count >= arg_capacity) {
                 arg_capacity = arg_capacity == 0 ? 4 : arg_capacity * 2;
-                arguments = (AstNode **)realloc(arguments, sizeof(AstNode *) * arg_capacity);
+                arguments = (AstNode **)xr_ast_realloc(parser->X, arguments,
+                                                       sizeof(AstNode *) * arg_count,
+                                                       sizeof(AstNode *) * arg_capacity);
             }
             
             /* 解析参数表达式 */
@@ -1180,7 +1259,9 @@ AstNode *xr_parse_array_literal(Parser *parser) {
         /* 扩容 */
         if (count >= capacity) {
             capacity = capacity == 0 ? 4 : capacity * 2;
-            elements = (AstNode **)realloc(elements, sizeof(AstNode *) * capacity);
+            elements = (AstNode **)xr_ast_realloc(parser->X, elements,
+                                                  sizeof(AstNode *) * count,
+                                                  sizeof(AstNode *) * capacity);
         }
         
         /* 解析元素表达式 */
@@ -1222,8 +1303,12 @@ AstNode *xr_parse_map_literal(Parser *parser) {
         /* 扩容 */
         if (count >= capacity) {
             capacity = capacity == 0 ? 4 : capacity * 2;
-            keys = (AstNode **)realloc(keys, sizeof(AstNode *) * capacity);
-            values = (AstNode **)realloc(values, sizeof(AstNode *) * capacity);
+            keys = (AstNode **)xr_ast_realloc(parser->X, keys,
+                                              sizeof(AstNode *) * count,
+                                              sizeof(AstNode *) * capacity);
+            values = (AstNode **)xr_ast_realloc(parser->X, values,
+                                                sizeof(AstNode *) * count,
+                                                sizeof(AstNode *) * capacity);
         }
         
         /* 解析键 */
@@ -1251,9 +1336,7 @@ AstNode *xr_parse_map_literal(Parser *parser) {
             key = xr_parse_literal(parser);
         } else {
             xr_parser_error(parser, "期望标识符、字符串或数字作为Map的键");
-            /* 清理并返回 */
-            if (keys) free(keys);
-            if (values) free(values);
+            /* 临时数组随arena释放 */
             return xr_ast_literal_null(parser->X, line);
         }
         
@@ -1312,8 +1395,10 @@ AstNode *xr_parse_member_access(Parser *parser, AstNode *object) {
     strncpy(member_name, name, name_len);
     member_name[name_len] = '\0';
     
-    /* 创建成员访问节点 */
-    return xr_ast_member_access(parser->X, object, member_name, line);
+    /* 创建成员访问节点（节点复制了一份成员名） */
+    AstNode *node = xr_ast_member_access(parser->X, object, member_name, line);
+    free(member_name);
+    return node;
 }
 
 /*
@@ -68,6 +68,7 @@ struct Parser {
 /*
 ** 解析源代码，返回 AST
 ** 这是解析器的主要入口函数
+** 整棵树分配在程序节点持有的arena中，xr_ast_free(X, program)一次释放
 */
 AstNode *xr_parse(XrayState *X, const char *source);
 
@@ -13,19 +13,15 @@
 
 #include "xparse.h"
 #include "xast.h"
-#include "xmem.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 /* 辅助函数：复制Token文本为字符串 */
-static char* token_to_string(Token *token) {
+static char* token_to_string(Parser *parser, Token *token) {
     if (!token || token->length == 0) return NULL;
     
-    char *str = (char*)xmem_alloc(token->length + 1);
-    memcpy(str, token->start, token->length);
-    str[token->length] = '\0';
-    return str;
+    return xr_ast_strndup(parser->X, token->start, token->length);
 }
 
 /* ========== 类声明解析 ========== */
@@ -46,13 +42,13 @@ AstNode *xr_parse_class_declaration(Parser *parser) {
     
     /* 解析类名 */
     consume(parser, TK_NAME, "期望类名");
-    char *class_name = token_to_string(&parser->previous);
+    char *class_name = token_to_string(parser, &parser->previous);
     
     /* 解析extends子句（可选）*/
     char *super_name = NULL;
     if (match(parser, TK_EXTENDS)) {
         consume(parser, TK_NAME, "期望超类名");
-        super_name = token_to_string(&parser->previous);
+        super_name = token_to_string(parser, &parser->previous);
     }
     
     /* 解析类体 */
@@ -76,18 +72,18 @@ AstNode *xr_parse_class_declaration(Parser *parser) {
             /* 添加到方法数组 */
             if (method_count >= method_capacity) {
                 method_capacity = method_capacity == 0 ? 4 : method_capacity * 2;
-                methods = (AstNode**)xmem_realloc(methods, 
-                                                   sizeof(AstNode*) * method_count,
-                                                   sizeof(AstNode*) * method_capacity);
+                methods = (AstNode**)xr_ast_realloc(parser->X, methods, 
+                                                    sizeof(AstNode*) * method_count,
+                                                    sizeof(AstNode*) * method_capacity);
             }
             methods[method_count++] = member;
         } else {
             /* 添加到字段数组 */
             if (field_count >= field_capacity) {
                 field_capacity = field_capacity == 0 ? 4 : field_capacity * 2;
-                fields = (AstNode**)xmem_realloc(fields,
-                                                  sizeof(AstNode*) * field_count,
-                                                  sizeof(AstNode*) * field_capacity);
+                fields = (AstNode**)xr_ast_realloc(parser->X, fields,
+                                                   sizeof(AstNode*) * field_count,
+                                                   sizeof(AstNode*) * field_capacity);
             }
             fields[field_count++] = member;
         }
@@ -150,12 +146,12 @@ AstNode *xr_parse_field_declaration(Parser *parser, bool *is_method_out) {
     if (match(parser, TK_CONSTRUCTOR)) {
         /* constructor关键字 */
         is_constructor = true;
-        name = (char*)xmem_alloc(12);
+        name = (char*)xr_ast_alloc(parser->X, 12);
         strcpy(name, "constructor");
     } else {
         /* 普通名称 */
         consume(parser, TK_NAME, "期望字段或方法名");
-        name = token_to_string(&parser->previous);
+        name = token_to_string(parser, &parser->previous);
     }
     
     /* 区分字段和方法：看是否有'(' */
@@ -172,19 +168,19 @@ AstNode *xr_parse_field_declaration(Parser *parser, bool *is_method_out) {
         if (match(parser, TK_COLON)) {
             /* 类型可以是类型关键字或类名 */
             if (match(parser, TK_TYPE_INT)) {
-                type_name = (char*)xmem_alloc(4);
+                type_name = (char*)xr_ast_alloc(parser->X, 4);
                 strcpy(type_name, "int");
             } else if (match(parser, TK_TYPE_FLOAT)) {
-                type_name = (char*)xmem_alloc(6);
+                type_name = (char*)xr_ast_alloc(parser->X, 6);
                 strcpy(type_name, "float");
             } else if (match(parser, TK_TYPE_STRING)) {
-                type_name = (char*)xmem_alloc(7);
+                type_name = (char*)xr_ast_alloc(parser->X, 7);
                 strcpy(type_name, "string");
             } else if (match(parser, TK_BOOL)) {
-                type_name = (char*)xmem_alloc(5);
+                type_name = (char*)xr_ast_alloc(parser->X, 5);
                 strcpy(type_name, "bool");
             } else if (match(parser, TK_NAME)) {
-                type_name = token_to_string(&parser->previous);
+                type_name = token_to_string(parser, &parser->previous);
             } else {
                 error(parser, "期望类型名");
             }
@@ -237,35 +233,35 @@ AstNode *xr_parse_method_declaration(Parser *parser, const char *name,
             /* 扩展数组 */
             if (param_count >= param_capacity) {
                 param_capacity = param_capacity == 0 ? 4 : param_capacity * 2;
-                parameters = (char**)xmem_realloc(parameters,
-                                                   sizeof(char*) * param_count,
-                                                   sizeof(char*) * param_capacity);
-                param_types = (char**)xmem_realloc(param_types,
+                parameters = (char**)xr_ast_realloc(parser->X, parameters,
                                                     sizeof(char*) * param_count,
                                                     sizeof(char*) * param_capacity);
+                param_types = (char**)xr_ast_realloc(parser->X, param_types,
+                                                     sizeof(char*) * param_count,
+                                                     sizeof(char*) * param_capacity);
             }
             
             /* 解析参数名 */
             consume(parser, TK_NAME, "期望参数名");
-            parameters[param_count] = token_to_string(&parser->previous);
+            parameters[param_count] = token_to_string(parser, &parser->previous);
             
             /* 解析参数类型（可选）*/
             if (match(parser, TK_COLON)) {
                 /* 类型可以是类型关键字或类名 */
                 if (match(parser, TK_TYPE_INT)) {
-                    param_types[param_count] = (char*)xmem_alloc(4);
+                    param_types[param_count] = (char*)xr_ast_alloc(parser->X, 4);
                     strcpy(param_types[param_count], "int");
                 } else if (match(parser, TK_TYPE_FLOAT)) {
-                    param_types[param_count] = (char*)xmem_alloc(6);
+                    param_types[param_count] = (char*)xr_ast_alloc(parser->X, 6);
                     strcpy(param_types[param_count], "float");
                 } else if (match(parser, TK_TYPE_STRING)) {
-                    param_types[param_count] = (char*)xmem_alloc(7);
+                    param_types[param_count] = (char*)xr_ast_alloc(parser->X, 7);
                     strcpy(param_types[param_count], "string");
                 } else if (match(parser, TK_BOOL)) {
-                    param_types[param_count] = (char*)xmem_alloc(5);
+                    param_types[param_count] = (char*)xr_ast_alloc(parser->X, 5);
                     strcpy(param_types[param_count], "bool");
                 } else if (match(parser, TK_NAME)) {
-                    param_types[param_count] = token_to_string(&parser->previous);
+                    param_types[param_count] = token_to_string(parser, &parser->previous);
                 } else {
                     error(parser, "期望类型名");
                     param_types[param_count] = NULL;
@@ -285,22 +281,22 @@ AstNode *xr_parse_method_declaration(Parser *parser, const char *name,
     if (match(parser, TK_COLON)) {
         /* 类型可以是类型关键字或类名 */
         if (match(parser, TK_TYPE_INT)) {
-            return_type = (char*)xmem_alloc(4);
+            return_type = (char*)xr_ast_alloc(parser->X, 4);
             strcpy(return_type, "int");
         } else if (match(parser, TK_TYPE_FLOAT)) {
-            return_type = (char*)xmem_alloc(6);
+            return_type = (char*)xr_ast_alloc(parser->X, 6);
             strcpy(return_type, "float");
         } else if (match(parser, TK_TYPE_STRING)) {
-            return_type = (char*)xmem_alloc(7);
+            return_type = (char*)xr_ast_alloc(parser->X, 7);
             strcpy(return_type, "string");
         } else if (match(parser, TK_BOOL)) {
-            return_type = (char*)xmem_alloc(5);
+            return_type = (char*)xr_ast_alloc(parser->X, 5);
             strcpy(return_type, "bool");
         } else if (match(parser, TK_VOID)) {
-            return_type = (char*)xmem_alloc(5);
+            return_type = (char*)xr_ast_alloc(parser->X, 5);
             strcpy(return_type, "void");
         } else if (match(parser, TK_NAME)) {
-            return_type = token_to_string(&parser->previous);
+            return_type = token_to_string(parser, &parser->previous);
         } else {
             error(parser, "期望返回类型名");
         }
@@ -332,7 +328,7 @@ AstNode *xr_parse_new_expression(Parser *parser) {
     
     /* 解析类名 */
     consume(parser, TK_NAME, "期望类名");
-    char *class_name = token_to_string(&parser->previous);
+    char *class_name = token_to_string(parser, &parser->previous);
     
     /* 解析构造参数 */
     consume(parser, TK_LPAREN, "期望'('开始参数列表");
@@ -346,9 +342,9 @@ AstNode *xr_parse_new_expression(Parser *parser) {
             /* 扩展数组 */
             if (arg_count >= arg_capacity) {
                 arg_capacity = arg_capacity == 0 ? 4 : arg_capacity * 2;
-                arguments = (AstNode**)xmem_realloc(arguments,
-                                                     sizeof(AstNode*) * arg_count,
-                                                     sizeof(AstNode*) * arg_capacity);
+                arguments = (AstNode**)xr_ast_realloc(parser->X, arguments,
+                                                      sizeof(AstNode*) * arg_count,
+                                                      sizeof(AstNode*) * arg_capacity);
             }
             
             /* 解析参数表达式 */
@@ -398,7 +394,7 @@ AstNode *xr_parse_super_expression(Parser *parser) {
     if (match(parser, TK_DOT)) {
         /* super.method() */
         consume(parser, TK_NAME, "期望方法名");
-        method_name = token_to_string(&parser->previous);
+        method_name = token_to_string(parser, &parser->previous);
         
         /* 解析参数列表 */
         consume(parser, TK_LPAREN, "期望'('开始参数列表");
@@ -419,9 +415,9 @@ AstNode *xr_parse_super_expression(Parser *parser) {
         do {
             if (arg_count >= arg_capacity) {
                 arg_capacity = arg_capacity == 0 ? 4 : arg_capacity * 2;
-                arguments = (AstNode**)xmem_realloc(arguments,
-                                                     sizeof(AstNode*) * arg_count,
-                                                     sizeof(AstNode*) * arg_capacity);
+                arguments = (AstNode**)xr_ast_realloc(parser->X, arguments,
+                                                      sizeof(AstNode*) * arg_count,
+                                                      sizeof(AstNode*) * arg_capacity);
             }
             arguments[arg_count++] = xr_parse_expression(parser);
         } while (match(parser, TK_COMMA));
@@ -461,7 +457,7 @@ AstNode *xr_parse_operator_method(Parser *parser, bool is_private, bool is_stati
     xr_parser_advance(parser);  /* 消费运算符 token */
     
     /* 运算符方法名就是符号本身 */
-    char *name = (char*)xmem_alloc(2);
+    char *name = (char*)xr_ast_alloc(parser->X, 2);
     strcpy(name, "+");
     
     /* 解析参数列表 */
@@ -480,9 +476,9 @@ AstNode *xr_parse_operator_method(Parser *parser, bool is_private, bool is_stati
     /* 解析第一个参数 */
     consume(parser, TK_NAME, "期望参数名");
     
-    parameters = (char**)xmem_alloc(sizeof(char*));
-    param_types = (char**)xmem_alloc(sizeof(char*));
-    parameters[0] = token_to_string(&parser->previous);
+    parameters = (char**)xr_ast_alloc(parser->X, sizeof(char*));
+    param_types = (char**)xr_ast_alloc(parser->X, sizeof(char*));
+    parameters[0] = token_to_string(parser, &parser->previous);
     
     /* 解析参数类型（可选）*/
     if (match(parser, TK_COLON)) {
@@ -490,7 +486,7 @@ AstNode *xr_parse_operator_method(Parser *parser, bool is_private, bool is_stati
         if (match(parser, TK_TYPE_INT) || match(parser, TK_TYPE_FLOAT) || 
             match(parser, TK_TYPE_STRING) || match(parser, TK_BOOL) ||
             match(parser, TK_NAME)) {
-            param_types[0] = token_to_string(&parser->previous);
+            param_types[0] = token_to_string(parser, &parser->previous);
         } else {
             error(parser, "期望类型名");
             param_types[0] = NULL;
@@ -513,16 +509,16 @@ AstNode *xr_parse_operator_method(Parser *parser, bool is_private, bool is_stati
     char *return_type = NULL;
     if (match(parser, TK_COLON)) {
         if (match(parser, TK_TYPE_INT)) {
-            return_type = (char*)xmem_alloc(4);
+            return_type = (char*)xr_ast_alloc(parser->X, 4);
             strcpy(return_type, "int");
         } else if (match(parser, TK_TYPE_FLOAT)) {
-            return_type = (char*)xmem_alloc(6);
+            return_type = (char*)xr_ast_alloc(parser->X, 6);
             strcpy(return_type, "float");
         } else if (match(parser, TK_TYPE_STRING)) {
-            return_type = (char*)xmem_alloc(7);
+            return_type = (char*)xr_ast_alloc(parser->X, 7);
             strcpy(return_type, "string");
         } else if (match(parser, TK_NAME)) {
-            return_type = token_to_string(&parser->previous);
+            return_type = token_to_string(parser, &parser->previous);
         } else {
             error(parser, "期望返回类型");
         }
@@ -3,6 +3,7 @@
 #include "xarray.h"
 #include "xmem.h"
 #include "xvalue.h"
+#include "xstring.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -27,13 +28,66 @@ static bool xr_value_equal(XrValue a, XrValue b) {
         case XR_TFLOAT:
             return xr_tofloat(a) == xr_tofloat(b);
         case XR_TSTRING:
-            // 简化：指针比较（实际应该比较字符串内容）
-            return xr_toobj(a) == xr_toobj(b);
+            /* 长字符串不驻留，按内容比较 */
+            return xr_string_equal(xr_tostring(a), xr_tostring(b));
         default:
             return xr_toobj(a) == xr_toobj(b);
     }
 }
 
+/* ====== 写时复制 ====== */
+
+/* 把独占的元素内存转为共享存储（复制/切片前调用） */
+static XrArrayStore* array_share(XrArray *arr) {
+    if (arr->shared == NULL) {
+        XrArrayStore *store = xmem_alloc(sizeof(XrArrayStore));
+        store->refcount = 1;
+        store->capacity = arr->capacity;
+        store->data = arr->elements;
+        arr->shared = store;
+        arr->capacity = arr->count;  // 共享后按视图处理
+    }
+    return arr->shared;
+}
+
+/* 释放对共享存储的引用，最后一个引用者负责释放内存 */
+static void array_store_release(XrArrayStore *store) {
+    if (--store->refcount == 0) {
+        xmem_free(store->data);
+        xmem_free(store);
+    }
+}
+
+/* 写入前分离：确保 arr 独占 elements */
+static void array_make_unique(XrArray *arr) {
+    XrArrayStore *store = arr->shared;
+    if (store == NULL) {
+        return;
+    }
+    
+    if (store->refcount == 1) {
+        /* 其他共享者都已释放：直接收回存储，切片视图移到开头 */
+        if (arr->elements != store->data && arr->count > 0) {
+            memmove(store->data, arr->elements, sizeof(XrValue) * arr->count);
+        }
+        arr->elements = store->data;
+        arr->capacity = store->capacity;
+        xmem_free(store);
+    } else {
+        size_t capacity = arr->count < XR_ARRAY_INIT_CAPACITY
+            ? XR_ARRAY_INIT_CAPACITY
+            : arr->count;
+        XrValue *data = xmem_alloc(sizeof(XrValue) * capacity);
+        if (arr->count > 0) {
+            memcpy(data, arr->elements, sizeof(XrValue) * arr->count);
+        }
+        store->refcount--;
+        arr->elements = data;
+        arr->capacity = capacity;
+    }
+    arr->shared = NULL;
+}
+
 /* ====== 创建和销毁 ====== */
 
 XrArray* xr_array_new(void) {
@@ -48,6 +102,7 @@ XrArray* xr_array_with_capacity(int capacity) {
     arr->count = 0;
     arr->capacity = capacity;
     arr->element_type = NULL;  // 暂不设置类型
+    arr->shared = NULL;
     
     // 分配元素数组
     if (capacity > 0) {
@@ -74,11 +129,14 @@ XrArray* xr_array_from_values(XrValue *elements, int count) {
 void xr_array_free(XrArray *arr) {
     if (!arr) return;
     
-    // 释放元素数组
-    if (arr->elements) {
+    // 释放元素数组（共享存储只减引用）
+    if (arr->shared) {
+        array_store_release(arr->shared);
+        arr->shared = NULL;
+    } else if (arr->elements) {
         xmem_free(arr->elements);
-        arr->elements = NULL;
     }
+    arr->elements = NULL;
     
     // 释放数组对象
     xmem_free(arr);
@@ -101,6 +159,8 @@ void xr_array_set(XrArray *arr, int index, XrValue value) {
         return;
     }
     
+    array_make_unique(arr);
+    
     // 如果索引超出当前count，需要扩展数组
     if (index >= arr->count) {
         // 确保容量足够
@@ -125,6 +185,8 @@ int xr_array_length(XrArray *arr) {
 /* ====== 修改数组 ====== */
 
 void xr_array_push(XrArray *arr, XrValue value) {
+    array_make_unique(arr);
+    
     // 确保容量足够
     if (arr->count >= arr->capacity) {
         xr_array_grow(arr);
@@ -145,6 +207,8 @@ XrValue xr_array_pop(XrArray *arr) {
 }
 
 void xr_array_unshift(XrArray *arr, XrValue value) {
+    array_make_unique(arr);
+    
     // 确保容量足够
     if (arr->count >= arr->capacity) {
         xr_array_grow(arr);
@@ -169,6 +233,14 @@ XrValue xr_array_shift(XrArray *arr) {
     // 保存第一个元素
     XrValue first = arr->elements[0];
     
+    // 共享视图：前移视图起点即可，无需写入共享存储
+    if (arr->shared) {
+        arr->elements++;
+        arr->count--;
+        arr->capacity--;
+        return first;
+    }
+    
     // 移动所有元素向前一位
     for (int i = 0; i < arr->count - 1; i++) {
         arr->elements[i] = arr->elements[i + 1];
@@ -179,6 +251,13 @@ XrValue xr_array_shift(XrArray *arr) {
 }
 
 void xr_array_clear(XrArray *arr) {
+    // 共享存储不必复制，直接放弃引用
+    if (arr->shared) {
+        array_store_release(arr->shared);
+        arr->shared = NULL;
+        arr->elements = NULL;
+        arr->capacity = 0;
+    }
     arr->count = 0;
 }
 
@@ -298,6 +377,8 @@ XrValue xr_array_reduce(XrArray *arr, XrFunction *callback, XrValue initial, str
 /* ====== 工具方法 ====== */
 
 void xr_array_reverse(XrArray *arr) {
+    array_make_unique(arr);
+    
     // 双指针交换
     int left = 0;
     int right = arr->count - 1;
@@ -314,7 +395,39 @@ void xr_array_reverse(XrArray *arr) {
 }
 
 XrArray* xr_array_copy(XrArray *arr) {
-    return xr_array_from_values(arr->elements, arr->count);
+    return xr_array_slice(arr, 0, (int)arr->count);
+}
+
+XrArray* xr_array_slice(XrArray *arr, int start, int end) {
+    int length = (int)arr->count;
+    
+    // 规范化索引（负数从末尾计数，越界截断）
+    if (start < 0) start += length;
+    if (end < 0) end += length;
+    if (start < 0) start = 0;
+    if (end > length) end = length;
+    if (start > length) start = length;
+    if (end < start) end = start;
+    
+    XrArray *view = xr_array_with_capacity(0);
+    view->element_type = arr->element_type;
+    if (end == start) {
+        return view;
+    }
+    
+    // 共享源数组的存储，只记录偏移和长度
+    XrArrayStore *store = array_share(arr);
+    store->refcount++;
+    view->shared = store;
+    view->elements = arr->elements + start;
+    view->count = end - start;
+    view->capacity = view->count;
+    
+    return view;
+}
+
+bool xr_array_is_shared(XrArray *arr) {
+    return arr->shared != NULL && arr->shared->refcount > 1;
 }
 
 void xr_array_print(XrArray *arr) {
@@ -330,6 +443,8 @@ void xr_array_print(XrArray *arr) {
 /* ====== 内部函数 ====== */
 
 void xr_array_grow(XrArray *arr) {
+    array_make_unique(arr);
+    
     // 计算新容量
     int new_capacity = arr->capacity == 0 
         ? XR_ARRAY_INIT_CAPACITY 
@@ -346,6 +461,8 @@ void xr_array_grow(XrArray *arr) {
 }
 
 void xr_array_ensure_capacity(XrArray *arr, int min_capacity) {
+    array_make_unique(arr);
+    
     if (arr->capacity >= min_capacity) {
         return;
     }
@@ -371,49 +488,83 @@ void xr_array_ensure_capacity(XrArray *arr, int min_capacity) {
 }
 
 
+/* 非字符串、非数字元素的文本 */
+static const char *join_literal(XrValue val, size_t *len) {
+    if (xr_isbool(val)) {
+        *len = xr_tobool(val) ? 4 : 5;
+        return xr_tobool(val) ? "true" : "false";
+    }
+    if (xr_isnull(val)) {
+        *len = 4;
+        return "null";
+    }
+    *len = 8;
+    return "[object]";
+}
+
+/* 元素文本长度（浮点数取上界，避免格式化两次） */
+static size_t join_part_length(XrValue val) {
+    if (xr_isstring(val)) return xr_tostring(val)->length;
+    if (xr_isint(val)) return xr_format_int_length(xr_toint(val));
+    if (xr_isfloat(val)) return XR_FLOAT_BUFSIZE;
+    
+    size_t len;
+    join_literal(val, &len);
+    return len;
+}
+
+/* 把元素文本写入dst，返回写入的字节数 */
+static size_t join_part_write(XrValue val, char *dst) {
+    if (xr_isstring(val)) {
+        struct XrString *str = xr_tostring(val);
+        memcpy(dst, xr_string_data(str), str->length);
+        return str->length;
+    }
+    if (xr_isint(val)) return xr_format_int(dst, xr_toint(val));
+    if (xr_isfloat(val)) return xr_format_float(dst, xr_tofloat(val));
+    
+    size_t len;
+    const char *text = join_literal(val, &len);
+    memcpy(dst, text, len);
+    return len;
+}
+
 /*
  * 用分隔符连接数组元素为字符串（v0.10.0新增）
+ * 两遍实现：先算总长度，再写入同一块缓冲区，最后只生成一次结果。
+ * 不产生中间字符串，时间与结果长度成线性关系。
  */
 struct XrString* xr_array_join(XrArray *arr, struct XrString *delimiter) {
-    extern struct XrString* xr_string_intern(const char *chars, size_t length, uint32_t hash);
-    extern struct XrString* xr_string_concat(struct XrString *a, struct XrString *b);
-    extern struct XrString* xr_string_from_int(xr_Integer i);
-    extern struct XrString* xr_string_from_float(xr_Number n);
-    
     if (arr == NULL || arr->count == 0) {
         return xr_string_intern("", 0, 0);
     }
     
-    struct XrString *result = xr_string_intern("", 0, 0);
+    size_t delim_len = (delimiter != NULL) ? delimiter->length : 0;
+    const char *delim_chars = (delimiter != NULL) ? xr_string_data(delimiter) : NULL;
     
+    /* 第一遍：总长度（格式化数字时需要结尾\0的空间） */
+    size_t total = delim_len * (arr->count - 1);
     for (size_t i = 0; i < arr->count; i++) {
-        XrValue val = arr->elements[i];
-        struct XrString *str_part = NULL;
-        
-        if (xr_isstring(val)) {
-            str_part = xr_tostring(val);
-        } else if (xr_isint(val)) {
-            str_part = xr_string_from_int(xr_toint(val));
-        } else if (xr_isfloat(val)) {
-            str_part = xr_string_from_float(xr_tofloat(val));
-        } else if (xr_isbool(val)) {
-            str_part = xr_tobool(val) ? 
-                xr_string_intern("true", 4, 0) : 
-                xr_string_intern("false", 5, 0);
-        } else if (xr_isnull(val)) {
-            str_part = xr_string_intern("null", 4, 0);
-        } else {
-            str_part = xr_string_intern("[object]", 8, 0);
-        }
-        
-        if (str_part != NULL) {
-            result = xr_string_concat(result, str_part);
-        }
-        
-        if (i < arr->count - 1 && delimiter != NULL) {
-            result = xr_string_concat(result, delimiter);
+        total += join_part_length(arr->elements[i]);
+    }
+    size_t capacity = total + XR_INT_BUFSIZE;
+    
+    /* 第二遍：直接写入字符串缓冲区 */
+    char *buffer = xr_string_buffer_new(capacity);
+    char *p = buffer;
+    for (size_t i = 0; i < arr->count; i++) {
+        if (i > 0 && delim_len > 0) {
+            memcpy(p, delim_chars, delim_len);
+            p += delim_len;
         }
+        p += join_part_write(arr->elements[i], p);
     }
+    size_t length = (size_t)(p - buffer);
     
-    return result;
+    /* 浮点数按上界估算，多出的空间归还 */
+    if (length < capacity) {
+        buffer = xr_string_buffer_resize(buffer, capacity, length);
+    }
+    
+    return xr_string_make_take(buffer, length);
 }
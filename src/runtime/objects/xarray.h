@@ -24,6 +24,18 @@ struct XSymbolTable;
 /* 数组初始容量 */
 #define XR_ARRAY_INIT_CAPACITY 8
 
+/* 共享后备存储（写时复制）
+ *
+ * xr_array_copy 和 xr_array_slice 不再复制元素，而是让新数组
+ * 引用同一块存储，并对存储计数。任何写操作前先分离（见 xarray.c
+ * 中的 array_make_unique），只有真正写入的一方才付出复制代价。
+ */
+typedef struct XrArrayStore {
+    uint32_t refcount;          // 共享该存储的数组数量
+    size_t capacity;            // data 的容量
+    XrValue *data;              // 元素内存
+} XrArrayStore;
+
 /* 数组对象结构
  * 
  * 内存布局：
@@ -34,12 +46,17 @@ struct XSymbolTable;
  * | count          | (当前元素数量)
  * | capacity       | (当前容量)
  * | element_type   | (元素类型信息，可选)
+ * | shared         | (共享存储，独占时为 NULL)
  * +----------------+
  * 
  * 扩容策略：
  * - 初始容量：8
  * - 扩容倍数：2x
  * - 不收缩（简化实现）
+ *
+ * 共享视图：
+ * - shared 非空时 elements 指向 shared->data + 偏移，count 为视图长度
+ * - 视图的 capacity 等于 count，写入/扩容前必须先分离
  */
 typedef struct {
     XrObject header;            // GC对象头（预留）
@@ -47,7 +64,8 @@ typedef struct {
     // 数组数据
     size_t capacity;            // 当前容量
     size_t count;               // 当前元素数量
-    XrValue *elements;          // 元素数组（动态分配）
+    XrValue *elements;          // 元素数组（动态分配，或指向共享存储）
+    XrArrayStore *shared;       // 共享存储（写时复制，NULL 表示独占）
     
     // 类型信息（可选，用于类型检查）
     XrTypeInfo *element_type;   // 元素类型
@@ -233,10 +251,28 @@ void xr_array_reverse(XrArray *arr);
 /**
  * 复制数组
  * @param arr 源数组
- * @return 新的数组（深拷贝元素）
+ * @return 新的数组（与源数组共享存储，写时复制）
+ * @note O(1)，首次写入任意一方时才复制元素
  */
 XrArray* xr_array_copy(XrArray *arr);
 
+/**
+ * 创建数组切片 [start, end)
+ * @param arr 源数组
+ * @param start 起始索引（负数从末尾计数）
+ * @param end 结束索引（不包含，负数从末尾计数）
+ * @return 新的数组（源数组存储上的偏移+长度视图，写时复制）
+ * @note 越界索引会被截断到 [0, length]
+ */
+XrArray* xr_array_slice(XrArray *arr, int start, int end);
+
+/**
+ * 检查数组是否与其他数组共享存储
+ * @param arr 数组
+ * @return true 如果写入前需要复制
+ */
+bool xr_array_is_shared(XrArray *arr);
+
 /**
  * 打印数组内容（调试用）
  * @param arr 数组
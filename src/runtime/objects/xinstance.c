@@ -9,6 +9,7 @@
 #include "xclass.h"
 #include "xmethod.h"
 #include "xmem.h"
+#include "xslab.h"
 #include "xobject.h"
 /* xeval.h 已废弃，使用字节码VM */
 #include "xstring.h"  /* 需要完整的XrString定义 */
@@ -26,7 +27,7 @@ XrInstance* xr_instance_new(XrayState *X, XrClass *cls) {
     
     /* 分配实例内存：头部 + 字段数组 */
     size_t size = sizeof(XrInstance) + sizeof(XrValue) * cls->field_count;
-    XrInstance *inst = (XrInstance*)gc_alloc(size, OBJ_INSTANCE);
+    XrInstance *inst = (XrInstance*)xr_slab_alloc(size);
     
     /* 初始化对象头（XrObject不包含嵌套的gc字段）*/
     xr_object_init(&inst->header, XR_TINSTANCE, NULL);
@@ -49,7 +50,7 @@ void xr_instance_free(XrInstance *inst) {
     if (!inst) return;
     
     /* 字段值释放由GC管理，这里只释放实例本身 */
-    xmem_free(inst);
+    xr_slab_free(inst);
 }
 
 /*
@@ -223,7 +224,8 @@ void xr_instance_print(XrInstance *inst) {
         } else if (xr_isfloat(val)) {
             printf("%g", xr_tofloat(val));
         } else if (xr_isstring(val)) {
-            printf("\"%s\"", xr_tostring(val)->chars);
+            XrString *str = xr_tostring(val);
+            printf("\"%.*s\"", (int)str->length, xr_string_data(str));
         } else {
             printf("<object>");
         }
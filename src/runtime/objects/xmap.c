@@ -1,6 +1,24 @@
 /* xmap.c - Map字典实现
- * 
+ *
  * 第11阶段 - Map字典实现
+ *
+ * 探测方式（Swiss Table风格）：
+ *   控制字节独立存放在ctrl数组中，查找时一次载入16个控制字节，
+ *   与短哈希并行比较得到匹配位图，只有位图中的槽位才去比较键。
+ *   分组中出现空槽位即可判定键不存在。
+ *
+ * 紧凑布局（CPython风格）：
+ *   条目按插入顺序追加到稠密的entries数组，槽位只保存条目下标。
+ *   迭代直接扫描entries，代价与元素数量成正比，顺序确定。
+ *
+ * 数组部分（Lua风格）：
+ *   连续整数键0..n-1存放在array中，访问时不计算哈希、不探测。
+ *
+ * 渐进式扩容：
+ *   扩容时只分配新索引表，旧索引表保留。之后每次get/set/delete
+ *   把固定数量的条目迁入新表（使用条目中保存的完整哈希），
+ *   查找先查新表、再查旧表。条目数组在两张表之间共享，
+ *   条目下标在迁移期间保持不变，因此更新和删除对两张表同时可见。
  */
 
 #include "xmap.h"
@@ -8,30 +26,150 @@
 #include "xobject.h"
 #include "xmem.h"
 #include "xarray.h"  /* 用于keys/values/entries */
+#include "xstring.h"
 #include <string.h>
 #include <stdio.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define XR_MAP_USE_SSE2 1
+#else
+  #define XR_MAP_USE_SSE2 0
+#endif
+
+/* ========== 分组操作 ========== */
+
+/*
+** 分组位图：第i位为1表示分组中第i个控制字节满足条件
+*/
+typedef uint32_t GroupMask;
+
+/**
+ * 匹配短哈希
+ */
+static inline GroupMask group_match(const uint8_t *group, uint8_t sh) {
+#if XR_MAP_USE_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    __m128i cmp = _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)sh));
+    return (GroupMask)_mm_movemask_epi8(cmp);
+#else
+    GroupMask mask = 0;
+    for (int i = 0; i < XR_MAP_GROUP_WIDTH; i++) {
+        if (group[i] == sh) mask |= (GroupMask)1 << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * 匹配空槽位
+ */
+static inline GroupMask group_match_empty(const uint8_t *group) {
+    return group_match(group, XR_MAP_EMPTY);
+}
+
+/**
+ * 匹配可插入槽位（空槽位或墓碑，即bit7为0）
+ */
+static inline GroupMask group_match_available(const uint8_t *group) {
+#if XR_MAP_USE_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (GroupMask)(~_mm_movemask_epi8(ctrl) & 0xFFFF);
+#else
+    GroupMask mask = 0;
+    for (int i = 0; i < XR_MAP_GROUP_WIDTH; i++) {
+        if (group[i] < XR_MAP_VALID) mask |= (GroupMask)1 << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * 位图中最低位的下标（mask非0）
+ */
+static inline uint32_t mask_lowest(GroupMask mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(mask);
+#else
+    uint32_t i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
 /* ========== 辅助函数 ========== */
 
 /**
- * 检查条目是否为空
+ * 检查条目是否有效（未删除）
+ */
+static inline bool entry_is_live(const XrMapEntry *entry) {
+    return entry->hash != 0;
+}
+
+/**
+ * 计算键的哈希（0保留给已删除条目）
  */
-static inline bool entry_is_empty(XrMapEntry *entry) {
-    return entry->state == XR_MAP_EMPTY;
+static inline uint32_t entry_hash(XrValue key) {
+    uint32_t hash = xr_hash_value(key);
+    return hash == 0 ? 1 : hash;
 }
 
 /**
- * 检查条目是否为墓碑
+ * 容量对应的条目数组大小
  */
-static inline bool entry_is_tombstone(XrMapEntry *entry) {
-    return entry->state == XR_MAP_TOMBSTONE;
+static inline uint32_t usable_for(uint32_t capacity) {
+    return (uint32_t)(capacity * XR_MAP_LOAD_FACTOR);
 }
 
 /**
- * 检查条目是否有效
+ * 容量对应的索引宽度（条目下标 < usable）
  */
-static inline bool entry_is_valid(XrMapEntry *entry) {
-    return entry->state >= XR_MAP_VALID;
+static inline uint8_t index_width_for(uint32_t capacity) {
+    if (capacity <= 0x100) return 1;
+    if (capacity <= 0x10000) return 2;
+    return 4;
+}
+
+/**
+ * 读取槽位中的条目下标
+ */
+static inline uint32_t index_get(const void *index, uint8_t width, uint32_t slot) {
+    switch (width) {
+        case 1:  return ((const uint8_t *)index)[slot];
+        case 2:  return ((const uint16_t *)index)[slot];
+        default: return ((const uint32_t *)index)[slot];
+    }
+}
+
+/**
+ * 写入槽位中的条目下标
+ */
+static inline void index_set(void *index, uint8_t width, uint32_t slot, uint32_t entry_index) {
+    switch (width) {
+        case 1:  ((uint8_t *)index)[slot] = (uint8_t)entry_index; break;
+        case 2:  ((uint16_t *)index)[slot] = (uint16_t)entry_index; break;
+        default: ((uint32_t *)index)[slot] = entry_index; break;
+    }
+}
+
+/**
+ * 设置控制字节（同步镜像区）
+ */
+static inline void set_ctrl(uint8_t *ctrl, uint32_t capacity, uint32_t index, uint8_t value) {
+    ctrl[index] = value;
+    if (index < XR_MAP_GROUP_WIDTH - 1) {
+        ctrl[capacity + index] = value;
+    }
+}
+
+/**
+ * 控制字节数组长度
+ */
+static inline size_t ctrl_size(uint32_t capacity) {
+    return (size_t)capacity + XR_MAP_GROUP_WIDTH - 1;
 }
 
 /**
@@ -50,6 +188,33 @@ static uint32_t next_capacity(uint32_t current) {
     return current * XR_MAP_GROW_FACTOR;
 }
 
+/**
+ * 在控制字节数组中找到第一个可插入槽位
+ */
+static uint32_t find_insert_slot(const uint8_t *ctrl, uint32_t capacity, uint32_t hash) {
+    uint32_t mask = capacity - 1;
+    uint32_t pos = hash & mask;
+    
+    for (;;) {
+        GroupMask avail = group_match_available(ctrl + pos);
+        if (avail != 0) {
+            return (pos + mask_lowest(avail)) & mask;
+        }
+        pos = (pos + XR_MAP_GROUP_WIDTH) & mask;
+    }
+}
+
+/*
+** 容纳count个元素而无需扩容的最小容量
+*/
+static uint32_t capacity_for(uint32_t count) {
+    uint32_t capacity = XR_MAP_MIN_CAPACITY;
+    while (count > capacity * XR_MAP_LOAD_FACTOR) {
+        capacity *= XR_MAP_GROW_FACTOR;
+    }
+    return capacity;
+}
+
 /* ========== 创建和销毁 ========== */
 
 XrMap* xr_map_new(void) {
@@ -57,62 +222,139 @@ XrMap* xr_map_new(void) {
     
     map->capacity = 0;
     map->count = 0;
+    map->used = 0;
+    map->usable = 0;
     map->entries = NULL;
+    map->index = NULL;
+    map->ctrl = NULL;
+    map->index_width = 1;
+    map->old_index = NULL;
+    map->old_ctrl = NULL;
+    map->old_capacity = 0;
+    map->old_index_width = 1;
+    map->migrate_pos = 0;
+    map->migrate_end = 0;
+    map->array = NULL;
+    map->array_bits = NULL;
+    map->array_size = 0;
+    map->array_count = 0;
+    map->array_capacity = 0;
     map->flags = 0;
-    map->gc_data = NULL;
     
     return map;
 }
 
+XrMap* xr_map_with_capacity(uint32_t count) {
+    XrMap *map = xr_map_new();
+    if (count == 0) {
+        return map;
+    }
+    
+    /* 找到满足负载因子的最小2的幂容量 */
+    xr_map_resize(map, capacity_for(count));
+    return map;
+}
+
+XrMap* xr_map_new_weak(void) {
+    XrMap *map = xr_map_new();
+    map->flags |= XR_MAP_FLAG_WEAK;
+    return map;
+}
+
 void xr_map_free(XrMap *map) {
     if (map->entries != NULL) {
         xmem_free(map->entries);
     }
+    /* ctrl与index同一次分配 */
+    if (map->index != NULL) {
+        xmem_free(map->index);
+    }
+    if (map->old_index != NULL) {
+        xmem_free(map->old_index);
+    }
+    if (map->array != NULL) {
+        xmem_free(map->array);
+        xmem_free(map->array_bits);
+    }
     xr_free_object(map);
 }
 
-/* ========== 小Map线性扫描 ========== */
+/* ========== 核心查找算法 ========== */
 
-XrMapEntry* xr_map_find_linear(XrMap *map, XrValue key, uint32_t *out_index) {
-    /* 空Map */
-    if (map->capacity == 0) {
-        *out_index = 0;
-        return NULL;
-    }
-    
-    uint32_t first_empty = UINT32_MAX;
-    uint32_t first_tombstone = UINT32_MAX;
+/*
+** 在一张索引表中分组探测
+** 找到返回条目并输出其槽位，否则输出第一个可插入槽位
+*/
+static XrMapEntry* probe_table(XrMap *map, const uint8_t *ctrl, const void *index,
+                               uint8_t width, uint32_t capacity,
+                               XrValue key, uint32_t hash, uint32_t *out_slot) {
+    uint8_t sh = xr_short_hash(hash);
+    uint32_t mask = capacity - 1;
+    uint32_t pos = hash & mask;
+    uint32_t insert_slot = UINT32_MAX;
     
-    /* 线性扫描所有槽位 */
-    for (uint32_t i = 0; i < map->capacity; i++) {
-        XrMapEntry *entry = &map->entries[i];
+    for (;;) {
+        const uint8_t *group = ctrl + pos;
         
-        if (entry_is_empty(entry)) {
-            /* 记录第一个空槽位 */
-            if (first_empty == UINT32_MAX) {
-                first_empty = i;
+        /* 只在短哈希匹配的槽位访问条目 */
+        GroupMask match = group_match(group, sh);
+        while (match != 0) {
+            uint32_t slot = (pos + mask_lowest(match)) & mask;
+            XrMapEntry *entry = &map->entries[index_get(index, width, slot)];
+            if (entry->hash == hash && xr_map_keys_equal(entry->key, key)) {
+                *out_slot = slot;
+                return entry;
             }
-            /* 遇到空槽位停止查找（未找到） */
-            *out_index = (first_tombstone != UINT32_MAX) ? first_tombstone : first_empty;
-            return NULL;
-        } else if (entry_is_tombstone(entry)) {
-            /* 记录第一个墓碑 */
-            if (first_tombstone == UINT32_MAX) {
-                first_tombstone = i;
+            match &= match - 1;
+        }
+        
+        /* 记录第一个可插入位置（墓碑或空槽位） */
+        if (insert_slot == UINT32_MAX) {
+            GroupMask avail = group_match_available(group);
+            if (avail != 0) {
+                insert_slot = (pos + mask_lowest(avail)) & mask;
             }
-        } else if (xr_map_keys_equal(entry->key, key)) {
-            /* 找到匹配的键 */
-            *out_index = i;
-            return entry;
         }
+        
+        /* 分组中有空槽位：未找到 */
+        if (group_match_empty(group) != 0) {
+            *out_slot = insert_slot;
+            return NULL;
+        }
+        
+        pos = (pos + XR_MAP_GROUP_WIDTH) & mask;
     }
+}
+
+/*
+** 以已知哈希值查找（调用者保证map->capacity > 0）
+** out_index输出新表中的槽位（找到时）或新表中的可插入槽位；
+** 条目只在迁移中的旧表里找到时，out_old_slot输出旧表槽位，否则为UINT32_MAX
+*/
+static XrMapEntry* find_entry_full(XrMap *map, XrValue key, uint32_t hash,
+                                   uint32_t *out_index, uint32_t *out_old_slot) {
+    if (out_old_slot) *out_old_slot = UINT32_MAX;
     
-    /* 未找到，返回可插入位置 */
-    *out_index = (first_tombstone != UINT32_MAX) ? first_tombstone : first_empty;
-    return NULL;
+    XrMapEntry *entry = probe_table(map, map->ctrl, map->index, map->index_width,
+                                    map->capacity, key, hash, out_index);
+    if (entry != NULL || map->old_index == NULL) {
+        return entry;
+    }
+    
+    /* 尚未迁移的条目还在旧表中 */
+    uint32_t old_slot;
+    entry = probe_table(map, map->old_ctrl, map->old_index, map->old_index_width,
+                        map->old_capacity, key, hash, &old_slot);
+    if (entry != NULL && out_old_slot) {
+        *out_old_slot = old_slot;
+    }
+    return entry;
 }
 
-/* ========== 核心查找算法 ========== */
+static inline XrMapEntry* find_entry_hashed(XrMap *map, XrValue key, uint32_t hash,
+                                            uint32_t *out_index) {
+    return find_entry_full(map, key, hash, out_index, NULL);
+}
 
 XrMapEntry* xr_map_find_entry(XrMap *map, XrValue key, uint32_t *out_index) {
     /* 空Map */
@@ -121,123 +363,424 @@ XrMapEntry* xr_map_find_entry(XrMap *map, XrValue key, uint32_t *out_index) {
         return NULL;
     }
     
-    /* 小Map优化：使用线性扫描 */
-    if (map->count <= XR_MAP_SMALL_SIZE) {
-        return xr_map_find_linear(map, key, out_index);
+    return find_entry_hashed(map, key, entry_hash(key), out_index);
+}
+
+/* ========== 扩容 ========== */
+
+/*
+** 分配索引表和控制字节（一次分配），控制字节初始化为空
+*/
+static void* alloc_index_block(uint32_t capacity, uint8_t width, uint8_t **out_ctrl) {
+    size_t index_size = (size_t)capacity * width;
+    uint8_t *block = (uint8_t*)xmem_alloc(index_size + ctrl_size(capacity));
+    *out_ctrl = block + index_size;
+    memset(*out_ctrl, XR_MAP_EMPTY, ctrl_size(capacity));
+    return block;
+}
+
+/*
+** 结束迁移，释放旧索引表
+*/
+static void drop_old_table(XrMap *map) {
+    if (map->old_index != NULL) {
+        xmem_free(map->old_index);
+        map->old_index = NULL;
+        map->old_ctrl = NULL;
+        map->old_capacity = 0;
     }
-    
-    /* 计算哈希和短哈希 */
-    uint32_t hash = xr_hash_value(key);
-    uint8_t sh = xr_short_hash(hash);
-    
-    /* 使用位运算代替模运算（capacity是2的幂） */
-    uint32_t index = hash & (map->capacity - 1);
-    uint32_t tombstone_index = UINT32_MAX;
-    
-    /* 线性探测 */
-    for (;;) {
-        XrMapEntry *entry = &map->entries[index];
+    map->migrate_pos = 0;
+    map->migrate_end = 0;
+}
+
+/*
+** 把至多budget个条目从旧表迁入新表
+*/
+static void map_migrate(XrMap *map, uint32_t budget) {
+    while (budget > 0 && map->migrate_pos < map->migrate_end) {
+        uint32_t i = map->migrate_pos++;
+        XrMapEntry *entry = &map->entries[i];
         
-        if (entry_is_empty(entry)) {
-            /* 空槽位：未找到 */
-            *out_index = (tombstone_index != UINT32_MAX) ? tombstone_index : index;
-            return NULL;
-        } else if (entry_is_tombstone(entry)) {
-            /* 墓碑：记录但继续查找 */
-            if (tombstone_index == UINT32_MAX) {
-                tombstone_index = index;
-            }
-        } else if (entry->state == sh) {
-            /* 短哈希匹配：进一步比较键 */
-            if (xr_map_keys_equal(entry->key, key)) {
-                *out_index = index;
-                return entry;
-            }
+        /* 已删除的条目不迁移；哈希已保存，无需重新计算 */
+        if (entry_is_live(entry)) {
+            uint32_t slot = find_insert_slot(map->ctrl, map->capacity, entry->hash);
+            set_ctrl(map->ctrl, map->capacity, slot, xr_short_hash(entry->hash));
+            index_set(map->index, map->index_width, slot, i);
         }
-        
-        /* 继续探测下一个位置 */
-        index = (index + 1) & (map->capacity - 1);
+        budget--;
+    }
+    
+    if (map->migrate_pos >= map->migrate_end) {
+        drop_old_table(map);
     }
 }
 
-/* ========== 扩容 ========== */
+/*
+** 每次操作推进一步迁移
+*/
+static inline void migrate_step(XrMap *map) {
+    if (map->old_index != NULL) {
+        map_migrate(map, XR_MAP_MIGRATE_STEP);
+    }
+}
 
-void xr_map_resize(XrMap *map, uint32_t new_capacity) {
-    /* 分配新的条目数组 */
-    XrMapEntry *new_entries = (XrMapEntry*)xmem_alloc(
-        sizeof(XrMapEntry) * new_capacity
+/*
+** 开始渐进式扩容：新索引表立即生效，旧表保留到迁移完成
+*/
+static void map_begin_grow(XrMap *map, uint32_t new_capacity) {
+    /* 上一次迁移尚未完成（极少发生）：先完成它 */
+    if (map->old_index != NULL) {
+        map_migrate(map, UINT32_MAX);
+    }
+    
+    /* 条目数组扩大但不压缩，条目下标保持不变 */
+    uint32_t new_usable = usable_for(new_capacity);
+    map->entries = (XrMapEntry*)xmem_realloc(
+        map->entries,
+        sizeof(XrMapEntry) * map->usable,
+        sizeof(XrMapEntry) * new_usable
     );
     
-    /* 初始化为空 */
-    memset(new_entries, 0, sizeof(XrMapEntry) * new_capacity);
+    /* 当前表转为旧表 */
+    map->old_index = map->index;
+    map->old_ctrl = map->ctrl;
+    map->old_capacity = map->capacity;
+    map->old_index_width = map->index_width;
+    map->migrate_pos = 0;
+    map->migrate_end = map->used;
+    
+    /* 新表 */
+    uint8_t width = index_width_for(new_capacity);
+    map->index = alloc_index_block(new_capacity, width, &map->ctrl);
+    map->index_width = width;
+    map->capacity = new_capacity;
+    map->usable = new_usable;
     
-    /* 保存旧数据 */
-    XrMapEntry *old_entries = map->entries;
-    uint32_t old_capacity = map->capacity;
+    /* 空表无需迁移 */
+    if (map->migrate_end == 0) {
+        drop_old_table(map);
+    }
+}
+
+void xr_map_resize(XrMap *map, uint32_t new_capacity) {
+    /* 一次性重建：完全依据条目数组，迁移中的旧表直接丢弃 */
+    drop_old_table(map);
+    
+    /* 分配新的索引表和控制字节 */
+    uint8_t width = index_width_for(new_capacity);
+    uint8_t *new_ctrl;
+    void *block = alloc_index_block(new_capacity, width, &new_ctrl);
+    
+    /* 压缩已删除条目（保持插入顺序） */
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < map->used; i++) {
+        if (entry_is_live(&map->entries[i])) {
+            if (live != i) {
+                map->entries[live] = map->entries[i];
+            }
+            live++;
+        }
+    }
+    
+    /* 调整条目数组 */
+    uint32_t new_usable = usable_for(new_capacity);
+    map->entries = (XrMapEntry*)xmem_realloc(
+        map->entries,
+        sizeof(XrMapEntry) * map->usable,
+        sizeof(XrMapEntry) * new_usable
+    );
+    
+    /* 释放旧索引表 */
+    if (map->index != NULL) {
+        xmem_free(map->index);
+    }
     
     /* 更新Map */
-    map->entries = new_entries;
+    map->index = block;
+    map->ctrl = new_ctrl;
+    map->index_width = width;
     map->capacity = new_capacity;
-    map->count = 0;  /* 重新计数 */
+    map->usable = new_usable;
+    map->used = live;
+    map->count = live + map->array_count;
     
-    /* 重新插入所有有效条目（清理墓碑） */
-    if (old_entries != NULL) {
-        for (uint32_t i = 0; i < old_capacity; i++) {
-            XrMapEntry *old_entry = &old_entries[i];
-            
-            if (entry_is_valid(old_entry)) {
-                /* 在新表中查找位置 */
-                uint32_t hash = xr_hash_value(old_entry->key);
-                uint8_t sh = xr_short_hash(hash);
-                uint32_t index = hash & (new_capacity - 1);
-                
-                /* 线性探测找到空位 */
-                while (new_entries[index].state != XR_MAP_EMPTY) {
-                    index = (index + 1) & (new_capacity - 1);
-                }
-                
-                /* 插入 */
-                new_entries[index].state = sh;
-                new_entries[index].key = old_entry->key;
-                new_entries[index].value = old_entry->value;
-                map->count++;
-            }
+    /* 用保存的完整哈希重建索引，无需重新计算 */
+    for (uint32_t i = 0; i < live; i++) {
+        uint32_t hash = map->entries[i].hash;
+        uint32_t slot = find_insert_slot(new_ctrl, new_capacity, hash);
+        set_ctrl(new_ctrl, new_capacity, slot, xr_short_hash(hash));
+        index_set(block, width, slot, i);
+    }
+}
+
+/* ========== 哈希部分 ========== */
+
+/*
+** 插入前保证条目数组有空位
+** （每个槽位墓碑都对应一个已删除条目，used同时约束了探测负载）
+** 返回是否换了索引表：之前探测到的槽位失效，需要重新探测
+*/
+static bool ensure_insert_room(XrMap *map) {
+    if (map->used < map->usable) {
+        return false;
+    }
+    
+    /* 主要是已删除条目时原容量重建并压缩，否则渐进式扩容 */
+    uint32_t hash_count = map->count - map->array_count;
+    if (map->capacity > 0 && hash_count + 1 <= map->usable / 2) {
+        xr_map_resize(map, map->capacity);
+    } else {
+        map_begin_grow(map, next_capacity(map->capacity));
+    }
+    return true;
+}
+
+/*
+** 新键的存放形式：切片字符串换成内联副本，Map不替它留住父串
+** 副本继承Map的标记位：调用者的写屏障看到的是切片而不是副本，
+** 这样老年代/已标记的Map不会指向未标记的字符串
+*/
+static XrValue map_own_key(XrMap *map, XrValue key) {
+    if (!xr_isstring(key) || !xr_string_is_slice(xr_tostring(key))) {
+        return key;
+    }
+    XrString *flat = xr_string_flatten(xr_tostring(key));
+    flat->header.marked = ((XrObject*)map)->marked;
+    return xr_string_value(flat);
+}
+
+/*
+** 在哈希部分插入或更新（hash为0表示尚未计算）
+*/
+static void map_set_hashed(XrMap *map, XrValue key, uint32_t hash, XrValue value) {
+    migrate_step(map);
+    
+    if (hash == 0) {
+        hash = entry_hash(key);
+    }
+    
+    /* 先查找：更新已有键不占新条目，不会触发重建或扩容 */
+    uint32_t slot = 0;
+    XrMapEntry *entry = (map->capacity > 0)
+                      ? find_entry_hashed(map, key, hash, &slot) : NULL;
+    if (entry != NULL) {
+        entry->value = value;
+        return;
+    }
+    
+    /* 新键：保证有空位，换了索引表就在新表中重新探测插入位置 */
+    if (ensure_insert_room(map)) {
+        find_entry_hashed(map, key, hash, &slot);
+    }
+    
+    /* 追加到条目数组末尾 */
+    uint32_t entry_index = map->used++;
+    entry = &map->entries[entry_index];
+    entry->key = map_own_key(map, key);
+    entry->value = value;
+    entry->hash = hash;
+    
+    set_ctrl(map->ctrl, map->capacity, slot, xr_short_hash(hash));
+    index_set(map->index, map->index_width, slot, entry_index);
+    map->count++;
+}
+
+/*
+** 从哈希部分移除已找到的条目
+*/
+static void map_remove_entry(XrMap *map, XrMapEntry *entry, uint32_t slot,
+                             uint32_t old_slot) {
+    /* 槽位标记为墓碑，条目标记为已删除（重建时压缩） */
+    if (old_slot != UINT32_MAX) {
+        /* 条目尚未迁移：墓碑留在旧表，迁移时跳过已删除条目 */
+        set_ctrl(map->old_ctrl, map->old_capacity, old_slot, XR_MAP_TOMBSTONE);
+    } else {
+        set_ctrl(map->ctrl, map->capacity, slot, XR_MAP_TOMBSTONE);
+    }
+    entry->key = xr_null();
+    entry->value = xr_null();
+    entry->hash = 0;
+    map->count--;
+}
+
+/*
+** 哈希部分是否为空
+*/
+static inline bool hash_part_empty(XrMap *map) {
+    return map->count == map->array_count;
+}
+
+/* ========== 数组部分 ========== */
+
+/**
+ * 判断键是否可作为数组部分下标（非负整数）
+ */
+static inline bool array_index(XrValue key, uint32_t *out) {
+    if (!xr_isint(key)) {
+        return false;
+    }
+    xr_Integer k = xr_toint(key);
+    if (k < 0 || k >= (xr_Integer)UINT32_MAX) {
+        return false;
+    }
+    *out = (uint32_t)k;
+    return true;
+}
+
+static inline bool array_has(const XrMap *map, uint32_t i) {
+    return (map->array_bits[i >> 5] >> (i & 31)) & 1;
+}
+
+static inline void array_mark(XrMap *map, uint32_t i) {
+    map->array_bits[i >> 5] |= (uint32_t)1 << (i & 31);
+}
+
+static inline void array_unmark(XrMap *map, uint32_t i) {
+    map->array_bits[i >> 5] &= ~((uint32_t)1 << (i & 31));
+}
+
+/*
+** 数组部分扩容（翻倍）
+*/
+static void array_grow(XrMap *map) {
+    uint32_t old_cap = map->array_capacity;
+    uint32_t new_cap = old_cap == 0 ? XR_MAP_ARRAY_INIT_CAPACITY : old_cap * 2;
+    size_t old_words = (old_cap + 31) / 32;
+    size_t new_words = (new_cap + 31) / 32;
+    
+    map->array = (XrValue*)xmem_realloc(
+        map->array,
+        sizeof(XrValue) * old_cap,
+        sizeof(XrValue) * new_cap
+    );
+    map->array_bits = (uint32_t*)xmem_realloc(
+        map->array_bits,
+        sizeof(uint32_t) * old_words,
+        sizeof(uint32_t) * new_words
+    );
+    memset(map->array_bits + old_words, 0, sizeof(uint32_t) * (new_words - old_words));
+    map->array_capacity = new_cap;
+}
+
+/*
+** 追加键array_size
+*/
+static void array_append(XrMap *map, XrValue value) {
+    if (map->array_size == map->array_capacity) {
+        array_grow(map);
+    }
+    
+    uint32_t i = map->array_size++;
+    map->array[i] = value;
+    array_mark(map, i);
+    map->array_count++;
+    map->count++;
+}
+
+/*
+** 追加后把哈希部分中紧随其后的整数键迁入数组部分
+*/
+static void array_absorb(XrMap *map) {
+    while (!hash_part_empty(map)) {
+        XrValue key = xr_int(map->array_size);
+        uint32_t slot, old_slot;
+        XrMapEntry *entry = find_entry_full(map, key, entry_hash(key), &slot, &old_slot);
+        if (entry == NULL) {
+            break;
         }
         
-        /* 释放旧数组 */
-        xmem_free(old_entries);
+        XrValue value = entry->value;
+        map_remove_entry(map, entry, slot, old_slot);
+        array_append(map, value);
     }
 }
 
-/* ========== 基础操作 ========== */
-
-void xr_map_set(XrMap *map, XrValue key, XrValue value) {
-    /* 检查是否需要扩容 */
-    if (map->count + 1 > map->capacity * XR_MAP_LOAD_FACTOR) {
-        uint32_t new_cap = next_capacity(map->capacity);
-        xr_map_resize(map, new_cap);
+/*
+** 数组部分过于稀疏：整体迁回哈希部分
+*/
+static void array_migrate_to_hash(XrMap *map) {
+    uint32_t size = map->array_size;
+    XrValue *array = map->array;
+    uint32_t *bits = map->array_bits;
+    
+    /* 先摘下数组部分，后续插入全部进入哈希部分 */
+    map->array = NULL;
+    map->array_bits = NULL;
+    map->array_size = 0;
+    map->array_capacity = 0;
+    
+    for (uint32_t i = 0; i < size; i++) {
+        if ((bits[i >> 5] >> (i & 31)) & 1) {
+            map->array_count--;
+            map->count--;
+            map_set_hashed(map, xr_int(i), 0, array[i]);
+        }
     }
     
-    /* 查找或插入位置 */
-    uint32_t index;
-    XrMapEntry *entry = xr_map_find_entry(map, key, &index);
+    xmem_free(array);
+    xmem_free(bits);
+}
+
+/*
+** 从数组部分删除键i（调用者保证i < array_size且存在）
+*/
+static void array_remove(XrMap *map, uint32_t i) {
+    array_unmark(map, i);
+    map->array[i] = xr_null();
+    map->array_count--;
+    map->count--;
+    
+    /* 收缩末尾的空洞 */
+    while (map->array_size > 0 && !array_has(map, map->array_size - 1)) {
+        map->array_size--;
+    }
     
-    if (entry == NULL) {
-        /* 新键：插入 */
-        uint32_t hash = xr_hash_value(key);
-        uint8_t sh = xr_short_hash(hash);
+    /* 存在的键不足一半：数组部分不再划算 */
+    if (map->array_size >= XR_MAP_ARRAY_SPARSE_MIN &&
+        map->array_count < map->array_size / 2) {
+        array_migrate_to_hash(map);
+    }
+}
+
+/* ========== 基础操作 ========== */
+
+void xr_map_set(XrMap *map, XrValue key, XrValue value) {
+    uint32_t i;
+    if (array_index(key, &i)) {
+        /* 数组部分范围内：直接写入 */
+        if (i < map->array_size) {
+            if (!array_has(map, i)) {
+                array_mark(map, i);
+                map->array_count++;
+                map->count++;
+            }
+            map->array[i] = value;
+            return;
+        }
         
-        map->entries[index].state = sh;
-        map->entries[index].key = key;
-        map->entries[index].value = value;
-        map->count++;
-    } else {
-        /* 已存在：更新值 */
-        entry->value = value;
+        /* 紧接数组部分：追加并吸收后续键（键已在哈希部分时原地更新） */
+        if (i == map->array_size) {
+            uint32_t slot;
+            if (hash_part_empty(map) || xr_map_find_entry(map, key, &slot) == NULL) {
+                array_append(map, value);
+                array_absorb(map);
+                return;
+            }
+        }
     }
+    
+    map_set_hashed(map, key, 0, value);
 }
 
 XrValue xr_map_get(XrMap *map, XrValue key, bool *found) {
+    uint32_t i;
+    if (array_index(key, &i) && i < map->array_size) {
+        bool present = array_has(map, i);
+        if (found) *found = present;
+        return present ? map->array[i] : xr_null();
+    }
+    
+    migrate_step(map);
     uint32_t index;
     XrMapEntry *entry = xr_map_find_entry(map, key, &index);
     
@@ -250,22 +793,48 @@ XrValue xr_map_get(XrMap *map, XrValue key, bool *found) {
     }
 }
 
+void xr_map_set_str(XrMap *map, XrString *key, XrValue value) {
+    map_set_hashed(map, xr_string_value(key), xr_hash_string(key), value);
+}
+
+XrValue xr_map_get_str(XrMap *map, XrString *key, bool *found) {
+    XrMapEntry *entry = NULL;
+    if (map->capacity > 0) {
+        migrate_step(map);
+        uint32_t index;
+        entry = find_entry_hashed(map, xr_string_value(key), xr_hash_string(key), &index);
+    }
+    
+    if (found) *found = (entry != NULL);
+    return entry != NULL ? entry->value : xr_null();
+}
+
 bool xr_map_has(XrMap *map, XrValue key) {
-    uint32_t index;
-    XrMapEntry *entry = xr_map_find_entry(map, key, &index);
-    return entry != NULL;
+    bool found;
+    xr_map_get(map, key, &found);
+    return found;
 }
 
 bool xr_map_delete(XrMap *map, XrValue key) {
-    uint32_t index;
-    XrMapEntry *entry = xr_map_find_entry(map, key, &index);
+    uint32_t i;
+    if (array_index(key, &i) && i < map->array_size) {
+        if (!array_has(map, i)) {
+            return false;
+        }
+        array_remove(map, i);
+        return true;
+    }
+    
+    if (map->capacity == 0) {
+        return false;
+    }
+    
+    migrate_step(map);
+    uint32_t index, old_slot;
+    XrMapEntry *entry = find_entry_full(map, key, entry_hash(key), &index, &old_slot);
     
     if (entry != NULL) {
-        /* 标记为墓碑 */
-        entry->state = XR_MAP_TOMBSTONE;
-        entry->key = xr_null();
-        entry->value = xr_null();
-        map->count--;
+        map_remove_entry(map, entry, index, old_slot);
         return true;
     }
     
@@ -273,17 +842,51 @@ bool xr_map_delete(XrMap *map, XrValue key) {
 }
 
 void xr_map_clear(XrMap *map) {
-    if (map->entries != NULL) {
-        /* 清空所有条目 */
-        memset(map->entries, 0, sizeof(XrMapEntry) * map->capacity);
+    drop_old_table(map);
+    if (map->ctrl != NULL) {
+        /* 只需清空控制字节 */
+        memset(map->ctrl, XR_MAP_EMPTY, ctrl_size(map->capacity));
+    }
+    if (map->array_bits != NULL) {
+        memset(map->array_bits, 0, sizeof(uint32_t) * ((map->array_capacity + 31) / 32));
     }
     map->count = 0;
+    map->used = 0;
+    map->array_size = 0;
+    map->array_count = 0;
 }
 
 uint32_t xr_map_size(XrMap *map) {
     return map->count;
 }
 
+/* ========== GC支持 ========== */
+
+uint32_t xr_map_sweep_weak(XrMap *map, XrMapKeyAlive is_alive, void *ud) {
+    /* 第一遍：只标记失效条目，不逐个写墓碑 */
+    uint32_t removed = 0;
+    for (uint32_t i = 0; i < map->used; i++) {
+        XrMapEntry *entry = &map->entries[i];
+        if (entry_is_live(entry) && !is_alive(entry->key, ud)) {
+            entry->key = xr_null();
+            entry->value = xr_null();
+            entry->hash = 0;
+            removed++;
+        }
+    }
+    
+    if (removed == 0) {
+        return 0;
+    }
+    map->count -= removed;
+    
+    /* 第二遍：整体压缩并重建索引（存活条目很少时缩容） */
+    uint32_t live = map->count - map->array_count;
+    uint32_t new_cap = capacity_for(live);
+    xr_map_resize(map, new_cap < map->capacity ? new_cap : map->capacity);
+    return removed;
+}
+
 /* ========== Map迭代方法 ========== */
 
 /*
@@ -291,11 +894,18 @@ uint32_t xr_map_size(XrMap *map) {
 ** 返回包含所有键的数组
 */
 struct XrArray* xr_map_keys(XrMap *map) {
-    XrArray *keys = xr_array_new();
+    XrArray *keys = xr_array_with_capacity(map->count);
+    
+    /* 数组部分（整数键升序） */
+    for (uint32_t i = 0; i < map->array_size; i++) {
+        if (array_has(map, i)) {
+            xr_array_push(keys, xr_int(i));
+        }
+    }
     
-    /* 遍历所有有效条目 */
-    for (uint32_t i = 0; i < map->capacity; i++) {
-        if (entry_is_valid(&map->entries[i])) {
+    /* 按插入顺序遍历有效条目 */
+    for (uint32_t i = 0; i < map->used; i++) {
+        if (entry_is_live(&map->entries[i])) {
             xr_array_push(keys, map->entries[i].key);
         }
     }
@@ -308,11 +918,18 @@ struct XrArray* xr_map_keys(XrMap *map) {
 ** 返回包含所有值的数组
 */
 struct XrArray* xr_map_values(XrMap *map) {
-    XrArray *values = xr_array_new();
+    XrArray *values = xr_array_with_capacity(map->count);
     
-    /* 遍历所有有效条目 */
-    for (uint32_t i = 0; i < map->capacity; i++) {
-        if (entry_is_valid(&map->entries[i])) {
+    /* 数组部分（整数键升序） */
+    for (uint32_t i = 0; i < map->array_size; i++) {
+        if (array_has(map, i)) {
+            xr_array_push(values, map->array[i]);
+        }
+    }
+    
+    /* 按插入顺序遍历有效条目 */
+    for (uint32_t i = 0; i < map->used; i++) {
+        if (entry_is_live(&map->entries[i])) {
             xr_array_push(values, map->entries[i].value);
         }
     }
@@ -325,18 +942,28 @@ struct XrArray* xr_map_values(XrMap *map) {
 ** 返回包含所有[key, value]数组的数组
 */
 struct XrArray* xr_map_entries(XrMap *map) {
-    XrArray *entries = xr_array_new();
+    XrArray *entries = xr_array_with_capacity(map->count);
+    extern XrValue xr_value_from_array(struct XrArray *arr);
+    
+    /* 数组部分（整数键升序） */
+    for (uint32_t i = 0; i < map->array_size; i++) {
+        if (array_has(map, i)) {
+            XrArray *pair = xr_array_with_capacity(2);
+            xr_array_push(pair, xr_int(i));
+            xr_array_push(pair, map->array[i]);
+            xr_array_push(entries, xr_value_from_array(pair));
+        }
+    }
     
-    /* 遍历所有有效条目 */
-    for (uint32_t i = 0; i < map->capacity; i++) {
-        if (entry_is_valid(&map->entries[i])) {
+    /* 按插入顺序遍历有效条目 */
+    for (uint32_t i = 0; i < map->used; i++) {
+        if (entry_is_live(&map->entries[i])) {
             /* 创建[key, value]数组 */
-            XrArray *pair = xr_array_new();
+            XrArray *pair = xr_array_with_capacity(2);
             xr_array_push(pair, map->entries[i].key);
             xr_array_push(pair, map->entries[i].value);
             
             /* 包装成XrValue并添加到结果 */
-            extern XrValue xr_value_from_array(struct XrArray *arr);
             xr_array_push(entries, xr_value_from_array(pair));
         }
     }
@@ -344,3 +971,34 @@ struct XrArray* xr_map_entries(XrMap *map) {
     return entries;
 }
 
+/*
+** 游标迭代
+** 游标c < array_size 表示数组部分下标，否则表示条目下标 c - array_size
+*/
+bool xr_map_next(XrMap *map, uint32_t *cursor, XrValue *key, XrValue *value) {
+    uint32_t c = *cursor;
+    
+    /* 数组部分（整数键升序） */
+    for (; c < map->array_size; c++) {
+        if (array_has(map, c)) {
+            if (key) *key = xr_int(c);
+            if (value) *value = map->array[c];
+            *cursor = c + 1;
+            return true;
+        }
+    }
+    
+    /* 哈希部分（插入顺序，跳过已删除条目） */
+    for (uint32_t i = c - map->array_size; i < map->used; i++) {
+        XrMapEntry *entry = &map->entries[i];
+        if (entry_is_live(entry)) {
+            if (key) *key = entry->key;
+            if (value) *value = entry->value;
+            *cursor = map->array_size + i + 1;
+            return true;
+        }
+    }
+    
+    *cursor = map->array_size + map->used;
+    return false;
+}
@@ -4,16 +4,22 @@
  * 
  * 设计：
  *   - 开放寻址（Open Addressing）
- *   - 线性探测（Linear Probing）
+ *   - 分组探测（Swiss Table风格，每组16个槽位）
  *   - 墓碑机制（Tombstone）
  *   - 短哈希优化（Julia风格）
- *   - 小Map线性扫描（Crystal风格）
+ *   - 控制字节独立存放，SSE2一次比较16个
+ *   - 紧凑布局（CPython风格）：稠密条目数组 + 8/16/32位索引表
+ *   - 混合表（Lua风格）：连续整数键0..n-1存放在数组部分
  * 
  * 特性：
  *   - O(1) 平均时间复杂度
  *   - 75% 负载因子
  *   - 容量为2的幂（位运算优化）
- *   - 预留WeakMap扩展接口
+ *   - 只有短哈希匹配时才访问键
+ *   - 按插入顺序迭代，迭代代价与元素数量成正比
+ *     （数组部分的整数键按升序排在最前）
+ *   - 稠密整数键不经过哈希和探测
+ *   - WeakMap：键不阻止对象回收，GC清除阶段批量删除失效条目
  */
 
 #ifndef XMAP_H
@@ -29,7 +35,8 @@
 /**
  * Map条目结构
  * 
- * state字段编码：
+ * 条目按插入顺序稠密存放，槽位只保存条目下标。
+ * 槽位状态在独立的控制字节数组（XrMap.ctrl）中：
  *   - 0x00：空槽位
  *   - 0x7F：墓碑（已删除）
  *   - 0x80-0xFF：有效条目（bit7=1，低7位=哈希前缀）
@@ -37,10 +44,10 @@
 typedef struct {
     XrValue key;      /* 键 */
     XrValue value;    /* 值 */
-    uint8_t state;    /* 状态/哈希前缀 */
+    uint32_t hash;    /* 完整哈希（0表示条目已删除） */
 } XrMapEntry;
 
-/* 状态常量 */
+/* 控制字节常量 */
 #define XR_MAP_EMPTY     0x00  /* 空槽位 */
 #define XR_MAP_TOMBSTONE 0x7F  /* 墓碑 */
 #define XR_MAP_VALID     0x80  /* 有效条目（bit 7 = 1） */
@@ -49,23 +56,69 @@ typedef struct {
 
 /**
  * Map对象结构
+ * 
+ * 内存布局：
+ *   entries[capacity * 3/4]              稠密条目（插入顺序，单独分配）
+ *   index[capacity]                      槽位 -> 条目下标（宽度1/2/4字节）
+ *   ctrl[capacity + GROUP_WIDTH - 1]     控制字节（与index同一次分配）
+ * 
+ * 索引宽度随容量选择：容量≤256用uint8，≤65536用uint16，否则uint32。
+ * ctrl末尾的 GROUP_WIDTH-1 个字节镜像开头的字节，
+ * 使任意位置开始的16字节分组读取都不必处理回绕。
+ * 
+ * 删除只把条目标记为已删除（hash=0）、槽位标记为墓碑；
+ * used记录已使用的条目数（含已删除），用满时重建并压缩。
+ * 
+ * 数组部分：
+ *   整数键k（0 ≤ k < array_size）直接存放在array[k]，存在性由位图
+ *   array_bits记录。键array_size被设置时追加到数组部分，并把哈希部分中
+ *   紧随其后的整数键一并迁入；删除导致存在的键不足一半时，
+ *   数组部分整体迁回哈希部分。数组部分的键永远不会同时出现在哈希部分。
+ * 
+ * 渐进式扩容：
+ *   扩容时新索引表立即生效，旧索引表保留在old_index/old_ctrl中，
+ *   之后每次get/set/delete把XR_MAP_MIGRATE_STEP个条目迁入新表。
+ *   迁移期间查找先查新表再查旧表；条目数组不压缩，下标保持稳定。
  */
 typedef struct {
     GCHeader gc;           /* GC头（继承自所有堆对象） */
-    uint32_t capacity;     /* 容量（2的幂） */
-    uint32_t count;        /* 实际元素数量 */
-    XrMapEntry *entries;   /* 条目数组 */
-    uint8_t flags;         /* 标志位（预留WeakMap） */
-    void *gc_data;         /* GC数据（预留） */
+    uint32_t capacity;     /* 槽位容量（2的幂，至少一个分组） */
+    uint32_t count;        /* 实际元素数量（数组部分 + 哈希部分） */
+    uint32_t used;         /* 已使用条目数（含已删除，≤ usable） */
+    uint32_t usable;       /* 条目数组容量（capacity * 负载因子） */
+    XrMapEntry *entries;   /* 稠密条目数组（插入顺序） */
+    void *index;           /* 索引表（uint8/uint16/uint32） */
+    uint8_t *ctrl;         /* 控制字节数组（短哈希/空/墓碑） */
+    uint8_t index_width;   /* 索引表元素字节数：1/2/4 */
+    
+    /* 渐进式扩容（old_index为NULL表示没有进行中的迁移） */
+    void *old_index;       /* 旧索引表 */
+    uint8_t *old_ctrl;     /* 旧控制字节（与old_index同一次分配） */
+    uint32_t old_capacity; /* 旧槽位容量 */
+    uint8_t old_index_width; /* 旧索引表元素字节数 */
+    uint32_t migrate_pos;  /* 下一个待迁移的条目下标 */
+    uint32_t migrate_end;  /* 扩容开始时的used，迁移到此为止 */
+    
+    /* 数组部分（整数键0..array_size-1） */
+    XrValue *array;        /* 值数组 */
+    uint32_t *array_bits;  /* 存在位图 */
+    uint32_t array_size;   /* 数组部分覆盖的键范围 */
+    uint32_t array_count;  /* 数组部分实际元素数量 */
+    uint32_t array_capacity; /* 值数组容量 */
+    
+    uint8_t flags;         /* 标志位（XR_MAP_FLAG_*） */
 } XrMap;
 
-/* 标志位定义（预留） */
-#define XR_MAP_FLAG_WEAK     0x01  /* WeakMap标志（未来实现） */
+/* 标志位定义 */
+#define XR_MAP_FLAG_WEAK     0x01  /* WeakMap：键不被标记，值随键存活（蜉蝣表） */
 
 /* ========== Map参数 ========== */
 
-/* 最小容量 */
-#define XR_MAP_MIN_CAPACITY 8
+/* 分组宽度（一次比较的控制字节数，对应一个SSE2寄存器） */
+#define XR_MAP_GROUP_WIDTH 16
+
+/* 最小容量（一个完整分组） */
+#define XR_MAP_MIN_CAPACITY XR_MAP_GROUP_WIDTH
 
 /* 负载因子（75%） */
 #define XR_MAP_LOAD_FACTOR 0.75
@@ -73,8 +126,14 @@ typedef struct {
 /* 增长因子 */
 #define XR_MAP_GROW_FACTOR 2
 
-/* 小Map阈值（≤8个元素时线性扫描，不计算哈希） */
-#define XR_MAP_SMALL_SIZE 8
+/* 数组部分初始容量 */
+#define XR_MAP_ARRAY_INIT_CAPACITY 8
+
+/* 数组部分达到此大小后才检查稀疏度（避免小表来回迁移） */
+#define XR_MAP_ARRAY_SPARSE_MIN 16
+
+/* 渐进式扩容：每次操作迁移的条目数 */
+#define XR_MAP_MIGRATE_STEP 16
 
 /* ========== Map基础操作 ========== */
 
@@ -85,6 +144,32 @@ typedef struct {
  */
 XrMap* xr_map_new(void);
 
+/**
+ * 创建预分配容量的Map（用于Map字面量）
+ * 容纳count个元素而无需扩容
+ * 
+ * @param count 预期元素数量
+ * @return 新创建的Map对象
+ */
+XrMap* xr_map_with_capacity(uint32_t count);
+
+/**
+ * 创建WeakMap
+ * 键（对象）按身份比较，不被GC标记，对象不可达时条目在清除阶段被删除；
+ * 值只在键存活时被标记（ephemeron），值引用自身的键不会让键永远存活。
+ * 整数等非对象键不会失效。脚本中用 new WeakMap() 创建。
+ * 
+ * @return 新创建的WeakMap对象
+ */
+XrMap* xr_map_new_weak(void);
+
+/**
+ * 是否为WeakMap
+ */
+static inline bool xr_map_is_weak(const XrMap *map) {
+    return (map->flags & XR_MAP_FLAG_WEAK) != 0;
+}
+
 /**
  * 释放Map
  * 
@@ -145,6 +230,32 @@ void xr_map_clear(XrMap *map);
  */
 uint32_t xr_map_size(XrMap *map);
 
+/* ========== 字符串键快速路径 ========== */
+
+/*
+** 供VM的GETFIELD/SETFIELD使用：键是常量池中的字符串，
+** 直接使用其预计算的哈希，跳过按类型分派的xr_hash_value。
+*/
+
+/**
+ * 以字符串键获取值
+ * 
+ * @param map Map对象
+ * @param key 字符串键
+ * @param found 输出参数，是否找到键（可为NULL）
+ * @return 键对应的值，如果不存在则返回null
+ */
+XrValue xr_map_get_str(XrMap *map, struct XrString *key, bool *found);
+
+/**
+ * 以字符串键设置值
+ * 
+ * @param map Map对象
+ * @param key 字符串键
+ * @param value 值
+ */
+void xr_map_set_str(XrMap *map, struct XrString *key, XrValue value);
+
 /* ========== Map迭代方法 ========== */
 
 /**
@@ -171,35 +282,64 @@ struct XrArray* xr_map_values(XrMap *map);
  */
 struct XrArray* xr_map_entries(XrMap *map);
 
-/* ========== 内部函数（供实现使用） ========== */
-
 /**
- * 查找条目
+ * 游标迭代（不分配内存）
+ * 游标从0开始；先遍历数组部分，再按插入顺序遍历哈希部分。
+ * 迭代中修改Map不会越界，但可能跳过或重复访问元素。
  * 
  * @param map Map对象
+ * @param cursor 输入输出参数，返回时指向下一个元素之后
+ * @param key 输出参数，键（可为NULL）
+ * @param value 输出参数，值（可为NULL）
+ * @return true如果取得元素，false表示迭代结束
+ */
+bool xr_map_next(XrMap *map, uint32_t *cursor, XrValue *key, XrValue *value);
+
+/* ========== GC支持 ========== */
+
+/**
+ * 键存活判定回调（GC提供）
+ * 
  * @param key 键
- * @param out_index 输出参数，找到的索引或可插入的索引
- * @return 找到的条目，如果不存在则返回NULL
+ * @param ud 用户数据
+ * @return true如果键仍然存活
  */
-XrMapEntry* xr_map_find_entry(XrMap *map, XrValue key, uint32_t *out_index);
+typedef bool (*XrMapKeyAlive)(XrValue key, void *ud);
 
 /**
- * 扩容Map
+ * 删除键已失效的条目（WeakMap清除）
+ * 一次遍历标记失效条目，然后整体压缩并重建索引，
+ * 不留下墓碑；存活条目很少时同时缩小容量。
+ * 数组部分的整数键不会失效，不参与判定。
  * 
  * @param map Map对象
- * @param new_capacity 新容量
+ * @param is_alive 键存活判定回调
+ * @param ud 传给回调的用户数据
+ * @return 删除的条目数
  */
-void xr_map_resize(XrMap *map, uint32_t new_capacity);
+uint32_t xr_map_sweep_weak(XrMap *map, XrMapKeyAlive is_alive, void *ud);
+
+/* ========== 内部函数（供实现使用） ========== */
 
 /**
- * 小Map线性扫描查找
+ * 查找哈希部分中的条目（分组探测，不查数组部分）
+ * 迁移进行中时依次查找新表和旧表
  * 
  * @param map Map对象
  * @param key 键
- * @param out_index 输出参数
- * @return 找到的条目或NULL
+ * @param out_index 输出参数，新表中找到的槽位或可插入的槽位
+ * @return 找到的条目，如果不存在则返回NULL
  */
-XrMapEntry* xr_map_find_linear(XrMap *map, XrValue key, uint32_t *out_index);
+XrMapEntry* xr_map_find_entry(XrMap *map, XrValue key, uint32_t *out_index);
+
+/**
+ * 一次性重建Map（同时压缩已删除条目，保持插入顺序）
+ * 进行中的渐进式迁移被丢弃
+ * 
+ * @param map Map对象
+ * @param new_capacity 新槽位容量
+ */
+void xr_map_resize(XrMap *map, uint32_t new_capacity);
 
 #endif /* XMAP_H */
 
@@ -0,0 +1,166 @@
+/*
+** xstrbuf.c
+** Xray 字符串构建器实现
+*/
+
+#include "xstrbuf.h"
+#include <string.h>
+
+/*
+** 初始化构建器
+*/
+void xr_strbuf_init(XrStringBuilder *sb) {
+    sb->data = NULL;
+    sb->length = 0;
+    sb->capacity = 0;
+}
+
+/*
+** 释放构建器缓冲区
+*/
+void xr_strbuf_free(XrStringBuilder *sb) {
+    if (sb->data != NULL) {
+        xr_string_buffer_free(sb->data);
+    }
+    xr_strbuf_init(sb);
+}
+
+/*
+** 保证容量（2倍增长）
+*/
+void xr_strbuf_reserve(XrStringBuilder *sb, size_t extra) {
+    size_t needed = sb->length + extra + 1;  /* +1: 结尾\0 */
+    if (needed <= sb->capacity) return;
+    
+    size_t new_capacity = sb->capacity < XR_STRBUF_MIN_CAPACITY
+                        ? XR_STRBUF_MIN_CAPACITY : sb->capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    
+    /* 字符串缓冲区的容量不含结尾\0 */
+    if (sb->data == NULL) {
+        sb->data = xr_string_buffer_new(new_capacity - 1);
+    } else {
+        sb->data = xr_string_buffer_resize(sb->data, sb->capacity - 1, new_capacity - 1);
+    }
+    sb->capacity = new_capacity;
+}
+
+/*
+** 追加字节序列
+*/
+void xr_strbuf_append(XrStringBuilder *sb, const char *chars, size_t length) {
+    xr_strbuf_reserve(sb, length);
+    memcpy(sb->data + sb->length, chars, length);
+    sb->length += length;
+    sb->data[sb->length] = '\0';
+}
+
+/*
+** 追加字符串对象
+*/
+void xr_strbuf_append_string(XrStringBuilder *sb, XrString *str) {
+    xr_strbuf_append(sb, xr_string_data(str), str->length);
+}
+
+/*
+** 追加整数（直接格式化进缓冲区）
+*/
+void xr_strbuf_append_int(XrStringBuilder *sb, xr_Integer i) {
+    xr_strbuf_reserve(sb, XR_INT_BUFSIZE);
+    sb->length += xr_format_int(sb->data + sb->length, i);
+}
+
+/*
+** 追加浮点数（直接格式化进缓冲区）
+*/
+void xr_strbuf_append_float(XrStringBuilder *sb, xr_Number n) {
+    xr_strbuf_reserve(sb, XR_FLOAT_BUFSIZE);
+    sb->length += xr_format_float(sb->data + sb->length, n);
+}
+
+/*
+** 追加任意值的文本形式
+*/
+void xr_strbuf_append_value(XrStringBuilder *sb, XrValue value) {
+    if (xr_isstring(value)) {
+        xr_strbuf_append_string(sb, xr_tostring(value));
+    } else if (xr_isint(value)) {
+        xr_strbuf_append_int(sb, xr_toint(value));
+    } else if (xr_isfloat(value)) {
+        xr_strbuf_append_float(sb, xr_tofloat(value));
+    } else if (xr_isbool(value)) {
+        if (xr_tobool(value)) {
+            xr_strbuf_append(sb, "true", 4);
+        } else {
+            xr_strbuf_append(sb, "false", 5);
+        }
+    } else if (xr_isnull(value)) {
+        xr_strbuf_append(sb, "null", 4);
+    } else {
+        xr_strbuf_append(sb, "[object]", 8);
+    }
+}
+
+/*
+** 值文本长度的上界（浮点数取格式化缓冲区大小）
+*/
+static size_t value_length_bound(XrValue value) {
+    if (xr_isstring(value)) return xr_tostring(value)->length;
+    if (xr_isint(value)) return xr_format_int_length(xr_toint(value));
+    if (xr_isfloat(value)) return XR_FLOAT_BUFSIZE;
+    if (xr_isbool(value)) return xr_tobool(value) ? 4 : 5;
+    if (xr_isnull(value)) return 4;
+    return 8;  /* "[object]" */
+}
+
+/*
+** 拼接一组值（两遍：先求总长，再写入同一缓冲区）
+*/
+XrString* xr_strbuf_concat(const XrValue *values, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += value_length_bound(values[i]);
+    }
+    
+    /* 多留XR_INT_BUFSIZE：格式化数字时会多写结尾\0，保证不会再扩容 */
+    XrStringBuilder sb;
+    xr_strbuf_init(&sb);
+    xr_strbuf_reserve(&sb, total + XR_INT_BUFSIZE);
+    for (int i = 0; i < count; i++) {
+        xr_strbuf_append_value(&sb, values[i]);
+    }
+    
+    return xr_strbuf_take_string(&sb);
+}
+
+/*
+** 生成字符串（复制内容）
+*/
+XrString* xr_strbuf_to_string(XrStringBuilder *sb) {
+    if (sb->length == 0) {
+        return xr_string_intern("", 0, 0);
+    }
+    return xr_string_make(sb->data, sb->length);
+}
+
+/*
+** 生成字符串并交出缓冲区
+*/
+XrString* xr_strbuf_take_string(XrStringBuilder *sb) {
+    if (sb->length == 0) {
+        xr_strbuf_free(sb);
+        return xr_string_intern("", 0, 0);
+    }
+    
+    /* 收缩多余容量，字符串对象会一直持有这块内存 */
+    char *buffer = sb->data;
+    if (sb->length + 1 < sb->capacity) {
+        buffer = xr_string_buffer_resize(buffer, sb->capacity - 1, sb->length);
+    }
+    size_t length = sb->length;
+    xr_strbuf_init(sb);
+    
+    return xr_string_make_take(buffer, length);
+}
@@ -0,0 +1,110 @@
+/*
+** xstrbuf.h
+** Xray 字符串构建器
+**
+** 设计特点：
+**   - 可变缓冲区，容量按2倍增长（追加均摊O(1)）
+**   - 数字直接格式化进缓冲区，不产生临时字符串
+**   - toString时才生成字符串，循环中反复拼接不再是O(n²)
+**
+** 用途：
+**   - VM中字符串+和模板字符串（OP_CONCAT）的单次分配拼接
+**   - 编译器把循环里的 s = s + x 降级为构建器追加（见OP_SBBEGIN）
+**
+** 参考：
+**   - Lua的luaL_Buffer
+**   - Java的StringBuilder
+*/
+
+#ifndef xstrbuf_h
+#define xstrbuf_h
+
+#include "xray.h"
+#include "xvalue.h"
+#include "xstring.h"
+#include <stddef.h>
+
+/* 首次分配的最小容量 */
+#define XR_STRBUF_MIN_CAPACITY 32
+
+/*
+** 字符串构建器
+** data始终以\0结尾（capacity > 0时），length不含\0
+*/
+typedef struct XrStringBuilder {
+    char *data;             /* 缓冲区（xr_string_buffer_new分配） */
+    size_t length;          /* 已写入字节数 */
+    size_t capacity;        /* 缓冲区容量 */
+} XrStringBuilder;
+
+/*
+** 初始化构建器（不分配内存）
+*/
+void xr_strbuf_init(XrStringBuilder *sb);
+
+/*
+** 释放构建器缓冲区
+*/
+void xr_strbuf_free(XrStringBuilder *sb);
+
+/*
+** 保证还能再写入extra字节（外加结尾\0）
+** 容量不足时按2倍增长
+*/
+void xr_strbuf_reserve(XrStringBuilder *sb, size_t extra);
+
+/*
+** 追加字节序列
+*/
+void xr_strbuf_append(XrStringBuilder *sb, const char *chars, size_t length);
+
+/*
+** 追加字符串对象
+*/
+void xr_strbuf_append_string(XrStringBuilder *sb, XrString *str);
+
+/*
+** 追加整数的十进制表示
+*/
+void xr_strbuf_append_int(XrStringBuilder *sb, xr_Integer i);
+
+/*
+** 追加浮点数（格式同xr_format_float）
+*/
+void xr_strbuf_append_float(XrStringBuilder *sb, xr_Number n);
+
+/*
+** 追加任意值的文本形式
+** 字符串原样，数字格式化，bool/null为字面量，其余为"[object]"
+** （与Array.join的元素转换一致）
+*/
+void xr_strbuf_append_value(XrStringBuilder *sb, XrValue value);
+
+/*
+** 生成字符串（短串驻留），构建器保持不变可继续追加
+*/
+XrString* xr_strbuf_to_string(XrStringBuilder *sb);
+
+/*
+** 生成字符串并交出缓冲区，构建器回到空状态
+** 适合一次性拼接，省去一次复制
+*/
+XrString* xr_strbuf_take_string(XrStringBuilder *sb);
+
+/*
+** 拼接一组值为字符串（模板字符串、OP_CONCAT）
+** 先算总长度上界，只分配一次缓冲区
+*/
+XrString* xr_strbuf_concat(const XrValue *values, int count);
+
+/*
+** 清空内容但保留缓冲区
+*/
+static inline void xr_strbuf_reset(XrStringBuilder *sb) {
+    sb->length = 0;
+    if (sb->data != NULL) {
+        sb->data[0] = '\0';
+    }
+}
+
+#endif /* xstrbuf_h */
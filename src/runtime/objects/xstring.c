@@ -8,32 +8,64 @@
 #include "xvalue.h"   /* 值系统 */
 #include "xtype.h"     /* 类型系统 */
 #include "xmem.h"      /* 内存管理 */
+#include "xslab.h"     /* 定长对象分配 */
 #include "xarray.h"    /* 数组完整定义 - 必须在xstring.h之前 */
 #include "xstring.h"   /* 字符串定义 */
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h>
 #include <stdlib.h>
+#include <math.h>
 
-/* 全局字符串池 */
-static StringPool g_string_pool = {0};
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define XR_STRING_USE_SSE2 1
+#else
+  #define XR_STRING_USE_SSE2 0
+#endif
+
+/* 默认字符串池（没有VM时使用，如单元测试） */
+static StringPool g_default_pool = {0};
+
+/* 当前字符串池 */
+static StringPool *g_string_pool = &g_default_pool;
 
 /* ========== 字符串池管理 ========== */
 
+/*
+** 字符串对象占用的字节数（切片字符串不含父串）
+*/
+static size_t string_bytes(XrString *str) {
+    return str->kind == XR_STRING_SLICE ? XR_STRING_SLICE_SIZE : xr_string_size(str->length);
+}
+
+/*
+** 切换当前字符串池
+*/
+void xr_string_pool_use(StringPool *pool) {
+    g_string_pool = (pool != NULL) ? pool : &g_default_pool;
+}
+
+/*
+** 当前字符串池
+*/
+StringPool* xr_string_pool_current(void) {
+    return g_string_pool;
+}
+
 /*
 ** 初始化字符串池
 */
 void xr_string_pool_init(void) {
-    g_string_pool.capacity = STRING_POOL_INIT_CAPACITY;
-    g_string_pool.count = 0;
-    g_string_pool.threshold = (size_t)(g_string_pool.capacity * STRING_POOL_LOAD_FACTOR);
-    g_string_pool.entries = (XrString**)xmem_alloc(
-        sizeof(XrString*) * g_string_pool.capacity
+    g_string_pool->capacity = STRING_POOL_INIT_CAPACITY;
+    g_string_pool->count = 0;
+    g_string_pool->threshold = (size_t)(g_string_pool->capacity * STRING_POOL_LOAD_FACTOR);
+    g_string_pool->entries = (XrString**)xmem_alloc(
+        sizeof(XrString*) * g_string_pool->capacity
     );
     
     /* 初始化为NULL */
-    for (size_t i = 0; i < g_string_pool.capacity; i++) {
-        g_string_pool.entries[i] = NULL;
+    for (size_t i = 0; i < g_string_pool->capacity; i++) {
+        g_string_pool->entries[i] = NULL;
     }
 }
 
@@ -41,56 +73,67 @@ void xr_string_pool_init(void) {
 ** 释放字符串池
 */
 void xr_string_pool_free(void) {
-    if (g_string_pool.entries == NULL) return;
+    /* 释放长字符串 */
+    XrString *str = g_string_pool->long_strings;
+    while (str != NULL) {
+        XrString *next = (XrString*)str->header.next;
+        xr_string_free(str);
+        str = next;
+    }
+    g_string_pool->long_strings = NULL;
+    g_string_pool->long_count = 0;
+    g_string_pool->bytes = 0;
+    
+    if (g_string_pool->entries == NULL) return;
     
     /* 释放所有字符串 */
-    for (size_t i = 0; i < g_string_pool.capacity; i++) {
-        if (g_string_pool.entries[i] != NULL) {
-            xr_string_free(g_string_pool.entries[i]);
+    for (size_t i = 0; i < g_string_pool->capacity; i++) {
+        if (g_string_pool->entries[i] != NULL) {
+            xr_string_free(g_string_pool->entries[i]);
         }
     }
     
     /* 释放表 */
-    xmem_free(g_string_pool.entries);
-    g_string_pool.entries = NULL;
-    g_string_pool.capacity = 0;
-    g_string_pool.count = 0;
+    xmem_free(g_string_pool->entries);
+    g_string_pool->entries = NULL;
+    g_string_pool->capacity = 0;
+    g_string_pool->count = 0;
 }
 
 /*
-** 扩容字符串池
+** 按新容量重建哈希表（旧表中的NULL槽位跳过）
 */
-void xr_string_pool_grow(void) {
-    size_t old_capacity = g_string_pool.capacity;
-    XrString **old_entries = g_string_pool.entries;
-    
-    /* 容量翻倍 */
-    g_string_pool.capacity = old_capacity * 2;
-    g_string_pool.threshold = (size_t)(g_string_pool.capacity * STRING_POOL_LOAD_FACTOR);
-    g_string_pool.entries = (XrString**)xmem_alloc(
-        sizeof(XrString*) * g_string_pool.capacity
+static void pool_rehash(size_t new_capacity) {
+    size_t old_capacity = g_string_pool->capacity;
+    XrString **old_entries = g_string_pool->entries;
+    
+    g_string_pool->capacity = new_capacity;
+    g_string_pool->threshold = (size_t)(new_capacity * STRING_POOL_LOAD_FACTOR);
+    g_string_pool->entries = (XrString**)xmem_alloc(
+        sizeof(XrString*) * new_capacity
     );
     
     /* 初始化为NULL */
-    for (size_t i = 0; i < g_string_pool.capacity; i++) {
-        g_string_pool.entries[i] = NULL;
+    for (size_t i = 0; i < new_capacity; i++) {
+        g_string_pool->entries[i] = NULL;
     }
     
     /* 重新哈希所有字符串 */
-    g_string_pool.count = 0;  /* 重新计数 */
+    size_t mask = new_capacity - 1;
+    g_string_pool->count = 0;  /* 重新计数 */
     for (size_t i = 0; i < old_capacity; i++) {
         XrString *str = old_entries[i];
         if (str != NULL) {
             /* 重新插入 */
-            uint32_t index = str->hash % g_string_pool.capacity;
+            size_t index = str->hash & mask;
             
             /* 线性探测 */
-            while (g_string_pool.entries[index] != NULL) {
-                index = (index + 1) % g_string_pool.capacity;
+            while (g_string_pool->entries[index] != NULL) {
+                index = (index + 1) & mask;
             }
             
-            g_string_pool.entries[index] = str;
-            g_string_pool.count++;
+            g_string_pool->entries[index] = str;
+            g_string_pool->count++;
         }
     }
     
@@ -98,63 +141,246 @@ void xr_string_pool_grow(void) {
     xmem_free(old_entries);
 }
 
+/*
+** 扩容字符串池
+*/
+void xr_string_pool_grow(void) {
+    /* 容量翻倍（保持2的幂） */
+    pool_rehash(g_string_pool->capacity * 2);
+}
+
 /*
 ** 获取字符串池统计信息
 */
 void xr_string_pool_stats(size_t *count, size_t *capacity, double *load_factor) {
-    if (count) *count = g_string_pool.count;
-    if (capacity) *capacity = g_string_pool.capacity;
+    if (count) *count = g_string_pool->count;
+    if (capacity) *capacity = g_string_pool->capacity;
     if (load_factor) {
-        *load_factor = g_string_pool.capacity > 0 
-            ? (double)g_string_pool.count / g_string_pool.capacity 
+        *load_factor = g_string_pool->capacity > 0 
+            ? (double)g_string_pool->count / g_string_pool->capacity 
             : 0.0;
     }
 }
 
+/*
+** 删除驻留表中的一个槽位（后移删除）
+** 线性探测的表不能直接挖洞，否则会截断探测链：把后面起始位置
+** 不在(hole, i]之间的条目前移填洞，直到遇到空槽
+*/
+static void pool_remove_at(size_t hole) {
+    size_t mask = g_string_pool->capacity - 1;
+    size_t i = (hole + 1) & mask;
+    while (g_string_pool->entries[i] != NULL) {
+        size_t home = g_string_pool->entries[i]->hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            g_string_pool->entries[hole] = g_string_pool->entries[i];
+            hole = i;
+        }
+        i = (i + 1) & mask;
+    }
+    g_string_pool->entries[hole] = NULL;
+    g_string_pool->count--;
+}
+
+/*
+** 清扫字符串池
+** 
+** 1. 长字符串链表：摘下并释放不可达的
+** 2. 驻留表：释放不可达的并就地后移删除，不重新分配表
+**    （填进当前槽位的条目要重新检查；从表头绕回来的已检查过，再查一次无妨）
+*/
+size_t xr_string_pool_sweep(XrStringAlive is_alive, void *ud) {
+    size_t freed = 0;
+    
+    XrString *prev = NULL;
+    XrString *str = g_string_pool->long_strings;
+    while (str != NULL) {
+        XrString *next = (XrString*)str->header.next;
+        if (is_alive(str, ud)) {
+            prev = str;
+        } else {
+            if (prev != NULL) {
+                prev->header.next = (XrObject*)next;
+            } else {
+                g_string_pool->long_strings = next;
+            }
+            g_string_pool->bytes -= string_bytes(str);
+            xr_string_free(str);
+            g_string_pool->long_count--;
+            freed++;
+        }
+        str = next;
+    }
+    
+    if (g_string_pool->entries == NULL) return freed;
+    
+    size_t table_freed = 0;
+    size_t i = 0;
+    while (i < g_string_pool->capacity) {
+        XrString *entry = g_string_pool->entries[i];
+        if (entry != NULL && !is_alive(entry, ud)) {
+            g_string_pool->bytes -= xr_string_size(entry->length);
+            xr_string_free(entry);
+            pool_remove_at(i);
+            table_freed++;
+        } else {
+            i++;
+        }
+    }
+    
+    return freed + table_freed;
+}
+
+/*
+** 清扫新登记的长字符串（新串总是插在链表头部）
+*/
+size_t xr_string_pool_sweep_since(XrString *stop, XrStringAlive is_alive, void *ud) {
+    size_t freed = 0;
+    
+    XrString *prev = NULL;
+    XrString *str = g_string_pool->long_strings;
+    while (str != NULL && str != stop) {
+        XrString *next = (XrString*)str->header.next;
+        if (is_alive(str, ud)) {
+            prev = str;
+        } else {
+            if (prev != NULL) {
+                prev->header.next = (XrObject*)next;
+            } else {
+                g_string_pool->long_strings = next;
+            }
+            g_string_pool->bytes -= string_bytes(str);
+            xr_string_free(str);
+            g_string_pool->long_count--;
+            freed++;
+        }
+        str = next;
+    }
+    
+    return freed;
+}
+
+/*
+** 清除所有字符串的标记位
+*/
+void xr_string_pool_clear_marks(void) {
+    for (XrString *str = g_string_pool->long_strings; str != NULL;
+         str = (XrString*)str->header.next) {
+        str->header.marked = false;
+    }
+    
+    if (g_string_pool->entries == NULL) return;
+    for (size_t i = 0; i < g_string_pool->capacity; i++) {
+        if (g_string_pool->entries[i] != NULL) {
+            g_string_pool->entries[i]->header.marked = false;
+        }
+    }
+}
+
 /* ========== 字符串哈希 ========== */
 
+/* xxHash64的素数 */
+#define HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME3 0x165667B19E3779F9ULL
+#define HASH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define HASH_PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t hash_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/* 非对齐读取（memcpy会被编译器优化为单条load） */
+static inline uint64_t hash_read64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash_read32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
 /*
-** FNV-1a 哈希算法
+** 按字哈希（xxHash64单通道）
 ** 
 ** 算法步骤：
-** 1. hash = 2166136261 (FNV offset basis)
-** 2. 对每个字节：
-**    hash = (hash ^ byte) * 16777619 (FNV prime)
+** 1. h = PRIME5 + length
+** 2. 每8字节：h ^= round(word)；h = rotl(h, 27) * PRIME1 + PRIME4
+** 3. 剩余4字节、单字节分别混入
+** 4. 雪崩：移位异或与乘法交替，最后折叠为32位
 */
 uint32_t xr_string_hash(const char *chars, size_t length) {
-    uint32_t hash = 2166136261u;  /* FNV offset basis */
+    const char *p = chars;
+    const char *end = chars + length;
+    uint64_t h = HASH_PRIME5 + (uint64_t)length;
+    
+    while (end - p >= 8) {
+        uint64_t k = hash_read64(p) * HASH_PRIME2;
+        k = hash_rotl(k, 31) * HASH_PRIME1;
+        h ^= k;
+        h = hash_rotl(h, 27) * HASH_PRIME1 + HASH_PRIME4;
+        p += 8;
+    }
+    
+    if (end - p >= 4) {
+        h ^= (uint64_t)hash_read32(p) * HASH_PRIME1;
+        h = hash_rotl(h, 23) * HASH_PRIME2 + HASH_PRIME3;
+        p += 4;
+    }
     
-    for (size_t i = 0; i < length; i++) {
-        hash ^= (uint8_t)chars[i];
-        hash *= 16777619u;  /* FNV prime */
+    while (p < end) {
+        h ^= (uint8_t)*p * HASH_PRIME5;
+        h = hash_rotl(h, 11) * HASH_PRIME1;
+        p++;
     }
     
-    return hash;
+    /* 雪崩 */
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    h *= HASH_PRIME3;
+    h ^= h >> 32;
+    
+    uint32_t hash = (uint32_t)h;
+    return hash == 0 ? 1 : hash;
 }
 
 /* ========== 字符串创建 ========== */
 
 /*
-** 创建新字符串（不驻留）
+** 初始化字符串头部（哈希惰性计算）
 */
-XrString* xr_string_new(const char *chars, size_t length) {
-    /* 分配字符串对象 */
-    XrString *str = (XrString*)xmem_alloc(sizeof(XrString));
-    
-    /* 初始化对象头 */
+static void string_init_header(XrString *str, size_t length, uint32_t kind) {
     str->header.type = XR_TSTRING;
     str->header.type_info = NULL;  /* 字符串类型信息由类型系统管理 */
     str->header.next = NULL;
     str->header.marked = false;
-    
-    /* 初始化字符串数据 */
     str->length = length;
-    str->hash = xr_string_hash(chars, length);
+    str->hash = 0;
+    str->kind = kind;
+}
+
+/*
+** 初始化内联字符串头部（字符由调用者写入）
+*/
+static void string_init(XrString *str, size_t length) {
+    string_init_header(str, length, XR_STRING_FLAT);
+    str->chars[length] = '\0';
+}
+
+/*
+** 创建新字符串（不驻留）
+*/
+XrString* xr_string_new(const char *chars, size_t length) {
+    /* 头部和字符数据一次分配（短串落在slab里） */
+    XrString *str = (XrString*)xr_slab_alloc(xr_string_size(length));
+    string_init(str, length);
     
-    /* 分配并复制字符数据 */
-    str->chars = (char*)xmem_alloc(length + 1);
+    /* 复制字符数据 */
     memcpy(str->chars, chars, length);
-    str->chars[length] = '\0';
     
     return str;
 }
@@ -166,92 +392,654 @@ XrString* xr_string_copy(const char *chars) {
     return xr_string_new(chars, strlen(chars));
 }
 
+/* 缓冲区所在的内存块（即将成为的字符串对象） */
+#define buffer_block(buffer) ((XrString*)((buffer) - offsetof(XrString, chars)))
+
 /*
-** 字符串驻留
+** 在池中查找字符串
+** 找到返回已有字符串，否则返回NULL并输出可插入的空位
 */
-XrString* xr_string_intern(const char *chars, size_t length, uint32_t hash) {
+static XrString* pool_lookup(const char *chars, size_t length, uint32_t hash,
+                             uint32_t *out_index) {
     /* 如果池未初始化，先初始化 */
-    if (g_string_pool.entries == NULL) {
+    if (g_string_pool->entries == NULL) {
         xr_string_pool_init();
     }
     
-    /* 如果哈希值为0，计算哈希 */
-    if (hash == 0) {
-        hash = xr_string_hash(chars, length);
-    }
-    
-    /* 在池中查找 */
-    uint32_t index = hash % g_string_pool.capacity;
+    size_t mask = g_string_pool->capacity - 1;
+    uint32_t index = hash & mask;
     
     for (;;) {
-        XrString *entry = g_string_pool.entries[index];
+        XrString *entry = g_string_pool->entries[index];
         
         if (entry == NULL) {
-            /* 未找到，创建新字符串 */
-            XrString *str = xr_string_new(chars, length);
-            str->hash = hash;
-            
-            /* 插入池中 */
-            g_string_pool.entries[index] = str;
-            g_string_pool.count++;
-            
-            /* 检查是否需要扩容 */
-            if (g_string_pool.count > g_string_pool.threshold) {
-                xr_string_pool_grow();
-            }
-            
-            return str;
+            *out_index = index;
+            return NULL;
         }
         
         /* 检查是否匹配 */
         if (entry->length == length && 
             entry->hash == hash &&
             memcmp(entry->chars, chars, length) == 0) {
-            /* 找到相同字符串 */
             return entry;
         }
         
         /* 冲突，线性探测 */
-        index = (index + 1) % g_string_pool.capacity;
+        index = (index + 1) & mask;
+    }
+}
+
+/*
+** 把新字符串放入pool_lookup给出的空位
+*/
+static void pool_insert(XrString *str, uint32_t index) {
+    g_string_pool->entries[index] = str;
+    g_string_pool->count++;
+    g_string_pool->bytes += xr_string_size(str->length);
+    
+    /* 检查是否需要扩容 */
+    if (g_string_pool->count > g_string_pool->threshold) {
+        xr_string_pool_grow();
+    }
+}
+
+/*
+** 字符串驻留
+*/
+XrString* xr_string_intern(const char *chars, size_t length, uint32_t hash) {
+    /* 如果哈希值为0，计算哈希 */
+    if (hash == 0) {
+        hash = xr_string_hash(chars, length);
+    }
+    
+    uint32_t index;
+    XrString *entry = pool_lookup(chars, length, hash, &index);
+    if (entry != NULL) {
+        /* 找到相同字符串 */
+        return entry;
+    }
+    
+    /* 未找到，创建新字符串 */
+    XrString *str = xr_string_new(chars, length);
+    str->hash = hash;
+    pool_insert(str, index);
+    return str;
+}
+
+/*
+** 字符串驻留（接管缓冲区）
+*/
+XrString* xr_string_intern_take(char *buffer, size_t length) {
+    uint32_t hash = xr_string_hash(buffer, length);
+    
+    uint32_t index;
+    XrString *entry = pool_lookup(buffer, length, hash, &index);
+    if (entry != NULL) {
+        xr_string_buffer_free(buffer);
+        return entry;
+    }
+    
+    /* 缓冲区前面就是预留的头部 */
+    XrString *str = buffer_block(buffer);
+    string_init(str, length);
+    str->hash = hash;
+    
+    pool_insert(str, index);
+    return str;
+}
+
+/*
+** 登记长字符串（清扫时回收）
+*/
+static XrString* pool_track_long(XrString *str) {
+    str->header.next = (XrObject*)g_string_pool->long_strings;
+    g_string_pool->long_strings = str;
+    g_string_pool->long_count++;
+    g_string_pool->bytes += string_bytes(str);
+    return str;
+}
+
+/*
+** 动态生成字符串（短串驻留，长串登记）
+*/
+XrString* xr_string_make(const char *chars, size_t length) {
+    if (length <= XR_STRING_SHORT_MAX) {
+        return xr_string_intern(chars, length, 0);
+    }
+    return pool_track_long(xr_string_new(chars, length));
+}
+
+/*
+** 内联字符串（切片复制出新串，切片本身不变）
+*/
+XrString* xr_string_flatten(XrString *str) {
+    if (str->kind != XR_STRING_SLICE) return str;
+    
+    XrString *flat = xr_string_make(xr_string_data(str), str->length);
+    if (flat->hash == 0) {
+        flat->hash = str->hash;
+    }
+    return flat;
+}
+
+/*
+** 动态生成字符串（接管缓冲区）
+*/
+XrString* xr_string_make_take(char *buffer, size_t length) {
+    if (length <= XR_STRING_SHORT_MAX) {
+        return xr_string_intern_take(buffer, length);
     }
+    XrString *str = buffer_block(buffer);
+    string_init(str, length);
+    return pool_track_long(str);
+}
+
+/* ========== 字符串缓冲区 ========== */
+
+/*
+** 分配缓冲区（预留字符串头部）
+*/
+char* xr_string_buffer_new(size_t capacity) {
+    XrString *block = (XrString*)xmem_alloc(xr_string_size(capacity));
+    return block->chars;
+}
+
+/*
+** 调整缓冲区容量
+*/
+char* xr_string_buffer_resize(char *buffer, size_t old_capacity, size_t new_capacity) {
+    XrString *block = (XrString*)xmem_realloc(buffer_block(buffer),
+                                              xr_string_size(old_capacity),
+                                              xr_string_size(new_capacity));
+    return block->chars;
+}
+
+/*
+** 释放缓冲区
+*/
+void xr_string_buffer_free(char *buffer) {
+    xmem_free(buffer_block(buffer));
 }
 
 /*
-** 拼接两个字符串
+** 拼接两个字符串（直接写入字符串缓冲区，新串不再复制）
 */
 XrString* xr_string_concat(XrString *a, XrString *b) {
     if (a == NULL || b == NULL) return NULL;
     
     size_t new_length = a->length + b->length;
-    char *buffer = (char*)xmem_alloc(new_length + 1);
+    char *buffer = xr_string_buffer_new(new_length);
     
-    memcpy(buffer, a->chars, a->length);
-    memcpy(buffer + a->length, b->chars, b->length);
-    buffer[new_length] = '\0';
+    memcpy(buffer, xr_string_data(a), a->length);
+    memcpy(buffer + a->length, xr_string_data(b), b->length);
     
-    /* 驻留结果 */
-    XrString *result = xr_string_intern(buffer, new_length, 0);
-    xmem_free(buffer);
-    
-    return result;
+    return xr_string_make_take(buffer, new_length);
 }
 
 /*
 ** 从整数创建字符串
 */
 XrString* xr_string_from_int(xr_Integer i) {
-    char buffer[32];
-    snprintf(buffer, sizeof(buffer), "%lld", (long long)i);
-    return xr_string_intern(buffer, strlen(buffer), 0);
+    char buffer[XR_INT_BUFSIZE];
+    size_t len = xr_format_int(buffer, i);
+    return xr_string_intern(buffer, len, 0);
 }
 
 /*
 ** 从浮点数创建字符串
 */
 XrString* xr_string_from_float(xr_Number n) {
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "%.15g", n);
-    return xr_string_intern(buffer, strlen(buffer), 0);
+    char buffer[XR_FLOAT_BUFSIZE];
+    size_t len = xr_format_float(buffer, n);
+    return xr_string_intern(buffer, len, 0);
+}
+
+/* ========== 数字格式化 ========== */
+
+/* 两位数字查表，每次除法产出两位 */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*
+** 无符号整数格式化（从缓冲区末尾向前写）
+*/
+static size_t format_uint(char *buf, uint64_t v) {
+    char tmp[XR_INT_BUFSIZE];
+    char *p = tmp + sizeof(tmp);
+    
+    while (v >= 100) {
+        uint32_t r = (uint32_t)(v % 100);
+        v /= 100;
+        p -= 2;
+        memcpy(p, &digit_pairs[r * 2], 2);
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, &digit_pairs[v * 2], 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+    
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return len;
+}
+
+size_t xr_format_int(char *buf, xr_Integer i) {
+    if (i < 0) {
+        /* 先转无符号再取负，INT64_MIN也不会溢出 */
+        buf[0] = '-';
+        return 1 + format_uint(buf + 1, 0 - (uint64_t)i);
+    }
+    return format_uint(buf, (uint64_t)i);
+}
+
+size_t xr_format_int_length(xr_Integer i) {
+    uint64_t v = (i < 0) ? 0 - (uint64_t)i : (uint64_t)i;
+    size_t len = (i < 0) ? 2 : 1;
+    while (v >= 10) {
+        v /= 10;
+        len++;
+    }
+    return len;
+}
+
+/*
+** 浮点数最短表示（Grisu2）
+** 
+** 在double的舍入区间内生成位数尽量少的十进制数字，解析回来一定得到原值。
+** 用64位整数模拟高精度（DiyFp = f * 2^e），乘以缓存的10的幂把指数拉到
+** 固定窗口，再逐位生成数字；不分配内存，不走printf。
+** 参考：Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+** Accurately with Integers"；Milo Yip的dtoa实现
+*/
+
+typedef struct {
+    uint64_t f;
+    int e;
+} DiyFp;
+
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_HIDDEN_BIT       0x0010000000000000ULL
+#define DP_EXPONENT_BIAS    1075   /* 0x3FF + 52 */
+
+/* 10^k的64位近似，k = -348, -340, ..., 340 */
+static const uint64_t cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007,  -980,
+     -954,  -927,  -901,  -874,  -847,  -821,  -794,  -768,  -741,  -715,
+     -688,  -661,  -635,  -608,  -582,  -555,  -529,  -502,  -475,  -449,
+     -422,  -396,  -369,  -343,  -316,  -289,  -263,  -236,  -210,  -183,
+     -157,  -130,  -103,   -77,   -50,   -24,     3,    30,    56,    83,
+      109,   136,   162,   189,   216,   242,   269,   295,   322,   348,
+      375,   402,   428,   455,   481,   508,   534,   561,   588,   614,
+      641,   667,   694,   720,   747,   774,   800,   827,   853,   880,
+      907,   933,   960,   986,  1013,  1039,  1066
+};
+
+static const uint64_t pow10_table[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* 64x64位乘法取高64位（四舍五入） */
+static DiyFp diyfp_mul(DiyFp x, DiyFp y) {
+    const uint64_t M32 = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & M32;
+    uint64_t c = y.f >> 32, d = y.f & M32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+    tmp += 1ULL << 31;
+    DiyFp r;
+    r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+static DiyFp diyfp_normalize(DiyFp x) {
+    while (!(x.f & (1ULL << 63))) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/*
+** 舍入区间的上下边界（m+和m-），规格化到同一指数
+*/
+static void diyfp_boundaries(DiyFp v, DiyFp *minus, DiyFp *plus) {
+    DiyFp pl;
+    pl.f = (v.f << 1) + 1;
+    pl.e = v.e - 1;
+    while (!(pl.f & (DP_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= 10;   /* 64 - 52 - 2 */
+    pl.e -= 10;
+    
+    /* 2的幂的下边界距离只有一半 */
+    DiyFp mi;
+    if (v.f == DP_HIDDEN_BIT) {
+        mi.f = (v.f << 2) - 1;
+        mi.e = v.e - 2;
+    } else {
+        mi.f = (v.f << 1) - 1;
+        mi.e = v.e - 1;
+    }
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    
+    *minus = mi;
+    *plus = pl;
+}
+
+/*
+** 选一个10的幂c，使w * c的二进制指数落在[-60, -32]
+** 输出K：c = 10^-K
+*/
+static DiyFp cached_power(int e, int *K) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;  /* log10(2) */
+    int k = (int)dk;
+    if (dk - k > 0.0) k++;
+    
+    unsigned index = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+    
+    DiyFp c;
+    c.f = cached_powers_f[index];
+    c.e = cached_powers_e[index];
+    return c;
+}
+
+/* 末位数字往w靠近（在安全区间内） */
+static void grisu_round(char *buffer, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* 十进制位数（1~10） */
+static int count_digits32(uint32_t n) {
+    int count = 1;
+    while (n >= 10) {
+        n /= 10;
+        count++;
+    }
+    return count;
+}
+
+/*
+** 生成数字：先整数部分p1，再小数部分p2，一旦落入区间delta就停止
+*/
+static void grisu_digits(DiyFp W, DiyFp Mp, uint64_t delta,
+                         char *buffer, int *len, int *K) {
+    const int shift = -Mp.e;
+    const uint64_t one = 1ULL << shift;
+    const uint64_t wp_w = Mp.f - W.f;
+    uint32_t p1 = (uint32_t)(Mp.f >> shift);
+    uint64_t p2 = Mp.f & (one - 1);
+    int kappa = count_digits32(p1);
+    *len = 0;
+    
+    while (kappa > 0) {
+        uint32_t div = (uint32_t)pow10_table[kappa - 1];
+        uint32_t d = p1 / div;
+        p1 %= div;
+        if (d || *len) {
+            buffer[(*len)++] = (char)('0' + d);
+        }
+        kappa--;
+        uint64_t tmp = ((uint64_t)p1 << shift) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            grisu_round(buffer, *len, delta, tmp, pow10_table[kappa] << shift, wp_w);
+            return;
+        }
+    }
+    
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> shift);
+        if (d || *len) {
+            buffer[(*len)++] = (char)('0' + d);
+        }
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            int index = -kappa;
+            grisu_round(buffer, *len, delta, p2, one,
+                        wp_w * (index < 20 ? pow10_table[index] : 0));
+            return;
+        }
+    }
+}
+
+/*
+** 正的有限非零double → 数字串digits（不含\0）与十进制指数K
+** 值 = digits * 10^K
+*/
+static int grisu2(double value, char *digits, int *K) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased_e = (int)((bits >> 52) & 0x7FF);
+    
+    DiyFp v;
+    if (biased_e != 0) {
+        v.f = (bits & DP_SIGNIFICAND_MASK) + DP_HIDDEN_BIT;
+        v.e = biased_e - DP_EXPONENT_BIAS;
+    } else {
+        v.f = bits & DP_SIGNIFICAND_MASK;   /* 非规格化数 */
+        v.e = 1 - DP_EXPONENT_BIAS;
+    }
+    
+    DiyFp w_m, w_p;
+    diyfp_boundaries(v, &w_m, &w_p);
+    
+    DiyFp c_mk = cached_power(w_p.e, K);
+    DiyFp W = diyfp_mul(diyfp_normalize(v), c_mk);
+    DiyFp Wp = diyfp_mul(w_p, c_mk);
+    DiyFp Wm = diyfp_mul(w_m, c_mk);
+    Wm.f++;
+    Wp.f--;
+    
+    int len;
+    grisu_digits(W, Wp, Wp.f - Wm.f, digits, &len, K);
+    return len;
+}
+
+/*
+** 去掉末位数字（round_up时向上进位），再去掉末尾的0
+** 返回新长度，K随之调整
+*/
+static int drop_last_digit(char *out, const char *digits, int len, int *K, bool round_up) {
+    int n = len - 1;
+    *K += 1;
+    memcpy(out, digits, (size_t)n);
+    
+    if (round_up) {
+        while (n > 0 && out[n - 1] == '9') {
+            n--;
+            *K += 1;
+        }
+        if (n == 0) {
+            out[0] = '1';
+            return 1;
+        }
+        out[n - 1]++;
+    }
+    
+    while (n > 1 && out[n - 1] == '0') {
+        n--;
+        *K += 1;
+    }
+    return n;
+}
+
+/* digits * 10^K 能否解析回value */
+static bool digits_roundtrip(const char *digits, int len, int K, double value) {
+    char text[48];
+    memcpy(text, digits, (size_t)len);
+    text[len] = 'e';
+    xr_format_int(text + len + 1, K);
+    return strtod(text, NULL) == value;
+}
+
+/*
+** 缩短数字串
+** Grisu2的安全区间取得保守，偶尔会多出一两位（如636.2094763092269）。
+** 结果超过15位时依次尝试舍入、截断末位，用strtod确认仍能往返；
+** 15位以内的输出不走这里，常见的数不会调用strtod
+*/
+static int shorten_digits(char *digits, int len, int *K, double value) {
+    while (len > 15) {
+        char cand[24];
+        int ck = *K;
+        int clen = drop_last_digit(cand, digits, len, &ck, digits[len - 1] >= '5');
+        if (!digits_roundtrip(cand, clen, ck, value)) {
+            ck = *K;
+            clen = drop_last_digit(cand, digits, len, &ck, digits[len - 1] < '5');
+            if (!digits_roundtrip(cand, clen, ck, value)) break;
+        }
+        memcpy(digits, cand, (size_t)clen);
+        len = clen;
+        *K = ck;
+    }
+    return len;
+}
+
+/*
+** 按"%g"的版式排列数字：十进制指数在[-4, 15)时用定点，否则用科学计数法
+** （与此前"%.15g"的输出在15位以内的数上一致）
+*/
+static size_t format_digits(char *buf, const char *digits, int len, int K) {
+    char *p = buf;
+    int exp10 = len + K - 1;   /* 首位数字的十进制指数 */
+    
+    if (exp10 >= -4 && exp10 < 15) {
+        if (exp10 < 0) {
+            /* 0.000ddd */
+            *p++ = '0';
+            *p++ = '.';
+            for (int i = -1; i > exp10; i--) {
+                *p++ = '0';
+            }
+            memcpy(p, digits, (size_t)len);
+            p += len;
+        } else if (len <= exp10 + 1) {
+            /* ddd000 */
+            memcpy(p, digits, (size_t)len);
+            p += len;
+            for (int i = len; i <= exp10; i++) {
+                *p++ = '0';
+            }
+        } else {
+            /* ddd.ddd */
+            memcpy(p, digits, (size_t)exp10 + 1);
+            p += exp10 + 1;
+            *p++ = '.';
+            memcpy(p, digits + exp10 + 1, (size_t)(len - exp10 - 1));
+            p += len - exp10 - 1;
+        }
+    } else {
+        /* d.ddde+XX */
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, (size_t)len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        if (exp10 < 0) {
+            *p++ = '-';
+            exp10 = -exp10;
+        } else {
+            *p++ = '+';
+        }
+        if (exp10 >= 100) {
+            *p++ = (char)('0' + exp10 / 100);
+            exp10 %= 100;
+        }
+        memcpy(p, &digit_pairs[exp10 * 2], 2);
+        p += 2;
+    }
+    
+    *p = '\0';
+    return (size_t)(p - buf);
+}
+
+size_t xr_format_float(char *buf, xr_Number n) {
+    /* 15位以内的整数值：直接按整数格式化 */
+    if (n > -1e15 && n < 1e15 && n == (xr_Number)(int64_t)n) {
+        if (n == 0 && signbit(n)) {
+            memcpy(buf, "-0", 3);
+            return 2;
+        }
+        return xr_format_int(buf, (xr_Integer)n);
+    }
+    
+    if (isnan(n)) {
+        memcpy(buf, "nan", 4);
+        return 3;
+    }
+    
+    char *p = buf;
+    if (signbit(n)) {
+        *p++ = '-';
+        n = -n;
+    }
+    if (isinf(n)) {
+        memcpy(p, "inf", 4);
+        return (size_t)(p - buf) + 3;
+    }
+    
+    char digits[20];
+    int K;
+    int len = grisu2(n, digits, &K);
+    len = shorten_digits(digits, len, &K, n);
+    return (size_t)(p - buf) + format_digits(p, digits, len, K);
 }
 
 /* ========== 字符串比较 ========== */
@@ -270,7 +1058,7 @@ int xr_string_compare(XrString *a, XrString *b) {
     
     /* 字典序比较 */
     size_t min_len = a->length < b->length ? a->length : b->length;
-    int cmp = memcmp(a->chars, b->chars, min_len);
+    int cmp = memcmp(xr_string_data(a), xr_string_data(b), min_len);
     
     if (cmp != 0) return cmp;
     
@@ -280,6 +1068,296 @@ int xr_string_compare(XrString *a, XrString *b) {
     return 0;
 }
 
+/* ========== 子串查找 ========== */
+
+/* 不超过该长度的模式串走首尾字节过滤，更长的走Two-Way */
+#define SEARCH_SHORT_MAX 32
+
+/*
+** 首尾字节过滤（标量）
+** memchr找首字节，再核对尾字节，都命中才比较中间部分
+*/
+static const char* search_short_scalar(const char *hay, size_t hlen,
+                                       const char *needle, size_t nlen) {
+    char first = needle[0];
+    char last = needle[nlen - 1];
+    const char *p = hay;
+    const char *last_start = hay + hlen - nlen;  /* 最后一个可能的起点 */
+    
+    while (p <= last_start) {
+        p = (const char*)memchr(p, first, (size_t)(last_start - p) + 1);
+        if (p == NULL) return NULL;
+        if (p[nlen - 1] == last && memcmp(p + 1, needle + 1, nlen - 2) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+#if XR_STRING_USE_SSE2
+/*
+** 位图中最低位的下标（mask非0）
+*/
+static inline uint32_t mask_lowest(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(mask);
+#else
+    uint32_t i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+#endif
+
+/*
+** 首尾字节过滤（nlen >= 2）
+** SSE2：一次比较16个起点的首字节和对应的尾字节，两者同时命中的位置才比较中间
+*/
+static const char* search_short(const char *hay, size_t hlen,
+                                const char *needle, size_t nlen) {
+#if XR_STRING_USE_SSE2
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[nlen - 1]);
+    size_t starts = hlen - nlen + 1;  /* 候选起点数 */
+    size_t i = 0;
+    
+    while (i + 16 <= starts) {
+        __m128i block_first = _mm_loadu_si128((const __m128i *)(hay + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i *)(hay + i + nlen - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                                   _mm_cmpeq_epi8(block_last, last));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(eq);
+        
+        while (mask != 0) {
+            const char *p = hay + i + mask_lowest(mask);
+            if (memcmp(p + 1, needle + 1, nlen - 2) == 0) {
+                return p;
+            }
+            mask &= mask - 1;
+        }
+        i += 16;
+    }
+    
+    /* 不足16个起点的尾部 */
+    return search_short_scalar(hay + i, hlen - i, needle, nlen);
+#else
+    return search_short_scalar(hay, hlen, needle, nlen);
+#endif
+}
+
+/*
+** 最大后缀（Two-Way的临界分解）
+** greater为true时按字节序取最大后缀，否则按逆序
+** 返回后缀起点前一位（可能为(size_t)-1），period输出该后缀的周期
+*/
+static size_t maximal_suffix(const unsigned char *x, size_t n, bool greater,
+                             size_t *period) {
+    size_t ip = (size_t)-1;  /* 当前最大后缀起点 - 1 */
+    size_t jp = 0;           /* 候选后缀起点 - 1 */
+    size_t k = 1;
+    size_t p = 1;
+    
+    while (jp + k < n) {
+        unsigned char a = x[ip + k];
+        unsigned char b = x[jp + k];
+        if (a == b) {
+            if (k == p) {
+                jp += p;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (greater ? (a > b) : (a < b)) {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        } else {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    
+    *period = p;
+    return ip;
+}
+
+/*
+** Two-Way查找（nlen > SEARCH_SHORT_MAX）
+** 
+** 1. 临界分解：模式串切成左右两半，右半从左往右比，左半从右往左比
+** 2. 周期模式串记住已匹配的前缀（mem），避免回退
+** 3. 额外用窗口末字节查坏字符表，失配时整段跳过
+*/
+static const char* search_two_way(const char *hay, size_t hlen,
+                                  const char *needle, size_t nlen) {
+    const unsigned char *h = (const unsigned char*)hay;
+    const unsigned char *n = (const unsigned char*)needle;
+    const unsigned char *end = h + hlen;
+    
+    /* 坏字符表：字节在模式串中最后出现的位置 + 1，0表示不出现 */
+    size_t shift[256];
+    memset(shift, 0, sizeof(shift));
+    for (size_t i = 0; i < nlen; i++) {
+        shift[n[i]] = i + 1;
+    }
+    
+    /* 临界分解：两种字节序的最大后缀取较长者 */
+    size_t p0, p1;
+    size_t ms0 = maximal_suffix(n, nlen, true, &p0);
+    size_t ms1 = maximal_suffix(n, nlen, false, &p1);
+    size_t ms = (ms1 + 1 > ms0 + 1) ? ms1 : ms0;
+    size_t p = (ms1 + 1 > ms0 + 1) ? p1 : p0;
+    
+    size_t mem0;
+    if (memcmp(n, n + p, ms + 1) != 0) {
+        /* 非周期：跳过距离取左右两半中较长者 */
+        mem0 = 0;
+        p = ((ms > nlen - ms - 1) ? ms : nlen - ms - 1) + 1;
+    } else {
+        mem0 = nlen - p;
+    }
+    size_t mem = 0;
+    
+    while ((size_t)(end - h) >= nlen) {
+        /* 窗口末字节 */
+        size_t s = shift[h[nlen - 1]];
+        if (s == 0) {
+            h += nlen;
+            mem = 0;
+            continue;
+        }
+        size_t k = nlen - s;
+        if (k != 0) {
+            if (k < mem) k = mem;
+            h += k;
+            mem = 0;
+            continue;
+        }
+        
+        /* 右半 */
+        for (k = (ms + 1 > mem) ? ms + 1 : mem; k < nlen && n[k] == h[k]; k++);
+        if (k < nlen) {
+            h += k - ms;
+            mem = 0;
+            continue;
+        }
+        
+        /* 左半 */
+        for (k = ms + 1; k > mem && n[k - 1] == h[k - 1]; k--);
+        if (k <= mem) {
+            return (const char*)h;
+        }
+        h += p;
+        mem = mem0;
+    }
+    return NULL;
+}
+
+/*
+** 子串查找
+*/
+const char* xr_string_search(const char *haystack, size_t hlen,
+                             const char *needle, size_t nlen) {
+    if (nlen == 0) return haystack;
+    if (nlen > hlen) return NULL;
+    if (nlen == 1) {
+        return (const char*)memchr(haystack, needle[0], hlen);
+    }
+    if (nlen <= SEARCH_SHORT_MAX) {
+        return search_short(haystack, hlen, needle, nlen);
+    }
+    return search_two_way(haystack, hlen, needle, nlen);
+}
+
+/* ========== 字符串切片 ========== */
+
+/*
+** 去除首尾空白
+*/
+XrStringSlice xr_string_slice_trim(XrStringSlice slice) {
+    const char *chars = xr_string_slice_chars(slice);
+    size_t start = 0;
+    size_t end = slice.length;
+    
+    while (start < end && xr_is_whitespace(chars[start])) {
+        start++;
+    }
+    while (end > start && xr_is_whitespace(chars[end - 1])) {
+        end--;
+    }
+    
+    return xr_string_slice(slice.parent, slice.offset + start, end - start);
+}
+
+/*
+** 切出下一个字段
+*/
+bool xr_string_slice_split_next(XrStringSlice *rest, XrString *delimiter, XrStringSlice *field) {
+    if (rest->parent == NULL) return false;
+    
+    const char *chars = xr_string_slice_chars(*rest);
+    const char *hit = xr_string_search(chars, rest->length,
+                                       xr_string_data(delimiter), delimiter->length);
+    
+    if (hit == NULL) {
+        /* 最后一个字段 */
+        *field = *rest;
+        rest->parent = NULL;
+        rest->length = 0;
+        return true;
+    }
+    
+    size_t len = (size_t)(hit - chars);
+    *field = xr_string_slice(rest->parent, rest->offset, len);
+    rest->offset += len + delimiter->length;
+    rest->length -= len + delimiter->length;
+    return true;
+}
+
+/*
+** 比较切片与字符串内容
+*/
+bool xr_string_slice_equals(XrStringSlice slice, XrString *str) {
+    return slice.length == str->length &&
+           memcmp(xr_string_slice_chars(slice), xr_string_data(str), str->length) == 0;
+}
+
+/*
+** 生成字符串
+*/
+XrString* xr_string_slice_materialize(XrStringSlice slice) {
+    /* 整串：字符串不可变，直接复用 */
+    if (slice.offset == 0 && slice.length == slice.parent->length) {
+        return slice.parent;
+    }
+    
+    /* 切片的切片引用最初的父串 */
+    XrString *parent = slice.parent;
+    size_t offset = slice.offset;
+    if (parent->kind == XR_STRING_SLICE) {
+        XrStringRef *ref = xr_string_ref(parent);
+        parent = ref->parent;
+        offset += ref->offset;
+    }
+    
+    /* 短串驻留；只占父串一小部分的复制，不留住整个父串 */
+    if (slice.length <= XR_STRING_SHORT_MAX ||
+        slice.length * XR_STRING_SLICE_RATIO < parent->length) {
+        return xr_string_make(parent->chars + offset, slice.length);
+    }
+    
+    XrString *str = (XrString*)xr_slab_alloc(XR_STRING_SLICE_SIZE);
+    string_init_header(str, slice.length, XR_STRING_SLICE);
+    XrStringRef *ref = xr_string_ref(str);
+    ref->parent = parent;
+    ref->offset = offset;
+    return pool_track_long(str);
+}
+
 /* ========== 字符串基础方法 ========== */
 
 /*
@@ -294,7 +1372,7 @@ XrString* xr_string_char_at(XrString *str, xr_Integer index) {
     }
     
     /* 创建单字符字符串 */
-    return xr_string_intern(&str->chars[index], 1, 0);
+    return xr_string_make(xr_string_data(str) + index, 1);
 }
 
 /*
@@ -314,7 +1392,7 @@ XrString* xr_string_substring(XrString *str, xr_Integer start, xr_Integer end) {
     
     /* 截取子串 */
     size_t len = end - start;
-    return xr_string_intern(&str->chars[start], len, 0);
+    return xr_string_slice_materialize(xr_string_slice(str, start, len));
 }
 
 /*
@@ -322,17 +1400,11 @@ XrString* xr_string_substring(XrString *str, xr_Integer start, xr_Integer end) {
 */
 xr_Integer xr_string_index_of(XrString *str, XrString *substr) {
     if (str == NULL || substr == NULL) return -1;
-    if (substr->length == 0) return 0;
-    if (substr->length > str->length) return -1;
-    
-    /* 暴力搜索（后续可以优化为KMP或Boyer-Moore）*/
-    for (size_t i = 0; i <= str->length - substr->length; i++) {
-        if (memcmp(&str->chars[i], substr->chars, substr->length) == 0) {
-            return (xr_Integer)i;
-        }
-    }
     
-    return -1;
+    const char *chars = xr_string_data(str);
+    const char *hit = xr_string_search(chars, str->length,
+                                       xr_string_data(substr), substr->length);
+    return hit != NULL ? (xr_Integer)(hit - chars) : -1;
 }
 
 /*
@@ -350,7 +1422,7 @@ bool xr_string_starts_with(XrString *str, XrString *prefix) {
     if (prefix->length > str->length) return false;
     if (prefix->length == 0) return true;
     
-    return memcmp(str->chars, prefix->chars, prefix->length) == 0;
+    return memcmp(xr_string_data(str), xr_string_data(prefix), prefix->length) == 0;
 }
 
 /*
@@ -362,26 +1434,109 @@ bool xr_string_ends_with(XrString *str, XrString *suffix) {
     if (suffix->length == 0) return true;
     
     size_t offset = str->length - suffix->length;
-    return memcmp(&str->chars[offset], suffix->chars, suffix->length) == 0;
+    return memcmp(xr_string_data(str) + offset, xr_string_data(suffix), suffix->length) == 0;
 }
 
 /*
-** toLowerCase - 转小写
+** ASCII大小写转换内核
+** 
+** 只有[lo, hi]范围内的ASCII字母需要翻转0x20位，其余字节（包括UTF-8多字节序列）
+** 原样保留，所以整块处理不需要区分编码：
+**   - SSE2：一次16字节，有符号比较天然排除>=0x80的字节
+**   - 否则按8字节字（SWAR）：低7位加偏移量判断范围，再屏蔽最高位已置位的字节
+**   - 尾部逐字节
 */
-XrString* xr_string_to_lower_case(XrString *str) {
-    if (str == NULL) return NULL;
-    
-    char *buffer = (char*)xmem_alloc(str->length + 1);
-    
-    for (size_t i = 0; i < str->length; i++) {
-        buffer[i] = tolower((unsigned char)str->chars[i]);
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_HIGH  0x8080808080808080ULL
+#define SWAR_LOW7  0x7F7F7F7F7F7F7F7FULL
+
+/* 字中落在[lo, hi]的字节，对应的最高位置1 */
+static inline uint64_t swar_range_mask(uint64_t w, char lo, char hi) {
+    uint64_t x = w & SWAR_LOW7;
+    uint64_t ge = x + SWAR_ONES * (uint64_t)(0x80 - lo);
+    uint64_t gt = x + SWAR_ONES * (uint64_t)(0x7F - hi);
+    return ge & ~gt & ~w & SWAR_HIGH;
+}
+
+#if XR_STRING_USE_SSE2
+/* 块中落在[lo, hi]的字节为0xFF */
+static inline __m128i sse2_range_mask(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8((char)(hi + 1))));
+}
+#endif
+
+/*
+** 第一个落在[lo, hi]的字节下标，没有则返回length
+*/
+static size_t case_scan(const char *s, size_t length, char lo, char hi) {
+    size_t i = 0;
+#if XR_STRING_USE_SSE2
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(sse2_range_mask(v, lo, hi));
+        if (mask != 0) {
+            return i + mask_lowest(mask);
+        }
+    }
+#endif
+    for (; i + 8 <= length; i += 8) {
+        uint64_t w;
+        memcpy(&w, s + i, sizeof(w));
+        if (swar_range_mask(w, lo, hi) != 0) break;
+    }
+    for (; i < length; i++) {
+        if (s[i] >= lo && s[i] <= hi) return i;
+    }
+    return length;
+}
+
+/*
+** 复制并翻转[lo, hi]范围内字节的大小写
+*/
+static void case_convert(char *dst, const char *src, size_t length, char lo, char hi) {
+    size_t i = 0;
+#if XR_STRING_USE_SSE2
+    __m128i flip = _mm_set1_epi8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        v = _mm_xor_si128(v, _mm_and_si128(sse2_range_mask(v, lo, hi), flip));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+#endif
+    for (; i + 8 <= length; i += 8) {
+        uint64_t w;
+        memcpy(&w, src + i, sizeof(w));
+        w ^= swar_range_mask(w, lo, hi) >> 2;  /* 0x80 >> 2 == 0x20 */
+        memcpy(dst + i, &w, sizeof(w));
+    }
+    for (; i < length; i++) {
+        char c = src[i];
+        dst[i] = (c >= lo && c <= hi) ? (char)(c ^ 0x20) : c;
     }
-    buffer[str->length] = '\0';
+}
+
+/*
+** 大小写转换：没有需要转换的字母时返回原字符串
+*/
+static XrString* case_map(XrString *str, char lo, char hi) {
+    const char *chars = xr_string_data(str);
+    size_t first = case_scan(chars, str->length, lo, hi);
+    if (first == str->length) return str;
     
-    XrString *result = xr_string_intern(buffer, str->length, 0);
-    xmem_free(buffer);
+    char *buffer = xr_string_buffer_new(str->length);
+    memcpy(buffer, chars, first);
+    case_convert(buffer + first, chars + first, str->length - first, lo, hi);
     
-    return result;
+    return xr_string_make_take(buffer, str->length);
+}
+
+/*
+** toLowerCase - 转小写
+*/
+XrString* xr_string_to_lower_case(XrString *str) {
+    if (str == NULL) return NULL;
+    return case_map(str, 'A', 'Z');
 }
 
 /*
@@ -389,18 +1544,7 @@ XrString* xr_string_to_lower_case(XrString *str) {
 */
 XrString* xr_string_to_upper_case(XrString *str) {
     if (str == NULL) return NULL;
-    
-    char *buffer = (char*)xmem_alloc(str->length + 1);
-    
-    for (size_t i = 0; i < str->length; i++) {
-        buffer[i] = toupper((unsigned char)str->chars[i]);
-    }
-    buffer[str->length] = '\0';
-    
-    XrString *result = xr_string_intern(buffer, str->length, 0);
-    xmem_free(buffer);
-    
-    return result;
+    return case_map(str, 'a', 'z');
 }
 
 /*
@@ -410,26 +1554,8 @@ XrString* xr_string_trim(XrString *str) {
     if (str == NULL) return NULL;
     if (str->length == 0) return str;
     
-    /* 找到第一个非空白字符 */
-    size_t start = 0;
-    while (start < str->length && xr_is_whitespace(str->chars[start])) {
-        start++;
-    }
-    
-    /* 全是空白 */
-    if (start == str->length) {
-        return xr_string_intern("", 0, 0);
-    }
-    
-    /* 找到最后一个非空白字符 */
-    size_t end = str->length - 1;
-    while (end > start && xr_is_whitespace(str->chars[end])) {
-        end--;
-    }
-    
-    /* 截取 */
-    size_t len = end - start + 1;
-    return xr_string_intern(&str->chars[start], len, 0);
+    XrStringSlice slice = xr_string_slice_trim(xr_string_slice(str, 0, str->length));
+    return xr_string_slice_materialize(slice);
 }
 
 /* ========== 字符串高级方法 ========== */
@@ -444,37 +1570,22 @@ struct XrArray* xr_string_split(XrString *str, XrString *delimiter) {
     
     /* 空分隔符，按字符分割 */
     if (delimiter == NULL || delimiter->length == 0) {
+        const char *chars = xr_string_data(str);
         for (size_t i = 0; i < str->length; i++) {
-            XrString *ch = xr_string_intern(&str->chars[i], 1, 0);
+            XrString *ch = xr_string_make(&chars[i], 1);
             xr_array_push(result, xr_string_value(ch));
         }
         return result;
     }
     
-    /* 按分隔符分割 */
-    const char *start = str->chars;
-    const char *end = str->chars;
-    const char *str_end = str->chars + str->length;
-    
-    while (end <= str_end - delimiter->length) {
-        if (memcmp(end, delimiter->chars, delimiter->length) == 0) {
-            /* 找到分隔符 */
-            size_t len = end - start;
-            XrString *part = xr_string_intern(start, len, 0);
-            xr_array_push(result, xr_string_value(part));
-            
-            end += delimiter->length;
-            start = end;
-        } else {
-            end++;
-        }
+    /* 按分隔符切出字段，存入数组时才生成字符串 */
+    XrStringSlice rest = xr_string_slice(str, 0, str->length);
+    XrStringSlice field;
+    while (xr_string_slice_split_next(&rest, delimiter, &field)) {
+        XrString *part = xr_string_slice_materialize(field);
+        xr_array_push(result, xr_string_value(part));
     }
     
-    /* 添加最后一部分 */
-    size_t len = str_end - start;
-    XrString *part = xr_string_intern(start, len, 0);
-    xr_array_push(result, xr_string_value(part));
-    
     return result;
 }
 
@@ -491,39 +1602,60 @@ XrString* xr_string_replace(XrString *str, XrString *old_str, XrString *new_str)
     
     /* 计算新长度 */
     size_t new_length = str->length - old_str->length + new_str->length;
-    char *buffer = (char*)xmem_alloc(new_length + 1);
+    char *buffer = xr_string_buffer_new(new_length);
     
     /* 拼接：前缀 + new_str + 后缀 */
-    memcpy(buffer, str->chars, pos);
-    memcpy(buffer + pos, new_str->chars, new_str->length);
+    const char *chars = xr_string_data(str);
+    memcpy(buffer, chars, pos);
+    memcpy(buffer + pos, xr_string_data(new_str), new_str->length);
     memcpy(buffer + pos + new_str->length, 
-           str->chars + pos + old_str->length,
+           chars + pos + old_str->length,
            str->length - pos - old_str->length);
-    buffer[new_length] = '\0';
     
-    XrString *result = xr_string_intern(buffer, new_length, 0);
-    xmem_free(buffer);
-    
-    return result;
+    return xr_string_make_take(buffer, new_length);
 }
 
 /*
 ** replaceAll - 替换所有匹配
-** 注意：join 已经移到xarray.c，这里需要用循环实现
+** 两遍：先数出匹配次数以确定结果长度，再边查找边写入同一缓冲区
 */
 XrString* xr_string_replace_all(XrString *str, XrString *old_str, XrString *new_str) {
     if (str == NULL || old_str == NULL || new_str == NULL) return str;
     if (old_str->length == 0) return str;
     
-    /* 简单实现：重复调用replace直到没有匹配 */
-    XrString *result = str;
-    xr_Integer pos;
-    
-    while ((pos = xr_string_index_of(result, old_str)) >= 0) {
-        result = xr_string_replace(result, old_str, new_str);
+    const char *chars = xr_string_data(str);
+    const char *old_chars = xr_string_data(old_str);
+    const char *end = chars + str->length;
+    const char *p = chars;
+    const char *hit;
+    
+    /* 第一遍：不重叠匹配的次数 */
+    size_t count = 0;
+    while ((hit = xr_string_search(p, (size_t)(end - p),
+                                   old_chars, old_str->length)) != NULL) {
+        count++;
+        p = hit + old_str->length;
     }
+    if (count == 0) return str;
+    
+    size_t new_length = str->length - count * old_str->length
+                      + count * new_str->length;
+    char *buffer = xr_string_buffer_new(new_length);
+    char *out = buffer;
+    
+    /* 第二遍：原文片段与新子串交替写入 */
+    p = chars;
+    for (size_t i = 0; i < count; i++) {
+        hit = xr_string_search(p, (size_t)(end - p), old_chars, old_str->length);
+        memcpy(out, p, (size_t)(hit - p));
+        out += hit - p;
+        memcpy(out, xr_string_data(new_str), new_str->length);
+        out += new_str->length;
+        p = hit + old_str->length;
+    }
+    memcpy(out, p, (size_t)(end - p));
     
-    return result;
+    return xr_string_make_take(buffer, new_length);
 }
 
 /*
@@ -536,17 +1668,14 @@ XrString* xr_string_repeat(XrString *str, xr_Integer count) {
     if (count == 1) return str;
     
     size_t new_length = str->length * count;
-    char *buffer = (char*)xmem_alloc(new_length + 1);
+    char *buffer = xr_string_buffer_new(new_length);
     
+    const char *chars = xr_string_data(str);
     for (xr_Integer i = 0; i < count; i++) {
-        memcpy(buffer + i * str->length, str->chars, str->length);
+        memcpy(buffer + i * str->length, chars, str->length);
     }
-    buffer[new_length] = '\0';
-    
-    XrString *result = xr_string_intern(buffer, new_length, 0);
-    xmem_free(buffer);
     
-    return result;
+    return xr_string_make_take(buffer, new_length);
 }
 
 /*
@@ -563,11 +1692,8 @@ XrString* xr_string_repeat(XrString *str, xr_Integer count) {
 void xr_string_free(XrString *str) {
     if (str == NULL) return;
     
-    if (str->chars != NULL) {
-        xmem_free(str->chars);
-    }
-    
-    xmem_free(str);
+    /* 字符数据内联，只有一次分配（接管的缓冲区不在slab里，交还xmem） */
+    xr_slab_free(str);
 }
 
 /* ========== 辅助函数 ========== */
@@ -579,7 +1705,7 @@ void xr_string_print(XrString *str) {
     if (str == NULL) {
         printf("(null)");
     } else {
-        printf("%.*s", (int)str->length, str->chars);
+        printf("%.*s", (int)str->length, xr_string_data(str));
     }
 }
 
@@ -5,7 +5,7 @@
 ** v0.10.0: 字符串增强
 ** 设计特点：
 **   - 不可变字符串（immutable）
-**   - 自动驻留（string interning）
+**   - 短字符串自动驻留，长字符串按需驻留（见XR_STRING_SHORT_MAX）
 **   - 哈希值缓存
 **   - UTF-8字节级操作
 ** 
@@ -19,6 +19,7 @@
 
 #include "xray.h"
 #include "xvalue.h"  /* 直接包含，获取所有类型定义 */
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -34,35 +35,98 @@ struct XrArray;
 ** 设计要点：
 ** 1. 不可变：创建后不能修改内容
 ** 2. 驻留：相同内容的字符串只存储一份
-** 3. 哈希缓存：创建时计算哈希值，避免重复计算
+** 3. 哈希缓存：首次驻留或用作Map键时才计算，之后缓存
 ** 4. 引用计数：通过GC管理（未来）
+** 5. 内联存储：字符紧跟在头部之后，一个字符串只有一次分配
+** 6. 切片字符串：substring、trim、split的长结果引用父串的一段字节，不复制
+**    （见XR_STRING_SLICE）；按长度读取字节一律经由xr_string_data
 */
 typedef struct XrString {
     XrObject header;        /* GC对象头（包含type, type_info, next, marked）*/
     size_t length;          /* 字符串长度（字节数，UTF-8）*/
-    uint32_t hash;          /* 哈希值（FNV-1a算法）*/
-    char *chars;            /* 字符串数据（以\0结尾）*/
+    uint32_t hash;          /* 哈希值（0表示尚未计算，见xr_string_get_hash）*/
+    uint32_t kind;          /* 种类（XR_STRING_FLAT/XR_STRING_SLICE） */
+    char chars[];           /* 字符串数据（内联，以\0结尾；切片字符串在此存放XrStringRef）*/
 } XrString;
 
+/* 长度为len的字符串对象占用的字节数（含结尾\0） */
+#define xr_string_size(len) (offsetof(XrString, chars) + (len) + 1)
+
+/* 字符串种类 */
+#define XR_STRING_FLAT  0   /* 字符内联在对象之后 */
+#define XR_STRING_SLICE 1   /* 切片字符串：引用父串[offset, offset + length)的字节 */
+
+/*
+** 切片字符串的引用（存放在chars的位置；头部之后chars按8字节对齐）
+** 
+** 父串总是内联字符串：切片的切片直接引用最初的父串。
+** GC标记切片时一并标记父串；切片创建后不再修改，
+** 所以父串总不比切片年轻，写屏障和区域都不必为切片另做处理。
+** chars没有结尾的\0，需要C字符串时用xr_string_flatten复制出内联字符串。
+*/
+typedef struct XrStringRef {
+    struct XrString *parent;  /* 父字符串 */
+    size_t offset;            /* 起始字节 */
+} XrStringRef;
+
+/* 切片字符串的引用 */
+#define xr_string_ref(str) ((XrStringRef*)(void*)(str)->chars)
+
+/* 切片字符串对象占用的字节数 */
+#define XR_STRING_SLICE_SIZE (offsetof(XrString, chars) + sizeof(XrStringRef))
+
+/*
+** 切片至少占父串的1/XR_STRING_SLICE_RATIO才引用父串，更短的复制：
+** 不为一小段留住整个父串。不超过XR_STRING_SHORT_MAX的结果总是复制（驻留）
+*/
+#define XR_STRING_SLICE_RATIO 4
+
+/*
+** 是否是切片字符串
+*/
+static inline bool xr_string_is_slice(XrString *str) {
+    return str->kind == XR_STRING_SLICE;
+}
+
+/*
+** 字符串的字节（按length读取，切片字符串不以\0结尾）
+*/
+static inline const char* xr_string_data(XrString *str) {
+    if (str->kind == XR_STRING_SLICE) {
+        XrStringRef *ref = xr_string_ref(str);
+        return ref->parent->chars + ref->offset;
+    }
+    return str->chars;
+}
+
 /* ========== 字符串驻留池 ========== */
 
 /*
 ** 字符串驻留池
 ** 
-** 采用开放寻址哈希表（线性探测）
+** 采用开放寻址哈希表（线性探测），容量为2的幂，用掩码取槽位
 ** 参考Lua的字符串表设计
+** 
+** 池归VM所有（见xr_string_pool_use），未驻留的长字符串也登记在池里，
+** 由xr_string_pool_sweep统一回收不可达的字符串
 */
 typedef struct {
     XrString **entries;     /* 字符串数组 */
-    size_t capacity;        /* 容量 */
+    size_t capacity;        /* 容量（2的幂） */
     size_t count;           /* 字符串数量 */
     size_t threshold;       /* 扩容阈值（capacity * 0.75）*/
+    XrString *long_strings; /* 未驻留的长字符串（经header.next串成链表） */
+    size_t long_count;      /* 长字符串数量 */
+    size_t bytes;           /* 池中字符串占用的字节数（GC触发依据） */
 } StringPool;
 
-/* 字符串池初始容量 */
+/* 字符串池初始容量（必须是2的幂） */
 #define STRING_POOL_INIT_CAPACITY 128
 #define STRING_POOL_LOAD_FACTOR   0.75
 
+/* 动态生成的字符串不超过该长度时才自动驻留 */
+#define XR_STRING_SHORT_MAX 40
+
 /* ========== 字符串创建 ========== */
 
 /*
@@ -85,16 +149,38 @@ XrString* xr_string_new(const char *chars, size_t length);
 XrString* xr_string_copy(const char *chars);
 
 /*
-** 拼接两个字符串（结果驻留）
+** 动态生成字符串
+** 长度不超过XR_STRING_SHORT_MAX时驻留，否则创建不驻留的长字符串并登记到池中
+** 拼接、截取、数字转换等运行时结果都经由这里
+*/
+XrString* xr_string_make(const char *chars, size_t length);
+
+/*
+** 动态生成字符串（接管缓冲区，规则同xr_string_make）
+** 参数：
+**   buffer: 由xr_string_buffer_new/resize得到、容量恰为length的缓冲区（所有权转移）
+**   length: 字符串长度
+*/
+XrString* xr_string_make_take(char *buffer, size_t length);
+
+/*
+** 内联字符串（chars以\0结尾）
+** 内联字符串原样返回；切片字符串复制出新串（登记到池中），切片本身不变
+** 需要C字符串，或者字符串要长期保存而不该留住父串时（如Map的键）使用
+*/
+XrString* xr_string_flatten(XrString *str);
+
+/*
+** 拼接两个字符串
 ** 参数：
 **   a, b: 要拼接的字符串
 ** 返回：
-**   拼接后的新字符串（驻留）
+**   拼接后的新字符串（短串驻留）
 */
 XrString* xr_string_concat(XrString *a, XrString *b);
 
 /*
-** 从整数创建字符串（驻留）
+** 从整数创建字符串（驻留，数字的文本长度总在阈值内）
 ** 参数：
 **   i: 整数值
 ** 返回：
@@ -103,7 +189,7 @@ XrString* xr_string_concat(XrString *a, XrString *b);
 XrString* xr_string_from_int(xr_Integer i);
 
 /*
-** 从浮点数创建字符串（驻留）
+** 从浮点数创建字符串（驻留，数字的文本长度总在阈值内）
 ** 参数：
 **   n: 浮点数值
 ** 返回：
@@ -111,13 +197,46 @@ XrString* xr_string_from_int(xr_Integer i);
 */
 XrString* xr_string_from_float(xr_Number n);
 
+/* ========== 数字格式化（写入调用者缓冲区，不分配） ========== */
+
+/* 缓冲区大小（含结尾\0） */
+#define XR_INT_BUFSIZE   24   /* 最长 "-9223372036854775808" */
+#define XR_FLOAT_BUFSIZE 32   /* 最短表示最长24字节，如 "-2.2250738585072014e-308" */
+
+/*
+** 整数格式化为十进制
+** 参数：
+**   buf: 至少XR_INT_BUFSIZE字节
+**   i: 整数值
+** 返回：
+**   写入的字节数（不含\0）
+*/
+size_t xr_format_int(char *buf, xr_Integer i);
+
+/*
+** 整数十进制表示的长度（不格式化）
+*/
+size_t xr_format_int_length(xr_Integer i);
+
+/*
+** 浮点数格式化（最短往返表示，按"%g"版式排列，整数值走快速路径）
+** 输出的数字位数最少，且strtod解析回来与n完全相等
+** 参数：
+**   buf: 至少XR_FLOAT_BUFSIZE字节
+**   n: 浮点数值
+** 返回：
+**   写入的字节数（不含\0）
+*/
+size_t xr_format_float(char *buf, xr_Number n);
+
 /* ========== 字符串驻留 ========== */
 
 /*
-** 字符串驻留
+** 字符串驻留（显式，不受长度阈值限制）
 ** 
 ** 如果池中已存在相同内容的字符串，返回已有字符串
 ** 否则将新字符串加入池中
+** 用于标识符、字面量常量等需要按指针比较的场合
 ** 
 ** 参数：
 **   chars: 字符数据
@@ -128,8 +247,54 @@ XrString* xr_string_from_float(xr_Number n);
 */
 XrString* xr_string_intern(const char *chars, size_t length, uint32_t hash);
 
+/*
+** 字符串驻留（接管缓冲区）
+** 
+** 用于先拼好整块缓冲区再驻留的场景（如join），避免再复制一次。
+** 池中已有相同内容时释放buffer并返回已有字符串；
+** 否则buffer所在的内存块直接成为新字符串对象。
+** 
+** 参数：
+**   buffer: 由xr_string_buffer_new/resize得到、容量恰为length的缓冲区（所有权转移）
+**   length: 字符串长度
+** 返回：
+**   驻留的字符串对象
+*/
+XrString* xr_string_intern_take(char *buffer, size_t length);
+
+/* ========== 字符串缓冲区 ========== */
+
+/*
+** 分配可写入capacity字节（外加结尾\0）的缓冲区
+** 缓冲区前面预留了字符串头部，交给xr_string_intern_take时无需复制
+*/
+char* xr_string_buffer_new(size_t capacity);
+
+/*
+** 调整缓冲区容量（内容保留），返回新地址
+*/
+char* xr_string_buffer_resize(char *buffer, size_t old_capacity, size_t new_capacity);
+
+/*
+** 释放未交出的缓冲区
+*/
+void xr_string_buffer_free(char *buffer);
+
 /* ========== 字符串池管理 ========== */
 
+/*
+** 切换当前字符串池
+** VM初始化时安装自己的池，释放时传NULL恢复默认池
+** 池结构清零即可使用（首次驻留时分配表）
+** 解析和编译期间总是用默认池：字面量和名字不归任何VM，也不被GC清扫
+*/
+void xr_string_pool_use(StringPool *pool);
+
+/*
+** 当前字符串池
+*/
+StringPool* xr_string_pool_current(void);
+
 /*
 ** 初始化字符串池
 ** 在程序启动时调用
@@ -153,11 +318,38 @@ void xr_string_pool_grow(void);
 */
 void xr_string_pool_stats(size_t *count, size_t *capacity, double *load_factor);
 
+/*
+** 字符串存活判定回调（GC用标记位实现）
+*/
+typedef bool (*XrStringAlive)(XrString *str, void *ud);
+
+/*
+** 清扫当前字符串池
+** 释放is_alive判定为不可达的驻留字符串和长字符串
+** 驻留表就地删除（后移删除），不重新分配；耗时与表容量和长字符串数成正比
+** 返回：
+**   释放的字符串数量
+*/
+size_t xr_string_pool_sweep(XrStringAlive is_alive, void *ud);
+
+/*
+** 只清扫stop之后新登记的长字符串（链表头部到stop之前的部分）
+** 分代GC的minor回收用，驻留字符串留给完整清扫
+** 返回：
+**   释放的字符串数量
+*/
+size_t xr_string_pool_sweep_since(XrString *stop, XrStringAlive is_alive, void *ud);
+
+/*
+** 清除当前字符串池中所有字符串的标记位
+*/
+void xr_string_pool_clear_marks(void);
+
 /* ========== 字符串比较 ========== */
 
 /*
 ** 字符串相等比较
-** 由于驻留，可以直接比较指针
+** 驻留字符串指针相同即相等；长字符串不驻留，需要比较内容
 ** 
 ** 参数：
 **   a, b: 要比较的字符串
@@ -169,8 +361,8 @@ static inline bool xr_string_equal(XrString *a, XrString *b) {
     if (a == b) return true;
     if (a == NULL || b == NULL) return false;
     if (a->length != b->length) return false;
-    if (a->hash != b->hash) return false;
-    return memcmp(a->chars, b->chars, a->length) == 0;
+    if (a->hash != 0 && b->hash != 0 && a->hash != b->hash) return false;
+    return memcmp(xr_string_data(a), xr_string_data(b), a->length) == 0;
 }
 
 /*
@@ -188,12 +380,12 @@ int xr_string_compare(XrString *a, XrString *b);
 /* ========== 字符串哈希 ========== */
 
 /*
-** 计算字符串哈希值（FNV-1a算法）
+** 计算字符串哈希值（按字处理，xxHash64风格）
 ** 
-** FNV-1a特点：
-**   - 简单高效（只需异或和乘法）
-**   - 良好的分布特性
-**   - Wren、Lua等语言都使用类似算法
+** 特点：
+**   - 每次读8字节，乘法+循环移位混合，长字符串比逐字节快数倍
+**   - 结尾做一次雪崩，短键也有良好的分布
+**   - 结果不为0（0在XrString中表示"尚未计算"）
 ** 
 ** 参数：
 **   chars: 字符数据
@@ -203,6 +395,33 @@ int xr_string_compare(XrString *a, XrString *b);
 */
 uint32_t xr_string_hash(const char *chars, size_t length);
 
+/*
+** 获取字符串哈希值（惰性计算并缓存）
+** 只有驻留和用作Map键才需要哈希，从不查找的大字符串不必付出这份开销
+*/
+static inline uint32_t xr_string_get_hash(XrString *str) {
+    if (str->hash == 0) {
+        str->hash = xr_string_hash(xr_string_data(str), str->length);
+    }
+    return str->hash;
+}
+
+/* ========== 子串查找 ========== */
+
+/*
+** 在haystack中查找needle首次出现的位置
+** 
+** indexOf、contains、split、replace/replaceAll共用的查找引擎：
+**   - 单字节：memchr
+**   - 短模式串：首尾字节同时过滤（SSE2一次16个候选位置），命中后再比较中间
+**   - 长模式串：Two-Way（Crochemore-Perrin），线性时间、常数空间
+** 
+** 返回：
+**   首次出现的地址，未找到返回NULL；needle为空时返回haystack
+*/
+const char* xr_string_search(const char *haystack, size_t hlen,
+                             const char *needle, size_t nlen);
+
 /* ========== 字符串方法 ========== */
 
 /*
@@ -222,7 +441,8 @@ XrString* xr_string_char_at(XrString *str, xr_Integer index);
 **   start: 起始位置
 **   end: 结束位置（-1表示到末尾）
 ** 返回：
-**   子串（驻留）
+**   子串（见xr_string_slice_materialize：短串驻留，长串引用原字符串；
+**   覆盖整串时返回原字符串）
 */
 XrString* xr_string_substring(XrString *str, xr_Integer start, xr_Integer end);
 
@@ -268,19 +488,21 @@ bool xr_string_ends_with(XrString *str, XrString *suffix);
 
 /*
 ** toLowerCase - 转小写
+** 只转换ASCII字母，其余字节（UTF-8）原样保留
 ** 参数：
 **   str: 字符串
 ** 返回：
-**   小写字符串（驻留）
+**   小写字符串（短串驻留；没有大写字母时返回原字符串）
 */
 XrString* xr_string_to_lower_case(XrString *str);
 
 /*
 ** toUpperCase - 转大写
+** 只转换ASCII字母，其余字节（UTF-8）原样保留
 ** 参数：
 **   str: 字符串
 ** 返回：
-**   大写字符串（驻留）
+**   大写字符串（短串驻留；没有小写字母时返回原字符串）
 */
 XrString* xr_string_to_upper_case(XrString *str);
 
@@ -289,7 +511,7 @@ XrString* xr_string_to_upper_case(XrString *str);
 ** 参数：
 **   str: 字符串
 ** 返回：
-**   去除空白后的字符串（驻留）
+**   去除空白后的字符串（同substring；没有空白时返回原字符串）
 */
 XrString* xr_string_trim(XrString *str);
 
@@ -297,6 +519,7 @@ XrString* xr_string_trim(XrString *str);
 
 /*
 ** split - 分割字符串为数组
+** 按切片扫描，每个字段按xr_string_slice_materialize生成字符串
 ** 参数：
 **   str: 字符串
 **   delimiter: 分隔符
@@ -318,6 +541,7 @@ XrString* xr_string_replace(XrString *str, XrString *old_str, XrString *new_str)
 
 /*
 ** replaceAll - 替换所有匹配的子串
+** 从左到右单遍扫描，不重叠匹配；替换后的内容不会再次匹配
 ** 参数：
 **   str: 字符串
 **   old_str: 要替换的子串
@@ -343,6 +567,76 @@ XrString* xr_string_repeat(XrString *str, xr_Integer count);
 ** 用法: array.join(",") 而不是 ",".join(array)
 */
 
+/* ========== 字符串切片 ========== */
+
+/*
+** 字符串切片（C代码扫描用的只读视图）
+** 
+** 引用父字符串[offset, offset + length)的字节，本身不分配。
+** 视图只存在于C代码中，不是脚本值，GC看不到它：
+** 使用期间由调用者保证父串可达。
+** 
+** 视图的扫描（trim、split_next、equals）不复制字节；
+** 需要脚本值时由xr_string_slice_materialize决定复制还是生成切片字符串。
+*/
+typedef struct XrStringSlice {
+    XrString *parent;       /* 父字符串（NULL表示已耗尽，见split_next） */
+    size_t offset;          /* 起始字节 */
+    size_t length;          /* 字节数 */
+} XrStringSlice;
+
+/*
+** 创建切片（调用者保证范围在父串内）
+*/
+static inline XrStringSlice xr_string_slice(XrString *str, size_t offset, size_t length) {
+    XrStringSlice slice;
+    slice.parent = str;
+    slice.offset = offset;
+    slice.length = length;
+    return slice;
+}
+
+/*
+** 切片的首字节地址（不以\0结尾）
+*/
+static inline const char* xr_string_slice_chars(XrStringSlice slice) {
+    return xr_string_data(slice.parent) + slice.offset;
+}
+
+/*
+** 去除首尾空白（只调整范围）
+*/
+XrStringSlice xr_string_slice_trim(XrStringSlice slice);
+
+/*
+** 切出下一个字段
+** 
+** 从rest开头到下一个分隔符之前为一个字段，rest前移到分隔符之后；
+** 没有分隔符时剩余部分就是最后一个字段，之后rest耗尽
+** 
+** 参数：
+**   rest: 尚未切分的部分（就地更新）
+**   delimiter: 分隔符（非空）
+**   field: 输出字段
+** 返回：
+**   取到字段返回true，rest已耗尽返回false
+*/
+bool xr_string_slice_split_next(XrStringSlice *rest, XrString *delimiter, XrStringSlice *field);
+
+/*
+** 比较切片与字符串内容
+*/
+bool xr_string_slice_equals(XrStringSlice slice, XrString *str);
+
+/*
+** 生成字符串
+**   - 覆盖整个父串：直接返回父串
+**   - 长于XR_STRING_SHORT_MAX且至少占父串的1/XR_STRING_SLICE_RATIO：
+**     生成切片字符串，引用父串（切片的切片引用最初的父串），不复制
+**   - 其余按xr_string_make复制：短字段驻留，长字段新建
+*/
+XrString* xr_string_slice_materialize(XrStringSlice slice);
+
 /* ========== 字符串释放 ========== */
 
 /*
@@ -0,0 +1,181 @@
+/*
+** xarena.c
+** Xray 线性（bump）分配器实现
+*/
+
+#include "xarena.h"
+#include "xmem.h"
+#include <stdint.h>
+#include <string.h>
+
+/* 当前arena */
+static XrArena *g_arena = NULL;
+
+/*
+** 向上对齐到XR_ARENA_ALIGN
+*/
+static size_t align_up(size_t size) {
+    return (size + XR_ARENA_ALIGN - 1) & ~(size_t)(XR_ARENA_ALIGN - 1);
+}
+
+/*
+** 申请一块至少能放下size字节的内存
+*/
+static XrArenaBlock* new_block(XrArena *arena, size_t size) {
+    XrArenaBlock *block = (XrArenaBlock*)xmem_alloc(
+        sizeof(XrArenaBlock) + XR_ARENA_ALIGN + size);
+    uintptr_t data = (uintptr_t)(block + 1);
+    block->start = (char*)align_up(data);
+    block->end = block->start + size;
+    block->prev = NULL;
+    arena->block_count++;
+    return block;
+}
+
+/* ========== 创建和销毁 ========== */
+
+/*
+** 创建arena
+*/
+XrArena* xr_arena_new(void) {
+    XrArena *arena = (XrArena*)xmem_alloc(sizeof(XrArena));
+    memset(arena, 0, sizeof(XrArena));
+    return arena;
+}
+
+/*
+** 释放arena（逐块归还）
+*/
+void xr_arena_free(XrArena *arena) {
+    if (arena == NULL) return;
+    
+    XrArenaBlock *block = arena->head;
+    while (block != NULL) {
+        XrArenaBlock *prev = block->prev;
+        xmem_free(block);
+        block = prev;
+    }
+    if (g_arena == arena) {
+        g_arena = NULL;
+    }
+    xmem_free(arena);
+}
+
+/* ========== 分配 ========== */
+
+/*
+** 分配：当前块放不下时换新块，大请求单独成块
+*/
+void* xr_arena_alloc(XrArena *arena, size_t size) {
+    size_t aligned = align_up(size == 0 ? 1 : size);
+    
+    if (aligned > (size_t)(arena->limit - arena->cursor)) {
+        if (aligned > XR_ARENA_BLOCK_SIZE / 4) {
+            /* 单独成块，挂在head之后，head的剩余空间继续用 */
+            XrArenaBlock *big = new_block(arena, aligned);
+            if (arena->head == NULL) {
+                arena->head = big;
+                arena->cursor = arena->limit = big->end;
+            } else {
+                big->prev = arena->head->prev;
+                arena->head->prev = big;
+            }
+            arena->bytes_allocated += aligned;
+            return big->start;
+        }
+        
+        XrArenaBlock *block = new_block(arena, XR_ARENA_BLOCK_SIZE);
+        block->prev = arena->head;
+        arena->head = block;
+        arena->cursor = block->start;
+        arena->limit = block->end;
+    }
+    
+    void *ptr = arena->cursor;
+    arena->cursor += aligned;
+    arena->bytes_allocated += aligned;
+    return ptr;
+}
+
+/*
+** 调整大小：最近一次分配原地扩展，否则复制
+*/
+void* xr_arena_realloc(XrArena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) {
+        return xr_arena_alloc(arena, new_size);
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+    
+    char *top = (char*)ptr + align_up(old_size == 0 ? 1 : old_size);
+    size_t grow = align_up(new_size) - align_up(old_size == 0 ? 1 : old_size);
+    if (top == arena->cursor && grow <= (size_t)(arena->limit - arena->cursor)) {
+        arena->cursor += grow;
+        arena->bytes_allocated += grow;
+        return ptr;
+    }
+    
+    void *moved = xr_arena_alloc(arena, new_size);
+    memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+/*
+** 复制字符串
+*/
+char* xr_arena_strndup(XrArena *arena, const char *chars, size_t length) {
+    char *copy = (char*)xr_arena_alloc(arena, length + 1);
+    memcpy(copy, chars, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/*
+** 指针是否由arena分配（从最新的块往回找）
+*/
+bool xr_arena_owns(XrArena *arena, const void *ptr) {
+    if (arena == NULL || ptr == NULL) return false;
+    
+    const char *p = (const char*)ptr;
+    for (XrArenaBlock *block = arena->head; block != NULL; block = block->prev) {
+        if (p >= block->start && p < block->end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ========== 当前arena ========== */
+
+/*
+** 设置当前arena
+*/
+void xr_arena_use(XrArena *arena) {
+    g_arena = arena;
+}
+
+/*
+** 获取当前arena
+*/
+XrArena* xr_arena_current(void) {
+    return g_arena;
+}
+
+/*
+** 分配会话内的临时内存
+*/
+void* xr_arena_scratch_alloc(size_t size) {
+    if (g_arena != NULL) {
+        return xr_arena_alloc(g_arena, size);
+    }
+    return xmem_alloc(size);
+}
+
+/*
+** 释放会话内的临时内存
+*/
+void xr_arena_scratch_free(void *ptr) {
+    if (ptr == NULL || xr_arena_owns(g_arena, ptr)) return;
+    xmem_free(ptr);
+}
@@ -0,0 +1,104 @@
+/*
+** xarena.h
+** Xray 线性（bump）分配器
+**
+** 设计特点：
+**   - 从大块内存中顺序切分，分配只是移动游标
+**   - 不支持逐块释放，所有内存随arena一次归还
+**   - 超过块尺寸四分之一的请求单独成块，不浪费当前块的剩余空间
+**
+** 用途：
+**   - 一次解析/编译会话的AST节点、标识符副本和编译器临时数据，
+**     它们同时创建、同时死亡（见xr_parse、xr_compile）
+**   - 没有当前arena时，会话内的分配退回malloc
+**
+** 参考：
+**   - Hanson, Fast Allocation and Deallocation of Memory Based on Object Lifetimes (1990)
+*/
+
+#ifndef xarena_h
+#define xarena_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* 每块的默认大小 */
+#define XR_ARENA_BLOCK_SIZE (64 * 1024)
+
+/* 分配的对齐粒度 */
+#define XR_ARENA_ALIGN 16
+
+/* 一块内存（块头之后是数据区） */
+typedef struct XrArenaBlock {
+    struct XrArenaBlock *prev;  /* 之前申请的块 */
+    char *start;                /* 数据区起点（已对齐） */
+    char *end;                  /* 数据区末尾 */
+} XrArenaBlock;
+
+/*
+** arena
+** head是当前切分的块，单独成块的大请求挂在head之后
+*/
+typedef struct XrArena {
+    XrArenaBlock *head;
+    char *cursor;               /* head中下一个未分配的位置 */
+    char *limit;                /* head数据区末尾 */
+    
+    size_t block_count;         /* 申请的块数 */
+    size_t bytes_allocated;     /* 分配出去的字节数（含对齐） */
+} XrArena;
+
+/*
+** 创建arena（第一次分配时才申请块）
+*/
+XrArena* xr_arena_new(void);
+
+/*
+** 归还arena的全部内存并释放arena本身
+*/
+void xr_arena_free(XrArena *arena);
+
+/*
+** 分配size字节（按XR_ARENA_ALIGN对齐，内容未初始化）
+*/
+void* xr_arena_alloc(XrArena *arena, size_t size);
+
+/*
+** 调整分配的大小
+** ptr是最近一次分配且当前块放得下时原地扩展，否则复制到新位置（旧空间不回收）
+*/
+void* xr_arena_realloc(XrArena *arena, void *ptr, size_t old_size, size_t new_size);
+
+/*
+** 复制length字节的字符串（结果以'\0'结尾）
+*/
+char* xr_arena_strndup(XrArena *arena, const char *chars, size_t length);
+
+/*
+** 指针是否由arena分配（arena为NULL时返回false）
+*/
+bool xr_arena_owns(XrArena *arena, const void *ptr);
+
+/* ========== 当前arena ========== */
+
+/*
+** 设置当前arena（NULL表示不用arena）
+*/
+void xr_arena_use(XrArena *arena);
+
+/*
+** 获取当前arena
+*/
+XrArena* xr_arena_current(void);
+
+/*
+** 会话内的临时内存：有当前arena时从它分配，否则走xmem
+*/
+void* xr_arena_scratch_alloc(size_t size);
+
+/*
+** 释放xr_arena_scratch_alloc分配的内存（arena中的留到arena释放）
+*/
+void xr_arena_scratch_free(void *ptr);
+
+#endif /* xarena_h */
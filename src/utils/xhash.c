@@ -56,8 +56,8 @@ uint32_t xr_hash_float(xr_Number val) {
 /* ========== 字符串哈希 ========== */
 
 uint32_t xr_hash_string(XrString *str) {
-    /* 字符串对象已经缓存了哈希值 */
-    return str->hash == 0 ? 1 : str->hash;
+    /* 首次用作键时计算，之后使用缓存（结果不为0） */
+    return xr_string_get_hash(str);
 }
 
 /* ========== 布尔值哈希 ========== */
@@ -67,6 +67,16 @@ uint32_t xr_hash_bool(int val) {
     return val ? 5 : 4;
 }
 
+/* ========== 对象哈希 ========== */
+
+uint32_t xr_hash_pointer(const void *ptr) {
+    /* 对象按身份作键：地址乘黄金比例常数，取高32位（低位因对齐总为0） */
+    uint64_t bits = (uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ULL;
+    uint32_t hash = (uint32_t)(bits >> 32);
+    
+    return hash == 0 ? 1 : hash;
+}
+
 /* ========== 统一哈希接口 ========== */
 
 uint32_t xr_hash_value(XrValue val) {
@@ -89,8 +99,8 @@ uint32_t xr_hash_value(XrValue val) {
             return xr_hash_string(xr_tostring(val));
             
         default:
-            /* 其他类型暂不支持作为Map键 */
-            return 0;
+            /* 数组、Map、实例等对象按身份哈希 */
+            return xr_hash_pointer(xr_toobj(val));
     }
 }
 
@@ -151,18 +161,18 @@ bool xr_map_keys_equal(XrValue a, XrValue b) {
                 return false;
             }
             
-            /* 再比较哈希（快速排除） */
-            if (sa->hash != sb->hash) {
+            /* 再比较哈希（快速排除，只在两边都已计算时） */
+            if (sa->hash != 0 && sb->hash != 0 && sa->hash != sb->hash) {
                 return false;
             }
             
             /* 最后比较内容 */
-            return memcmp(sa->chars, sb->chars, sa->length) == 0;
+            return memcmp(xr_string_data(sa), xr_string_data(sb), sa->length) == 0;
         }
             
         default:
-            /* 其他类型暂不支持 */
-            return false;
+            /* 对象按身份比较 */
+            return xr_toobj(a) == xr_toobj(b);
     }
 }
 
@@ -56,6 +56,12 @@ uint32_t xr_hash_string(XrString *str);
  */
 uint32_t xr_hash_bool(int val);
 
+/**
+ * 计算对象指针的哈希
+ * 对象（数组、Map、实例等）按身份作键，哈希只取决于地址
+ */
+uint32_t xr_hash_pointer(const void *ptr);
+
 /**
  * 提取短哈希（7位前缀）
  * Julia优化：用于快速排除不匹配的键
@@ -76,6 +82,7 @@ uint8_t xr_short_hash(uint32_t hash);
  *   - 类型必须相同
  *   - 字符串使用内容比较
  *   - 浮点数使用位精确比较
+ *   - 其他对象按身份（指针）比较
  */
 bool xr_map_keys_equal(XrValue a, XrValue b);
 
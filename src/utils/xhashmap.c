@@ -7,22 +7,17 @@
 
 #include "xhashmap.h"
 #include "xmem.h"
+#include "xstring.h"
 #include <string.h>
 #include <assert.h>
 
 /* ========== 内部辅助函数 ========== */
 
 /*
-** 字符串哈希函数（FNV-1a算法）
+** 字符串哈希函数（与字符串池共用按字哈希）
 */
 static uint32_t hash_string(const char *str) {
-    uint32_t hash = 2166136261u;  /* FNV offset basis */
-    while (*str) {
-        hash ^= (uint8_t)*str;
-        hash *= 16777619u;  /* FNV prime */
-        str++;
-    }
-    return hash;
+    return xr_string_hash(str, strlen(str));
 }
 
 /*
@@ -0,0 +1,249 @@
+/*
+** xslab.c
+** Xray 按尺寸分级的slab分配器实现
+*/
+
+#include "xslab.h"
+#include "xmem.h"
+#include <string.h>
+
+/* 页表初始容量（必须是2的幂） */
+#define PAGE_TABLE_INIT_CAPACITY 64
+
+/* 当前slab */
+static XrSlab *g_slab = NULL;
+
+/* 有页的slab（释放时查找块的所属slab） */
+static XrSlab *g_live_slabs = NULL;
+
+/* ========== 初始化和销毁 ========== */
+
+/*
+** 初始化slab
+*/
+void xr_slab_init(XrSlab *slab) {
+    memset(slab, 0, sizeof(XrSlab));
+}
+
+/*
+** 归还全部内存（逐个大块归还，不逐块释放）
+*/
+void xr_slab_free_all(XrSlab *slab) {
+    if (slab->chunk_count > 0) {
+        XrSlab **link = &g_live_slabs;
+        while (*link != NULL && *link != slab) {
+            link = &(*link)->next;
+        }
+        if (*link != NULL) {
+            *link = slab->next;
+        }
+    }
+    for (int i = 0; i < slab->chunk_count; i++) {
+        xmem_free(slab->chunks[i]);
+    }
+    if (slab->chunks != NULL) {
+        xmem_free(slab->chunks);
+    }
+    if (slab->page_keys != NULL) {
+        xmem_free(slab->page_keys);
+        xmem_free(slab->page_classes);
+    }
+    xr_slab_init(slab);
+}
+
+/*
+** 设置当前slab
+*/
+void xr_slab_use(XrSlab *slab) {
+    g_slab = slab;
+}
+
+/*
+** 获取当前slab
+*/
+XrSlab* xr_slab_current(void) {
+    return g_slab;
+}
+
+/* ========== 页表 ========== */
+
+/*
+** 页地址的哈希槽位
+*/
+static size_t page_slot(uintptr_t page, size_t mask) {
+    uint64_t h = (uint64_t)(page / XR_SLAB_PAGE_SIZE) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & mask;
+}
+
+/*
+** 登记页（不检查重复，页只登记一次）
+*/
+static void page_table_insert(uintptr_t *keys, uint8_t *classes, size_t capacity,
+                              uintptr_t page, uint8_t cls) {
+    size_t mask = capacity - 1;
+    size_t slot = page_slot(page, mask);
+    while (classes[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    keys[slot] = page;
+    classes[slot] = cls;
+}
+
+/*
+** 页表扩容（负载因子不超过0.5）
+*/
+static void page_table_grow(XrSlab *slab) {
+    size_t new_capacity = slab->page_capacity == 0
+                        ? PAGE_TABLE_INIT_CAPACITY : slab->page_capacity * 2;
+    uintptr_t *keys = (uintptr_t*)xmem_alloc(sizeof(uintptr_t) * new_capacity);
+    uint8_t *classes = (uint8_t*)xmem_alloc(new_capacity);
+    memset(classes, 0, new_capacity);
+    
+    for (size_t i = 0; i < slab->page_capacity; i++) {
+        if (slab->page_classes[i] != 0) {
+            page_table_insert(keys, classes, new_capacity,
+                              slab->page_keys[i], slab->page_classes[i]);
+        }
+    }
+    
+    if (slab->page_keys != NULL) {
+        xmem_free(slab->page_keys);
+        xmem_free(slab->page_classes);
+    }
+    slab->page_keys = keys;
+    slab->page_classes = classes;
+    slab->page_capacity = new_capacity;
+}
+
+/*
+** 查找指针所在页的尺寸级，不属于slab时返回-1
+** 只比较页地址，不读取指针指向的内存
+*/
+static int page_class_of(XrSlab *slab, const void *ptr) {
+    if (slab->page_count == 0) return -1;
+    
+    uintptr_t page = (uintptr_t)ptr & ~(uintptr_t)(XR_SLAB_PAGE_SIZE - 1);
+    size_t mask = slab->page_capacity - 1;
+    size_t slot = page_slot(page, mask);
+    while (slab->page_classes[slot] != 0) {
+        if (slab->page_keys[slot] == page) {
+            return slab->page_classes[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+/*
+** 指针是否由slab分配
+*/
+bool xr_slab_owns(XrSlab *slab, const void *ptr) {
+    return slab != NULL && ptr != NULL && page_class_of(slab, ptr) >= 0;
+}
+
+/* ========== 分配和释放 ========== */
+
+/*
+** 尺寸级的块大小
+*/
+static size_t class_block_size(int index) {
+    return (size_t)(index + 1) * XR_SLAB_GRANULE;
+}
+
+/*
+** 给尺寸级取一个新页
+** 大块按页对齐切分：多申请一页的空间，对齐后正好XR_SLAB_CHUNK_PAGES页
+*/
+static void class_new_page(XrSlab *slab, int index) {
+    if (slab->page_next == slab->page_end) {
+        char *raw = (char*)xmem_alloc(XR_SLAB_PAGE_SIZE * (XR_SLAB_CHUNK_PAGES + 1));
+        if (slab->chunk_count == 0) {
+            slab->next = g_live_slabs;
+            g_live_slabs = slab;
+        }
+        if (slab->chunk_count == slab->chunk_capacity) {
+            int new_capacity = slab->chunk_capacity == 0 ? 8 : slab->chunk_capacity * 2;
+            slab->chunks = (void**)xmem_realloc(
+                slab->chunks,
+                sizeof(void*) * slab->chunk_capacity,
+                sizeof(void*) * new_capacity
+            );
+            slab->chunk_capacity = new_capacity;
+        }
+        slab->chunks[slab->chunk_count++] = raw;
+        
+        uintptr_t aligned = ((uintptr_t)raw + XR_SLAB_PAGE_SIZE - 1) &
+                            ~(uintptr_t)(XR_SLAB_PAGE_SIZE - 1);
+        slab->page_next = (char*)aligned;
+        slab->page_end = slab->page_next + XR_SLAB_PAGE_SIZE * XR_SLAB_CHUNK_PAGES;
+    }
+    
+    char *page = slab->page_next;
+    slab->page_next += XR_SLAB_PAGE_SIZE;
+    
+    if ((slab->page_count + 1) * 2 > slab->page_capacity) {
+        page_table_grow(slab);
+    }
+    page_table_insert(slab->page_keys, slab->page_classes, slab->page_capacity,
+                      (uintptr_t)page, (uint8_t)(index + 1));
+    slab->page_count++;
+    
+    size_t block_size = class_block_size(index);
+    XrSlabClass *cls = &slab->classes[index];
+    cls->cursor = page;
+    cls->limit = page + (XR_SLAB_PAGE_SIZE / block_size) * block_size;
+}
+
+/*
+** 分配：先取空闲链表，再从当前页顺序切
+*/
+void* xr_slab_alloc(size_t size) {
+    XrSlab *slab = g_slab;
+    if (slab == NULL || size == 0 || size > XR_SLAB_MAX_SIZE) {
+        return xmem_alloc(size);
+    }
+    
+    int index = (int)((size - 1) / XR_SLAB_GRANULE);
+    size_t block_size = class_block_size(index);
+    XrSlabClass *cls = &slab->classes[index];
+    slab->bytes_in_use += block_size;
+    
+    if (cls->free_list != NULL) {
+        XrSlabBlock *block = cls->free_list;
+        cls->free_list = block->next;
+        return block;
+    }
+    
+    if (cls->cursor == cls->limit) {
+        class_new_page(slab, index);
+    }
+    void *block = cls->cursor;
+    cls->cursor += block_size;
+    return block;
+}
+
+/*
+** 释放：块放回所属slab对应尺寸级的空闲链表
+** 通常属于当前slab；否则查其他有页的slab（数量很少），都不是则交还xmem
+*/
+void xr_slab_free(void *ptr) {
+    if (ptr == NULL) return;
+    
+    XrSlab *slab = g_slab;
+    int index = slab != NULL ? page_class_of(slab, ptr) : -1;
+    for (XrSlab *other = g_live_slabs; index < 0 && other != NULL; other = other->next) {
+        if (other != g_slab) {
+            slab = other;
+            index = page_class_of(slab, ptr);
+        }
+    }
+    if (index < 0) {
+        xmem_free(ptr);
+        return;
+    }
+    
+    XrSlabBlock *block = (XrSlabBlock*)ptr;
+    block->next = slab->classes[index].free_list;
+    slab->classes[index].free_list = block;
+    slab->bytes_in_use -= class_block_size(index);
+}
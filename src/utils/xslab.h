@@ -0,0 +1,115 @@
+/*
+** xslab.h
+** Xray 按尺寸分级的slab分配器
+**
+** 设计特点：
+**   - 小对象按16字节分级，每级有自己的页和空闲链表，分配/释放O(1)
+**   - 同类对象挤在同一页里，没有malloc的逐块头部开销
+**   - 页按XR_SLAB_PAGE_SIZE对齐，释放时按页地址查页表得到尺寸级，
+**     查不到的指针（slab之外分配的）交还xmem，调用方不必区分来源
+**   - 有页的slab串成链表，释放时先查当前slab，再查其他slab，
+**     块总是回到分配它的slab（多个VM并存时当前slab未必是它）
+**   - 销毁时整体归还所有页（xr_slab_free_all）
+**
+** 用途：
+**   - VM持有一个slab（见VM.slab），运行期间设为当前slab，
+**     upvalue、闭包、实例、字符串等定长对象从它分配
+**   - 没有当前slab时（编译器、独立测试）直接走xmem
+**
+** 参考：
+**   - Bonwick, The Slab Allocator (1994)
+**   - Lua 5.4的luaM_内存接口（分配器由状态机持有）
+*/
+
+#ifndef xslab_h
+#define xslab_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 页大小（页按它对齐） */
+#define XR_SLAB_PAGE_SIZE 4096
+
+/* 尺寸级差和最大块尺寸（更大的请求直接走xmem） */
+#define XR_SLAB_GRANULE 16
+#define XR_SLAB_MAX_SIZE 256
+#define XR_SLAB_CLASSES (XR_SLAB_MAX_SIZE / XR_SLAB_GRANULE)
+
+/* 每次向xmem申请的页数 */
+#define XR_SLAB_CHUNK_PAGES 16
+
+/* 空闲块（空闲时复用块本身的内存串成链表） */
+typedef struct XrSlabBlock {
+    struct XrSlabBlock *next;
+} XrSlabBlock;
+
+/* 一个尺寸级 */
+typedef struct {
+    XrSlabBlock *free_list;     /* 释放回来的块 */
+    char *cursor;               /* 当前页中下一个未用过的块 */
+    char *limit;                /* 当前页可用部分的末尾 */
+} XrSlabClass;
+
+/*
+** slab分配器
+** 页表是以页地址为键的开放寻址哈希表，值为尺寸级+1（0表示空槽）
+*/
+typedef struct XrSlab {
+    XrSlabClass classes[XR_SLAB_CLASSES];
+    
+    void **chunks;              /* 向xmem申请的大块（销毁时逐个归还） */
+    int chunk_count;
+    int chunk_capacity;
+    char *page_next;            /* 当前大块中下一个未分配的页 */
+    char *page_end;             /* 当前大块中对齐页的末尾 */
+    
+    uintptr_t *page_keys;       /* 页表：页地址 */
+    uint8_t *page_classes;      /* 页表：尺寸级+1 */
+    size_t page_capacity;       /* 页表容量（2的幂） */
+    size_t page_count;          /* 已登记的页数 */
+    
+    size_t bytes_in_use;        /* 已分配出去的块字节数 */
+    
+    struct XrSlab *next;        /* 有页的slab链表（见xr_slab_free） */
+} XrSlab;
+
+/*
+** 初始化slab（不分配内存）
+*/
+void xr_slab_init(XrSlab *slab);
+
+/*
+** 归还slab的全部内存，之后回到初始状态
+** 从slab分配而尚未释放的块一并失效
+*/
+void xr_slab_free_all(XrSlab *slab);
+
+/*
+** 设置当前slab（NULL表示不用slab）
+*/
+void xr_slab_use(XrSlab *slab);
+
+/*
+** 获取当前slab
+*/
+XrSlab* xr_slab_current(void);
+
+/*
+** 分配size字节
+** 有当前slab且size不超过XR_SLAB_MAX_SIZE时从slab分配，否则走xmem
+*/
+void* xr_slab_alloc(size_t size);
+
+/*
+** 释放xr_slab_alloc分配的内存
+** 块回到分配它的slab（不必是当前slab），不属于任何slab的指针交还xmem
+*/
+void xr_slab_free(void *ptr);
+
+/*
+** 指针是否由slab分配
+*/
+bool xr_slab_owns(XrSlab *slab, const void *ptr);
+
+#endif /* xslab_h */
@@ -0,0 +1,134 @@
+/*
+** xtest_vm.h
+** Xray 测试框架 - 字节码VM脚本测试
+**
+** 职责：
+**   - 截获print输出
+**   - 解析 → 编译 → 执行 → 比较输出
+**   - 执行之后、释放之前交给测试做额外检查
+**
+** 各测试只保留脚本源码和断言
+*/
+
+#ifndef xtest_vm_h
+#define xtest_vm_h
+
+#include "xcompiler.h"
+#include "xcompiler_context.h"
+#include "xvm.h"
+#include "xparse.h"
+#include "xstate.h"
+#include "xast.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ========== 截获print输出 ========== */
+
+typedef struct {
+    char data[1024];   /* 截获的输出（以'\0'结尾，超出部分丢弃） */
+    size_t length;     /* 已截获的字节数 */
+    int writes;        /* 输出回调被调用的次数 */
+} XTestCapture;
+
+static void xtest_capture_output(const char *data, size_t length, void *ud) {
+    XTestCapture *cap = (XTestCapture*)ud;
+    if (cap->length + length < sizeof(cap->data)) {
+        memcpy(cap->data + cap->length, data, length);
+        cap->length += length;
+        cap->data[cap->length] = '\0';
+    }
+    cap->writes++;
+}
+
+/* ========== 编译和执行 ========== */
+
+/*
+** 解析并编译脚本
+** 成功时*ast_out是AST，由调用者与返回的原型一并释放；失败时打印原因，返回NULL
+*/
+static Proto *xtest_compile_script(XrayState *X, const char *source, AstNode **ast_out) {
+    *ast_out = NULL;
+    AstNode *ast = xr_parse(X, source);
+    if (ast == NULL) {
+        printf("✗ 解析失败\n");
+        return NULL;
+    }
+    
+    CompilerContext *ctx = xr_compiler_context_new();
+    Proto *proto = xr_compile(ctx, ast);
+    xr_compiler_context_free(ctx);
+    if (proto == NULL) {
+        printf("✗ 编译失败\n");
+        xr_ast_free(X, ast);
+        return NULL;
+    }
+    
+    *ast_out = ast;
+    return proto;
+}
+
+/*
+** 在vm上执行一次原型，检查执行结果和输出
+** cap为NULL时用临时缓冲；expected为NULL时不比较输出
+** 返回后输出目标恢复为stdout
+*/
+static int xtest_run_proto(VM *vm, Proto *proto, XTestCapture *cap,
+                           const char *expected, InterpretResult expected_result) {
+    XTestCapture local;
+    if (cap == NULL) {
+        cap = &local;
+    }
+    memset(cap, 0, sizeof(*cap));
+    
+    xr_bc_vm_set_output(vm, xtest_capture_output, cap);
+    InterpretResult result = xr_bc_interpret_proto(vm, proto);
+    xr_bc_vm_flush_output(vm);
+    xr_bc_vm_set_output(vm, NULL, NULL);
+    
+    if (result != expected_result) {
+        printf("✗ 执行结果为%d，应为%d\n", (int)result, (int)expected_result);
+        return 1;
+    }
+    if (expected != NULL && strcmp(cap->data, expected) != 0) {
+        printf("✗ 输出不符:\n%s\n", cap->data);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+** 额外检查：执行之后、VM和原型释放之前调用，返回失败数
+*/
+typedef int (*XTestScriptCheck)(VM *vm, Proto *proto, void *ud);
+
+/*
+** 在新VM上编译并执行脚本，检查结果、输出，再调用after（可为NULL）
+** 打印"✓ name"或"✗ name"，返回失败数（0或1）
+*/
+static int xtest_run_script(XrayState *X, const char *name, const char *source,
+                            const char *expected, InterpretResult expected_result,
+                            XTestScriptCheck after, void *ud) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    
+    AstNode *ast;
+    Proto *proto = xtest_compile_script(X, source, &ast);
+    if (proto == NULL) {
+        printf("✗ %s\n", name);
+        xr_bc_vm_free(&vm);
+        return 1;
+    }
+    
+    int failed = xtest_run_proto(&vm, proto, NULL, expected, expected_result);
+    if (after != NULL) {
+        failed += after(&vm, proto, ud);
+    }
+    printf("%s %s\n", failed == 0 ? "✓" : "✗", name);
+    
+    xr_bc_vm_free(&vm);
+    xr_bc_proto_free(proto);
+    xr_ast_free(X, ast);
+    return failed == 0 ? 0 : 1;
+}
+
+#endif /* xtest_vm_h */
@@ -0,0 +1,159 @@
+/* test_arena.c - 线性分配器单元测试
+ *
+ * 测试内容：
+ *   1. 顺序分配、对齐、块内不重叠
+ *   2. 最近一次分配原地扩展，其余复制
+ *   3. 大请求单独成块，不打断当前块
+ *   4. 当前arena与临时内存
+ *   5. xr_parse的AST整棵分配在程序节点持有的arena中
+ */
+
+#include "xarena.h"
+#include "xparse.h"
+#include "xstate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TEST(name) \
+    printf("测试: %s...", #name); \
+    test_##name(); \
+    printf(" ✓\n");
+
+#define ASSERT(cond, msg) \
+    if (!(cond)) { \
+        printf("\n✗ 断言失败: %s\n", msg); \
+        printf("  文件: %s:%d\n", __FILE__, __LINE__); \
+        exit(1); \
+    }
+
+/* ========== 测试用例 ========== */
+
+/* 测试1: 顺序分配、对齐、跨块 */
+void test_bump() {
+    XrArena *arena = xr_arena_new();
+    ASSERT(arena->block_count == 0, "创建时不应申请块");
+    
+    char *a = (char*)xr_arena_alloc(arena, 3);
+    char *b = (char*)xr_arena_alloc(arena, 40);
+    ASSERT((uintptr_t)a % XR_ARENA_ALIGN == 0, "分配没有对齐");
+    ASSERT((uintptr_t)b % XR_ARENA_ALIGN == 0, "分配没有对齐");
+    ASSERT(b == a + XR_ARENA_ALIGN, "没有顺序切分");
+    
+    /* 写满多块，内容互不覆盖 */
+    int count = XR_ARENA_BLOCK_SIZE / 64 * 3;
+    char **blocks = (char**)malloc(sizeof(char*) * count);
+    for (int i = 0; i < count; i++) {
+        blocks[i] = (char*)xr_arena_alloc(arena, 64);
+        memset(blocks[i], i & 0xFF, 64);
+    }
+    ASSERT(arena->block_count >= 3, "应该申请了多个块");
+    for (int i = 0; i < count; i++) {
+        ASSERT(xr_arena_owns(arena, blocks[i]), "块不属于arena");
+        ASSERT((unsigned char)blocks[i][63] == (i & 0xFF), "块内容被覆盖");
+    }
+    ASSERT(!xr_arena_owns(arena, blocks), "malloc的内存被当作arena内存");
+    
+    free(blocks);
+    xr_arena_free(arena);
+}
+
+/* 测试2: 扩展数组 */
+void test_realloc() {
+    XrArena *arena = xr_arena_new();
+    
+    int *items = (int*)xr_arena_realloc(arena, NULL, 0, sizeof(int) * 4);
+    for (int i = 0; i < 4; i++) items[i] = i;
+    
+    /* 最近一次分配：原地扩展 */
+    int *grown = (int*)xr_arena_realloc(arena, items, sizeof(int) * 4, sizeof(int) * 64);
+    ASSERT(grown == items, "最近一次分配应原地扩展");
+    
+    /* 之后有别的分配：复制到新位置 */
+    char *name = xr_arena_strndup(arena, "hello world", 5);
+    ASSERT(strcmp(name, "hello") == 0, "字符串复制错误");
+    int *moved = (int*)xr_arena_realloc(arena, grown, sizeof(int) * 64, sizeof(int) * 128);
+    ASSERT(moved != grown, "不是最近一次分配却原地扩展");
+    ASSERT(moved[3] == 3, "复制丢失了内容");
+    ASSERT(strcmp(name, "hello") == 0, "扩展覆盖了后面的分配");
+    
+    xr_arena_free(arena);
+}
+
+/* 测试3: 大请求单独成块 */
+void test_large() {
+    XrArena *arena = xr_arena_new();
+    
+    char *small = (char*)xr_arena_alloc(arena, 16);
+    char *big = (char*)xr_arena_alloc(arena, XR_ARENA_BLOCK_SIZE * 2);
+    memset(big, 0xAB, XR_ARENA_BLOCK_SIZE * 2);
+    char *next = (char*)xr_arena_alloc(arena, 16);
+    
+    ASSERT(arena->block_count == 2, "大请求应单独成块");
+    ASSERT(next == small + 16, "大请求打断了当前块");
+    ASSERT(xr_arena_owns(arena, big + XR_ARENA_BLOCK_SIZE), "大块不属于arena");
+    
+    xr_arena_free(arena);
+}
+
+/* 测试4: 当前arena和临时内存 */
+void test_scratch() {
+    ASSERT(xr_arena_current() == NULL, "默认不应有当前arena");
+    
+    /* 没有当前arena：走xmem */
+    void *plain = xr_arena_scratch_alloc(32);
+    xr_arena_scratch_free(plain);
+    
+    XrArena *arena = xr_arena_new();
+    xr_arena_use(arena);
+    void *temp = xr_arena_scratch_alloc(32);
+    ASSERT(xr_arena_owns(arena, temp), "临时内存应从当前arena分配");
+    xr_arena_scratch_free(temp);  /* 留到arena释放 */
+    
+    /* 释放当前arena时一并清除 */
+    xr_arena_free(arena);
+    ASSERT(xr_arena_current() == NULL, "释放后仍是当前arena");
+}
+
+/* 测试5: xr_parse的AST在arena中，xr_ast_free一次释放 */
+void test_parse_session() {
+    XrayState *X = xr_state_new();
+    
+    AstNode *ast = xr_parse(X,
+        "let items = [1, 2, 3]\n"
+        "function add(a, b) { return a + b }\n"
+        "print(add(items[0], items[1]))\n");
+    ASSERT(ast != NULL, "解析失败");
+    XrArena *arena = ast->as.program.arena;
+    ASSERT(arena != NULL, "程序节点没有持有arena");
+    ASSERT(xr_arena_current() == NULL, "解析后没有恢复当前arena");
+    ASSERT(xr_arena_owns(arena, ast), "程序节点不在arena中");
+    ASSERT(ast->as.program.count == 3, "语句数量错误");
+    
+    AstNode *func = ast->as.program.statements[1];
+    ASSERT(xr_arena_owns(arena, func), "函数节点不在arena中");
+    ASSERT(xr_arena_owns(arena, func->as.function_decl.name), "函数名不在arena中");
+    ASSERT(xr_arena_owns(arena, func->as.function_decl.parameters[1]), "参数名不在arena中");
+    
+    xr_ast_free(X, ast);
+    
+    /* 解析失败时arena直接释放 */
+    ASSERT(xr_parse(X, "let = 1") == NULL, "错误的源码解析成功");
+    ASSERT(xr_arena_current() == NULL, "解析失败后没有恢复当前arena");
+    
+    xr_state_free(X);
+}
+
+int main() {
+    printf("========== 线性分配器单元测试 ==========\n\n");
+    
+    TEST(bump);
+    TEST(realloc);
+    TEST(large);
+    TEST(scratch);
+    TEST(parse_session);
+    
+    printf("\n========== 所有测试通过! ==========\n");
+    return 0;
+}
@@ -11,7 +11,9 @@
 
 #include "xarray.h"
 #include "xvalue.h"
+#include "xstring.h"
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 /* 测试计数器 */
@@ -291,6 +293,116 @@ void test_array_index_of() {
     xr_array_free(arr);
 }
 
+void test_array_copy_on_write() {
+    printf("\n=== 测试写时复制 ===\n");
+    
+    XrArray *arr = xr_array_new();
+    for (int i = 0; i < 5; i++) {
+        xr_array_push(arr, xr_int(i));
+    }
+    
+    XrArray *copy = xr_array_copy(arr);
+    ASSERT(copy->count == 5, "副本长度为5");
+    ASSERT(copy->elements == arr->elements, "副本与源数组共享存储");
+    ASSERT(xr_array_is_shared(arr), "源数组处于共享状态");
+    
+    // 写副本：副本分离，源数组不变
+    xr_array_set(copy, 0, xr_int(100));
+    ASSERT(copy->elements != arr->elements, "写入后副本独立");
+    ASSERT(xr_toint(xr_array_get(copy, 0)) == 100, "副本已修改");
+    ASSERT(xr_toint(xr_array_get(arr, 0)) == 0, "源数组未受影响");
+    ASSERT(!xr_array_is_shared(arr), "源数组不再共享");
+    
+    // 源数组重新获得独占存储，可继续追加
+    xr_array_push(arr, xr_int(5));
+    ASSERT(arr->count == 6, "源数组追加成功");
+    ASSERT(copy->count == 5, "副本长度不变");
+    
+    xr_array_free(copy);
+    xr_array_free(arr);
+}
+
+void test_array_slice() {
+    printf("\n=== 测试切片视图 ===\n");
+    
+    XrArray *arr = xr_array_new();
+    for (int i = 0; i < 10; i++) {
+        xr_array_push(arr, xr_int(i * 10));
+    }
+    
+    XrArray *slice = xr_array_slice(arr, 2, 5);
+    ASSERT(slice->count == 3, "切片长度为3");
+    ASSERT(slice->elements == arr->elements + 2, "切片是偏移视图");
+    ASSERT(xr_toint(xr_array_get(slice, 0)) == 20, "切片第一个元素是20");
+    ASSERT(xr_toint(xr_array_get(slice, 2)) == 40, "切片最后一个元素是40");
+    
+    XrArray *tail = xr_array_slice(arr, -3, 100);
+    ASSERT(tail->count == 3, "负索引切片长度为3");
+    ASSERT(xr_toint(xr_array_get(tail, 0)) == 70, "负索引从末尾计数");
+    
+    XrArray *empty = xr_array_slice(arr, 6, 3);
+    ASSERT(empty->count == 0, "反向区间得到空数组");
+    
+    // shift 只移动视图起点
+    XrValue first = xr_array_shift(slice);
+    ASSERT(xr_toint(first) == 20, "切片shift返回20");
+    ASSERT(slice->elements == arr->elements + 3, "shift不复制元素");
+    
+    // 写切片：源数组不变
+    xr_array_push(slice, xr_int(999));
+    ASSERT(slice->count == 3, "切片push后长度为3");
+    ASSERT(xr_toint(xr_array_get(arr, 5)) == 50, "源数组未受影响");
+    
+    // 源数组释放后，切片仍然有效
+    xr_array_free(arr);
+    ASSERT(xr_toint(xr_array_get(tail, 2)) == 90, "源数组释放后切片仍有效");
+    xr_array_set(tail, 0, xr_int(-1));
+    ASSERT(xr_toint(xr_array_get(tail, 0)) == -1, "独占后切片可写");
+    
+    xr_array_free(empty);
+    xr_array_free(tail);
+    xr_array_free(slice);
+}
+
+void test_array_join() {
+    printf("\n=== 测试join ===\n");
+    
+    XrArray *arr = xr_array_new();
+    xr_array_push(arr, xr_string_value(xr_string_intern("id", 2, 0)));
+    xr_array_push(arr, xr_int(-42));
+    xr_array_push(arr, xr_float(2.5));
+    xr_array_push(arr, xr_float(3.0));
+    xr_array_push(arr, xr_bool(true));
+    xr_array_push(arr, xr_null());
+    
+    XrString *comma = xr_string_intern(",", 1, 0);
+    XrString *row = xr_array_join(arr, comma);
+    ASSERT(strcmp(row->chars, "id,-42,2.5,3,true,null") == 0, "混合类型join");
+    ASSERT(row->length == strlen("id,-42,2.5,3,true,null"), "join长度精确");
+    ASSERT(row == xr_string_intern(row->chars, row->length, 0), "join结果已驻留");
+    ASSERT(xr_array_join(arr, comma) == row, "相同内容返回同一驻留字符串");
+    
+    XrString *plain = xr_array_join(arr, NULL);
+    ASSERT(strcmp(plain->chars, "id-422.53truenull") == 0, "无分隔符join");
+    
+    XrArray *empty = xr_array_new();
+    ASSERT(xr_array_join(empty, comma)->length == 0, "空数组join为空字符串");
+    
+    // 大量元素：结果长度线性增长
+    XrArray *big = xr_array_new();
+    for (int i = 0; i < 1000; i++) {
+        xr_array_push(big, xr_int(i));
+    }
+    XrString *joined = xr_array_join(big, comma);
+    ASSERT(joined->length == 10 + 90 * 2 + 900 * 3 + 999, "1000个整数join长度正确");
+    ASSERT(strncmp(joined->chars, "0,1,2,", 6) == 0, "join开头正确");
+    ASSERT(strcmp(joined->chars + joined->length - 7, "998,999") == 0, "join结尾正确");
+    
+    xr_array_free(big);
+    xr_array_free(empty);
+    xr_array_free(arr);
+}
+
 /* ====== 主测试函数 ====== */
 
 int main(void) {
@@ -309,6 +421,9 @@ int main(void) {
     test_array_unshift_shift();
     test_array_contains();
     test_array_index_of();
+    test_array_copy_on_write();
+    test_array_slice();
+    test_array_join();
     
     printf("\n");
     printf("========================================\n");
@@ -0,0 +1,158 @@
+/*
+** test_concat_bc.c
+** 测试循环内 s = s + e 降级为字符串构建器
+*/
+
+#include "xtest_vm.h"
+#include "xchunk.h"
+
+/* 降级只针对局部变量，拼接都写在函数里 */
+
+/* while、for、for-in三种循环各一个 */
+static const char *loops_source =
+    "function joinWhile(n) {\n"
+    "    let s = \"w\"\n"
+    "    let i = 0\n"
+    "    while (i < n) {\n"
+    "        s = s + i\n"
+    "        i = i + 1\n"
+    "    }\n"
+    "    return s\n"
+    "}\n"
+    "function joinFor(n) {\n"
+    "    let s = \"\"\n"
+    "    for (let i = 0; i < n; i = i + 1) {\n"
+    "        s = s + \"-\"\n"
+    "        s = s + i\n"
+    "    }\n"
+    "    return s\n"
+    "}\n"
+    "function joinForIn(items) {\n"
+    "    let s = \"<\"\n"
+    "    for (let v in items) {\n"
+    "        s = s + v\n"
+    "    }\n"
+    "    return s + \">\"\n"
+    "}\n"
+    "print(joinWhile(5))\n"
+    "print(joinFor(3))\n"
+    "print(joinForIn([\"a\", \"b\", \"c\"]))\n";
+
+static const char *loops_expected = "w01234\n-0-1-2\n<abc>\n";
+
+/* 进入循环时s不是字符串：构建器不开启，执行普通加法 */
+static const char *fallback_source =
+    "function sum(n) {\n"
+    "    let s = 0\n"
+    "    for (let i = 1; i <= n; i = i + 1) {\n"
+    "        s = s + i\n"
+    "    }\n"
+    "    return s\n"
+    "}\n"
+    "function half(n) {\n"
+    "    let s = 0.5\n"
+    "    let i = 0\n"
+    "    while (i < n) {\n"
+    "        s = s + 1\n"
+    "        i = i + 1\n"
+    "    }\n"
+    "    return s\n"
+    "}\n"
+    "print(sum(10))\n"
+    "print(half(2))\n";
+
+static const char *fallback_expected = "55\n2.5\n";
+
+/* 嵌套循环：外层和内层各降级一个变量，内层复用外层已开启的构建器 */
+static const char *nested_source =
+    "function grid(n) {\n"
+    "    let out = \"\"\n"
+    "    for (let i = 0; i < n; i = i + 1) {\n"
+    "        let row = \"\"\n"
+    "        for (let j = 0; j < n; j = j + 1) {\n"
+    "            row = row + j\n"
+    "            out = out + \".\"\n"
+    "        }\n"
+    "        out = out + row\n"
+    "        out = out + \";\"\n"
+    "    }\n"
+    "    return out\n"
+    "}\n"
+    "print(grid(3))\n";
+
+static const char *nested_expected = "...012;...012;...012;\n";
+
+/* 循环里读了s：不降级，每轮都能看到当前值 */
+static const char *read_source =
+    "function trace(n) {\n"
+    "    let s = \"\"\n"
+    "    let i = 0\n"
+    "    while (i < n) {\n"
+    "        s = s + i\n"
+    "        print(s)\n"
+    "        i = i + 1\n"
+    "    }\n"
+    "    return s\n"
+    "}\n"
+    "print(trace(3))\n";
+
+static const char *read_expected = "0\n01\n012\n012\n";
+
+/* 原型（含嵌套函数）中某条指令的数量 */
+static int count_opcode(Proto *proto, OpCode op) {
+    int count = 0;
+    for (int i = 0; i < proto->sizecode; i++) {
+        if (GET_OPCODE(proto->code[i]) == op) {
+            count++;
+        }
+    }
+    for (int i = 0; i < proto->sizeprotos; i++) {
+        count += count_opcode(proto->protos[i], op);
+    }
+    return count;
+}
+
+/*
+** 降级的循环变量数（SBBEGIN条数，ud指向期望值），构建器都已结束
+*/
+static int check_lowered(VM *vm, Proto *proto, void *ud) {
+    int lowered = *(int*)ud;
+    int failed = 0;
+    int begins = count_opcode(proto, OP_SBBEGIN);
+    int ends = count_opcode(proto, OP_SBEND);
+    if (begins != lowered || ends != lowered) {
+        printf("✗ 降级了%d个变量，应为%d个\n", begins, lowered);
+        failed = 1;
+    }
+    if (vm->builder_count != 0) {
+        printf("✗ 构建器没有全部结束\n");
+        failed = 1;
+    }
+    return failed;
+}
+
+/* 执行脚本并检查降级数 */
+static int run_lowered(XrayState *X, const char *name, const char *source,
+                       const char *expected, int lowered) {
+    return xtest_run_script(X, name, source, expected, INTERPRET_OK,
+                            check_lowered, &lowered);
+}
+
+int main(void) {
+    printf("=== Loop Concat Test ===\n\n");
+    
+    XrayState *X = xr_state_new();
+    
+    int failed = 0;
+    failed += run_lowered(X, "三种循环", loops_source, loops_expected, 3);
+    failed += run_lowered(X, "非字符串退回加法", fallback_source, fallback_expected, 2);
+    failed += run_lowered(X, "嵌套循环", nested_source, nested_expected, 2);
+    failed += run_lowered(X, "循环中读取s", read_source, read_expected, 0);
+    
+    xr_state_free(X);
+    
+    if (failed == 0) {
+        printf("\n✓ 循环拼接测试通过\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
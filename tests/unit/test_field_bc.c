@@ -0,0 +1,57 @@
+/*
+** test_field_bc.c
+** 测试常量字符串键（GETFIELD/SETFIELD）共用常量池槽位
+*/
+
+#include "xtest_vm.h"
+#include "xchunk.h"
+#include "xstring.h"
+
+/* Map字面量、下标读和下标写都用同样的键k、j */
+static const char *field_source =
+    "let m = {k: 1, j: 2}\n"
+    "m[\"k\"] = m[\"k\"] + m[\"k\"]\n"
+    "m[\"k\"] = m[\"k\"] + m[\"j\"]\n"
+    "print(m[\"k\"])\n"
+    "print(m[\"j\"])\n";
+
+static const char *field_expected = "4\n2\n";
+
+/* 原型常量池中内容为text的字符串个数 */
+static int count_string_constant(Proto *proto, const char *text) {
+    int count = 0;
+    for (int i = 0; i < proto->constants.count; i++) {
+        XrValue value = proto->constants.values[i];
+        if (xr_isstring(value) && strcmp(xr_tostring(value)->chars, text) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* 同一个键只占一个常量槽位 */
+static int check_shared_keys(VM *vm, Proto *proto, void *ud) {
+    (void)vm;
+    (void)ud;
+    int k_count = count_string_constant(proto, "k");
+    int j_count = count_string_constant(proto, "j");
+    if (k_count != 1 || j_count != 1) {
+        printf("✗ 键k有%d个常量，键j有%d个常量，应各为1个\n", k_count, j_count);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    printf("=== Field Key Test ===\n\n");
+    
+    XrayState *X = xr_state_new();
+    int failed = xtest_run_script(X, "常量字符串键", field_source, field_expected,
+                                  INTERPRET_OK, check_shared_keys, NULL);
+    xr_state_free(X);
+    
+    if (failed == 0) {
+        printf("\n✓ 常量字符串键测试通过\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/*
+** test_for_in_bc.c
+** 测试for-in循环（ITERPREP/ITERNEXT）
+*/
+
+#include "xtest_vm.h"
+#include "xchunk.h"
+
+/* 数组：单变量绑定元素，双变量绑定下标和元素；空数组不执行循环体 */
+static const char *array_source =
+    "let items = [\"a\", \"b\", \"c\"]\n"
+    "let values = \"\"\n"
+    "for (let v in items) {\n"
+    "    values = values + v\n"
+    "}\n"
+    "print(values)\n"
+    "let pairs = \"\"\n"
+    "for (let i, v in items) {\n"
+    "    pairs = pairs + i + v + \" \"\n"
+    "}\n"
+    "print(pairs)\n"
+    "let count = 0\n"
+    "for (let v in []) {\n"
+    "    count = count + 1\n"
+    "}\n"
+    "print(count)\n";
+
+static const char *array_expected = "abc\n0a 1b 2c \n0\n";
+
+/*
+** Map：0、1是稠密整数键，进入数组部分，先按升序迭代；
+** x、y在哈希部分，按插入顺序迭代
+*/
+static const char *map_source =
+    "let m = {x: 1, y: 2}\n"
+    "m[0] = \"zero\"\n"
+    "m[1] = \"one\"\n"
+    "let keys = \"\"\n"
+    "for (let k in m) {\n"
+    "    keys = keys + k + \",\"\n"
+    "}\n"
+    "print(keys)\n"
+    "let entries = \"\"\n"
+    "for (let k, v in m) {\n"
+    "    entries = entries + k + \"=\" + v + \";\"\n"
+    "}\n"
+    "print(entries)\n"
+    "let sum = 0\n"
+    "for (let k, v in {a: 10, b: 20, c: 30}) {\n"
+    "    sum = sum + v\n"
+    "}\n"
+    "print(sum)\n";
+
+static const char *map_expected = "0,1,x,y,\n0=zero;1=one;x=1;y=2;\n60\n";
+
+/* 嵌套for-in：各自的游标在各自的隐藏寄存器里 */
+static const char *nested_source =
+    "let rows = [[1, 2], [3], []]\n"
+    "let total = 0\n"
+    "let cells = 0\n"
+    "for (let row in rows) {\n"
+    "    for (let cell in row) {\n"
+    "        total = total + cell\n"
+    "        cells = cells + 1\n"
+    "    }\n"
+    "}\n"
+    "print(total)\n"
+    "print(cells)\n";
+
+static const char *nested_expected = "6\n3\n";
+
+/* 不是数组或Map：在ITERPREP处报运行时错误，循环体不执行 */
+static const char *int_source =
+    "print(\"before\")\n"
+    "for (let v in 42) {\n"
+    "    print(v)\n"
+    "}\n"
+    "print(\"after\")\n";
+
+static const char *string_source =
+    "print(\"before\")\n"
+    "for (let i, c in \"abc\") {\n"
+    "    print(c)\n"
+    "}\n"
+    "print(\"after\")\n";
+
+static const char *error_expected = "before\n";
+
+/*
+** 运行时错误会清空调用帧，顶层帧的pc仍停在出错指令之后：
+** 出错的指令应是ITERPREP
+*/
+static int check_iterprep_error(VM *vm, Proto *proto, void *ud) {
+    (void)proto;
+    (void)ud;
+    if (GET_OPCODE(vm->frames[0].pc[-1]) != OP_ITERPREP) {
+        printf("✗ 错误不是由ITERPREP报告的\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    printf("=== For-In Test ===\n\n");
+    
+    XrayState *X = xr_state_new();
+    
+    int failed = 0;
+    failed += xtest_run_script(X, "数组", array_source, array_expected,
+                               INTERPRET_OK, NULL, NULL);
+    failed += xtest_run_script(X, "Map", map_source, map_expected,
+                               INTERPRET_OK, NULL, NULL);
+    failed += xtest_run_script(X, "嵌套", nested_source, nested_expected,
+                               INTERPRET_OK, NULL, NULL);
+    
+    /* 期望stderr出现 "for-in requires an array or map" */
+    failed += xtest_run_script(X, "整数", int_source, error_expected,
+                               INTERPRET_RUNTIME_ERROR, check_iterprep_error, NULL);
+    failed += xtest_run_script(X, "字符串", string_source, error_expected,
+                               INTERPRET_RUNTIME_ERROR, check_iterprep_error, NULL);
+    
+    xr_state_free(X);
+    
+    if (failed == 0) {
+        printf("\n✓ for-in测试通过\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
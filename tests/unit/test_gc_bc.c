@@ -0,0 +1,465 @@
+/*
+** test_gc_bc.c
+** 测试字节码VM的垃圾回收
+*/
+
+#include "xtest_vm.h"
+#include "xvm_gc.h"
+#include "xarray.h"
+#include "xmap.h"
+#include "xstring.h"
+
+/* 循环里不断产生数组、Map、实例、字符串，只有少数值一直存活 */
+static const char *garbage_source =
+    "class Point {\n"
+    "    x: int\n"
+    "    y: int\n"
+    "    constructor(px: int, py: int) {\n"
+    "        this.x = px\n"
+    "        this.y = py\n"
+    "    }\n"
+    "}\n"
+    "function makeCounter() {\n"
+    "    let count = 0\n"
+    "    function increment() {\n"
+    "        count = count + 1\n"
+    "        return count\n"
+    "    }\n"
+    "    return increment\n"
+    "}\n"
+    "let keep = [1, 2, \"three\"]\n"
+    "let counter = makeCounter()\n"
+    "let total = 0\n"
+    "for (let i = 0; i < 3000; i = i + 1) {\n"
+    "    let tmp = [i, i + 1]\n"
+    "    let m = {k: i}\n"
+    "    let p = new Point(i, i)\n"
+    "    let s = \"item\" + i\n"
+    "    total = total + counter()\n"
+    "}\n"
+    "print(total)\n"
+    "print(keep[2])\n"
+    "print(counter())\n";
+
+static const char *garbage_expected = "4501500\nthree\n3001\n";
+
+/*
+** 老年代容器不断被写入新对象：holder和names很快晋升，
+** 之后写入的数组和字符串只经由它们可达，靠写屏障存活
+*/
+static const char *barrier_source =
+    "let holder = [0, 0, 0, 0, 0, 0, 0, 0, 0, 0]\n"
+    "let names = [\"\", \"\", \"\", \"\", \"\", \"\", \"\", \"\", \"\", \"\"]\n"
+    "let cache = {last: 0}\n"
+    "let j = 0\n"
+    "for (let i = 0; i < 2000; i = i + 1) {\n"
+    "    holder[j] = [i]\n"
+    "    names[j] = \"name\" + i\n"
+    "    cache.last = [i, i]\n"
+    "    let junk = {k: i}\n"
+    "    j = j + 1\n"
+    "    if (j == 10) {\n"
+    "        j = 0\n"
+    "    }\n"
+    "}\n"
+    "let sum = 0\n"
+    "for (let k = 0; k < 10; k = k + 1) {\n"
+    "    sum = sum + holder[k][0]\n"
+    "}\n"
+    "print(sum)\n"
+    "print(names[9])\n"
+    "print(cache.last[1])\n";
+
+static const char *barrier_expected = "19945\nname1999\n1999\n";
+
+/*
+** WeakMap以实例为键：按身份查找和更新；键不可达后条目被删除，
+** 包括值引用自身键的条目。b只被cache[a]的值引用，其条目要保留
+*/
+static const char *weak_source =
+    "class Key {\n"
+    "    id: int\n"
+    "    constructor(i: int) {\n"
+    "        this.id = i\n"
+    "    }\n"
+    "}\n"
+    "let cache = new WeakMap()\n"
+    "let keep = new Key(0)\n"
+    "cache[keep] = \"first\"\n"
+    "cache[keep] = \"updated\"\n"
+    "let a = new Key(-1)\n"
+    "let b = new Key(-2)\n"
+    "cache[b] = [b]\n"
+    "cache[a] = b\n"
+    "b = null\n"
+    "let hits = 0\n"
+    "for (let i = 1; i < 500; i = i + 1) {\n"
+    "    let k = new Key(i)\n"
+    "    cache[k] = [k, i]\n"
+    "    if (cache[k][1] == i) {\n"
+    "        hits = hits + 1\n"
+    "    }\n"
+    "}\n"
+    "print(cache[keep])\n"
+    "print(hits)\n";
+
+static const char *weak_expected = "updated\n499\n";
+
+/* 链表中的对象数量 */
+static int count_objects(XrObject *list) {
+    int count = 0;
+    for (XrObject *object = list; object != NULL; object = object->next) {
+        count++;
+    }
+    return count;
+}
+
+/*
+** 运行脚本，检查输出和回收效果
+** stress为true时每个安全点都GC（以minor GC为主，穿插增量标记）
+** 最后做一次完整GC，剩余对象不超过max_objects，upvalue恰好upvalues个
+*/
+static int run_script(XrayState *X, const char *source, const char *expected,
+                      bool stress, int max_objects, int upvalues) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    vm.gc_stress = stress;
+    
+    AstNode *ast;
+    Proto *proto = xtest_compile_script(X, source, &ast);
+    if (proto == NULL) {
+        xr_bc_vm_free(&vm);
+        return 1;
+    }
+    
+    int failed = xtest_run_proto(&vm, proto, NULL, expected, INTERPRET_OK);
+    
+    /* 回收之后只剩全局变量可达的对象 */
+    unsigned int minor = vm.gc_epoch - vm.gc_full_count;
+    xr_bc_gc_collect(&vm);
+    int objects = count_objects(vm.objects);
+    int live_upvalues = count_objects(vm.upvalues);
+    printf("%s: %u次minor GC，%u次完整GC，剩余对象%d个，upvalue %d个\n",
+           stress ? "压力模式" : "阈值模式", minor, vm.gc_full_count,
+           objects, live_upvalues);
+    if (objects > max_objects || live_upvalues != upvalues) {
+        printf("✗ 垃圾没有被回收\n");
+        failed = 1;
+    }
+    if (vm.young[0] != NULL || vm.remembered_count != 0) {
+        printf("✗ 完整GC之后年轻代或记忆集不为空\n");
+        failed = 1;
+    }
+    if (stress && (vm.gc_epoch < 3000 || minor < vm.gc_full_count)) {
+        printf("✗ 压力模式没有在每个安全点GC\n");
+        failed = 1;
+    }
+    
+    /* 压力模式每步只追踪一个对象，完整GC的标记分成多次停顿 */
+    unsigned int in_histogram = 0;
+    for (int i = 0; i < GC_PAUSE_BUCKETS; i++) {
+        in_histogram += vm.gc_pauses.histogram[i];
+    }
+    printf("  停顿%u次，最长%.1f微秒\n", vm.gc_pauses.count, vm.gc_pauses.max_us);
+    if (in_histogram != vm.gc_pauses.count || vm.gc_phase != GC_PAUSE) {
+        printf("✗ 停顿统计不一致\n");
+        failed = 1;
+    }
+    if (stress && vm.gc_pauses.count <= vm.gc_epoch) {
+        printf("✗ 增量标记没有分步进行\n");
+        failed = 1;
+    }
+    
+    xr_bc_proto_free(proto);
+    xr_ast_free(X, ast);
+    xr_bc_vm_free(&vm);
+    return failed;
+}
+
+/*
+** 完整GC之后WeakMap只剩keep、a、b三个条目，值都还存活
+*/
+static int test_weak_map(XrayState *X, bool stress) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    vm.gc_stress = stress;
+    
+    AstNode *ast;
+    Proto *proto = xtest_compile_script(X, weak_source, &ast);
+    if (proto == NULL) {
+        xr_bc_vm_free(&vm);
+        return 1;
+    }
+    
+    int failed = xtest_run_proto(&vm, proto, NULL, weak_expected, INTERPRET_OK);
+    
+    xr_bc_gc_collect(&vm);
+    XrMap *cache = NULL;
+    for (int i = 0; i < 256; i++) {
+        if (xr_ismap(vm.globals_array[i]) &&
+            xr_map_is_weak((XrMap*)xr_toobj(vm.globals_array[i]))) {
+            cache = (XrMap*)xr_toobj(vm.globals_array[i]);
+        }
+    }
+    if (cache == NULL) {
+        printf("✗ 全局变量中没有WeakMap\n");
+        failed = 1;
+    } else {
+        printf("WeakMap%s: 完整GC后剩余%u个条目\n",
+               stress ? "（压力模式）" : "", xr_map_size(cache));
+        if (xr_map_size(cache) != 3) {
+            printf("✗ 不可达的键没有被删除\n");
+            failed = 1;
+        }
+        uint32_t cursor = 0;
+        XrValue key, value;
+        while (xr_map_next(cache, &cursor, &key, &value)) {
+            if (!xr_isstring(value) && !((XrObject*)xr_toobj(value))->marked) {
+                printf("✗ 存活键的值被回收\n");
+                failed = 1;
+            }
+        }
+    }
+    
+    xr_bc_proto_free(proto);
+    xr_ast_free(X, ast);
+    xr_bc_vm_free(&vm);
+    return failed;
+}
+
+/*
+** 两个VM并存：执行第一个VM时字符串和对象进入它自己的池和slab，
+** 返回后恢复之前选中的；第二个VM的GC不会回收第一个VM的字符串
+*/
+static int test_two_vms(XrayState *X) {
+    VM first;
+    xr_bc_vm_init(&first);
+    AstNode *ast;
+    Proto *proto = xtest_compile_script(X, garbage_source, &ast);
+    if (proto == NULL) {
+        xr_bc_vm_free(&first);
+        return 1;
+    }
+    
+    VM second;
+    xr_bc_vm_init(&second);
+    size_t second_bytes = second.strings.bytes;
+    
+    int failed = 0;
+    for (int run = 0; run < 2; run++) {
+        failed += xtest_run_proto(&first, proto, NULL, garbage_expected, INTERPRET_OK);
+        if (xr_string_pool_current() != &second.strings ||
+            second.strings.bytes != second_bytes) {
+            printf("✗ 字符串进入了别的VM的池\n");
+            failed = 1;
+        }
+        if (xr_slab_current() != &second.slab || second.slab.bytes_in_use != 0) {
+            printf("✗ 对象进入了别的VM的slab\n");
+            failed = 1;
+        }
+        xr_bc_gc_collect(&second);
+    }
+    printf("两个VM: 第一个VM的池%zu字节，第二个VM的池%zu字节\n",
+           first.strings.bytes, second.strings.bytes);
+    
+    xr_bc_vm_free(&second);
+    xr_bc_proto_free(proto);
+    xr_ast_free(X, ast);
+    xr_bc_vm_free(&first);
+    return failed;
+}
+
+/* 只有常量字符串的脚本：执行完后原型不再被任何闭包引用 */
+static const char *literal_source =
+    "let greeting = \"hello\" + \" \" + \"world\"\n"
+    "let m = {name: \"alpha\"}\n"
+    "print(greeting)\n"
+    "print(m[\"name\"])\n";
+
+static const char *literal_expected = "hello world\nalpha\n";
+
+/* 字符串是否在池里（驻留表或长字符串链表） */
+static bool pool_holds(StringPool *pool, XrString *str) {
+    for (size_t i = 0; i < pool->capacity; i++) {
+        if (pool->entries[i] == str) return true;
+    }
+    for (XrString *s = pool->long_strings; s != NULL; s = (XrString*)s->header.next) {
+        if (s == str) return true;
+    }
+    return false;
+}
+
+/*
+** 原型常量不随VM的GC回收：执行A，再执行B（期间和之后都做完整GC），
+** A没有闭包存活，再执行A时常量字符串仍然有效
+*/
+static int test_proto_constants(XrayState *X) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    
+    /* 在VM初始化之后编译：此时当前池是VM的池 */
+    AstNode *ast_a;
+    AstNode *ast_b;
+    Proto *a = xtest_compile_script(X, literal_source, &ast_a);
+    Proto *b = xtest_compile_script(X, garbage_source, &ast_b);
+    if (a == NULL || b == NULL) {
+        xr_bc_vm_free(&vm);
+        return 1;
+    }
+    
+    int failed = 0;
+    for (int i = 0; i < a->constants.count; i++) {
+        XrValue value = a->constants.values[i];
+        if (xr_isstring(value) && pool_holds(&vm.strings, xr_tostring(value))) {
+            printf("✗ 常量字符串进入了VM的池\n");
+            failed = 1;
+            break;
+        }
+    }
+    
+    failed += xtest_run_proto(&vm, a, NULL, literal_expected, INTERPRET_OK);
+    vm.gc_stress = true;
+    failed += xtest_run_proto(&vm, b, NULL, garbage_expected, INTERPRET_OK);
+    vm.gc_stress = false;
+    xr_bc_gc_collect(&vm);
+    failed += xtest_run_proto(&vm, a, NULL, literal_expected, INTERPRET_OK);
+    if (!failed) {
+        printf("✓ 原型常量在GC之后仍然有效\n");
+    }
+    
+    xr_bc_proto_free(a);
+    xr_bc_proto_free(b);
+    xr_ast_free(X, ast_a);
+    xr_ast_free(X, ast_b);
+    xr_bc_vm_free(&vm);
+    return failed;
+}
+
+/*
+** 记忆集去重：交替记入两个老对象（C函数调用后逐个记入老参数），
+** 每个对象只占一项；记忆集清空后可以重新记入
+*/
+static int test_remember_once(void) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    XrArray *a = xr_array_new();
+    XrArray *b = xr_array_new();
+    a->header.marked = true;
+    b->header.marked = true;
+    
+    int failed = 0;
+    for (int i = 0; i < 1000; i++) {
+        xr_bc_gc_remember(&vm, (XrObject*)a);
+        xr_bc_gc_remember(&vm, (XrObject*)b);
+    }
+    if (vm.remembered_count != 2) {
+        printf("✗ 记忆集有%d项，应为2项\n", vm.remembered_count);
+        failed = 1;
+    }
+    
+    /* 完整GC清空记忆集（a、b不在链表上，不会被回收） */
+    xr_bc_gc_collect(&vm);
+    a->header.marked = true;
+    xr_bc_gc_remember(&vm, (XrObject*)a);
+    xr_bc_gc_remember(&vm, (XrObject*)a);
+    if (vm.remembered_count != 1) {
+        printf("✗ 清空后记忆集有%d项，应为1项\n", vm.remembered_count);
+        failed = 1;
+    }
+    if (!failed) {
+        printf("✓ 记忆集去重\n");
+    }
+    
+    xr_array_free(a);
+    xr_array_free(b);
+    xr_bc_vm_free(&vm);
+    return failed;
+}
+
+/*
+** 切片字符串留住父串：只有切片可达时父串熬过minor GC和完整GC，
+** 切片不可达后父串一起回收；用作Map键时存入的是内联副本
+*/
+static int test_slice_parent(void) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    
+    char text[200];
+    for (size_t i = 0; i < sizeof(text); i++) {
+        text[i] = (char)('a' + i % 26);
+    }
+    XrString *parent = xr_string_make(text, sizeof(text));
+    XrString *slice = xr_string_substring(parent, 10, 190);
+    XrString *small = xr_string_substring(parent, 0, 45);
+    
+    int failed = 0;
+    if (!xr_string_is_slice(slice) || xr_string_is_slice(small) ||
+        memcmp(xr_string_data(slice), text + 10, slice->length) != 0) {
+        printf("✗ 长子串应引用父串，短子串应复制\n");
+        failed = 1;
+    }
+    
+    vm.globals_array[0] = xr_string_value(slice);
+    xr_bc_gc_collect_young(&vm);
+    xr_bc_gc_collect(&vm);
+    if (!pool_holds(&vm.strings, parent) || !pool_holds(&vm.strings, slice)) {
+        printf("✗ 切片可达时父串被回收\n");
+        failed = 1;
+    }
+    
+    XrMap *map = xr_map_new();
+    xr_map_set(map, xr_string_value(slice), xr_int(1));
+    uint32_t cursor = 0;
+    XrValue key, value;
+    bool found = false;
+    xr_map_next(map, &cursor, &key, &value);
+    xr_map_get(map, xr_string_value(slice), &found);
+    if (xr_string_is_slice(xr_tostring(key)) || !found) {
+        printf("✗ Map键应是内联副本，并能用切片查到\n");
+        failed = 1;
+    }
+    xr_map_free(map);
+    
+    vm.globals_array[0] = xr_null();
+    xr_bc_gc_collect(&vm);
+    if (pool_holds(&vm.strings, parent) || pool_holds(&vm.strings, slice)) {
+        printf("✗ 切片不可达后父串仍未回收\n");
+        failed = 1;
+    }
+    if (!failed) {
+        printf("✓ 切片字符串留住父串\n");
+    }
+    
+    xr_bc_vm_free(&vm);
+    return failed;
+}
+
+int main(void) {
+    printf("=== GC Test ===\n\n");
+    
+    XrayState *X = xr_state_new();
+    
+    int failed = 0;
+    /* 类、keep、counter（及其upvalue） */
+    failed += run_script(X, garbage_source, garbage_expected, false, 8, 1);
+    failed += run_script(X, garbage_source, garbage_expected, true, 8, 1);
+    
+    /* holder、names、cache和其中的10+1个数组 */
+    failed += run_script(X, barrier_source, barrier_expected, false, 16, 0);
+    failed += run_script(X, barrier_source, barrier_expected, true, 16, 0);
+    
+    failed += test_weak_map(X, false);
+    failed += test_weak_map(X, true);
+    
+    failed += test_two_vms(X);
+    failed += test_remember_once();
+    failed += test_slice_parent();
+    failed += test_proto_constants(X);
+    
+    xr_state_free(X);
+    
+    if (failed == 0) {
+        printf("\n✓ GC测试通过\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
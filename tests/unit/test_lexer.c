@@ -60,11 +60,11 @@ static void test_keywords(void) {
     printf("\n测试关键字:\n");
     
     Scanner scanner;
-    const char *source = "let const if else while for return null true false class function new this";
+    const char *source = "let const if else while for in return null true false class function new this";
     xr_scanner_init(&scanner, source);
     
     TokenType expected[] = {
-        TK_LET, TK_CONST, TK_IF, TK_ELSE, TK_WHILE, TK_FOR,
+        TK_LET, TK_CONST, TK_IF, TK_ELSE, TK_WHILE, TK_FOR, TK_IN,
         TK_RETURN, TK_NULL, TK_TRUE, TK_FALSE, TK_CLASS,
         TK_FUNCTION, TK_NEW, TK_THIS, TK_EOF
     };
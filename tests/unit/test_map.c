@@ -8,12 +8,17 @@
  *   3. 哈希冲突处理
  *   4. 动态扩容
  *   5. 墓碑机制
- *   6. 小Map线性扫描优化
+ *   6. 小Map分组探测（单个分组）
+ *   7. 预分配容量与字符串键快速路径
+ *   8. 分组探测下的墓碑回收
+ *   9. 按插入顺序迭代
+ *  10. 整数键数组部分
  */
 
 #include "xmap.h"
 #include "xvalue.h"
 #include "xstring.h"
+#include "xarray.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -188,9 +193,9 @@ void test_resize() {
     
     uint32_t old_capacity = map->capacity;
     
-    /* 插入足够多的元素触发扩容 */
+    /* 插入足够多的元素触发扩容（稀疏键，走哈希部分） */
     for (int i = 0; i < 100; i++) {
-        xr_map_set(map, xr_int(i), xr_int(i * 2));
+        xr_map_set(map, xr_int(i * 7919 + 1000), xr_int(i * 2));
     }
     
     ASSERT_EQ(xr_map_size(map), 100, "应插入100个元素");
@@ -199,7 +204,7 @@ void test_resize() {
     /* 验证所有键值对仍然可访问 */
     for (int i = 0; i < 100; i++) {
         bool found;
-        XrValue result = xr_map_get(map, xr_int(i), &found);
+        XrValue result = xr_map_get(map, xr_int(i * 7919 + 1000), &found);
         ASSERT(found, "扩容后键应仍然存在");
         ASSERT_EQ(xr_toint(result), i * 2, "扩容后值应保持不变");
     }
@@ -211,15 +216,15 @@ void test_resize() {
 void test_collision() {
     XrMap *map = xr_map_new();
     
-    /* 插入多个可能冲突的键 */
+    /* 插入多个可能冲突的键（稀疏键，走哈希部分） */
     for (int i = 0; i < 50; i++) {
-        xr_map_set(map, xr_int(i), xr_int(i * 3));
+        xr_map_set(map, xr_int(i * 64 + 1), xr_int(i * 3));
     }
     
     /* 验证所有键都能正确获取 */
     for (int i = 0; i < 50; i++) {
         bool found;
-        XrValue result = xr_map_get(map, xr_int(i), &found);
+        XrValue result = xr_map_get(map, xr_int(i * 64 + 1), &found);
         ASSERT(found, "冲突情况下键应能找到");
         ASSERT_EQ(xr_toint(result), i * 3, "冲突情况下值应正确");
     }
@@ -227,25 +232,35 @@ void test_collision() {
     xr_map_free(map);
 }
 
-/* 测试9: 小Map线性扫描优化 */
-void test_small_map() {
+/* 测试9: 小Map分组探测：全部键落在一个分组里，一次组比较命中或确认不存在 */
+void test_small_map_group() {
     XrMap *map = xr_map_new();
     
-    /* 插入少量元素（≤8） */
-    for (int i = 0; i < 8; i++) {
-        xr_map_set(map, xr_int(i), xr_int(i * 10));
+    /* 稀疏整数键不进数组部分；填满一个分组的负载上限 */
+    int count = (int)(XR_MAP_MIN_CAPACITY * XR_MAP_LOAD_FACTOR);
+    for (int i = 0; i < count; i++) {
+        xr_map_set(map, xr_int(i * 1000 + 7), xr_int(i * 10));
     }
     
-    ASSERT_EQ(xr_map_size(map), 8, "小Map应插入8个元素");
+    ASSERT_EQ(xr_map_size(map), count, "小Map元素数量应正确");
+    ASSERT_EQ(map->capacity, XR_MAP_MIN_CAPACITY, "小Map应只有一个分组");
+    ASSERT_EQ(map->array_count, 0, "稀疏键不应进入数组部分");
     
-    /* 验证查询正确 */
-    for (int i = 0; i < 8; i++) {
+    /* 命中：组内匹配控制字节 */
+    for (int i = 0; i < count; i++) {
         bool found;
-        XrValue result = xr_map_get(map, xr_int(i), &found);
+        XrValue result = xr_map_get(map, xr_int(i * 1000 + 7), &found);
         ASSERT(found, "小Map应能找到键");
         ASSERT_EQ(xr_toint(result), i * 10, "小Map值应正确");
     }
     
+    /* 未命中：组内有空槽，探测到此结束 */
+    for (int i = 0; i < count; i++) {
+        bool found;
+        xr_map_get(map, xr_int(i * 1000 + 8), &found);
+        ASSERT(!found, "小Map不应找到不存在的键");
+    }
+    
     xr_map_free(map);
 }
 
@@ -290,6 +305,356 @@ void test_multiple_key_types() {
     xr_map_free(map);
 }
 
+/* 测试11: 预分配容量（Map字面量） */
+void test_with_capacity() {
+    XrMap *map = xr_map_with_capacity(100);
+    uint32_t capacity = map->capacity;
+    ASSERT(capacity * XR_MAP_LOAD_FACTOR >= 100, "预分配容量应能容纳100个元素");
+    
+    for (int i = 0; i < 100; i++) {
+        xr_map_set(map, xr_int(i * 3 + 1000), xr_int(i));
+    }
+    
+    ASSERT_EQ(map->capacity, capacity, "预分配后插入不应扩容");
+    ASSERT_EQ(xr_map_size(map), 100, "应插入100个元素");
+    xr_map_free(map);
+}
+
+/* 测试12: 字符串键快速路径（GETFIELD/SETFIELD） */
+void test_string_key_fast_path() {
+    XrMap *map = xr_map_new();
+    char buf[32];
+    
+    /* 超过小Map阈值，走预计算哈希的探测路径 */
+    for (int i = 0; i < 20; i++) {
+        int len = snprintf(buf, sizeof(buf), "key%d", i);
+        xr_map_set_str(map, xr_string_new(buf, len), xr_int(i));
+    }
+    ASSERT_EQ(xr_map_size(map), 20, "应插入20个字符串键");
+    
+    for (int i = 0; i < 20; i++) {
+        int len = snprintf(buf, sizeof(buf), "key%d", i);
+        bool found;
+        
+        /* 快速路径与通用路径结果一致 */
+        XrValue result = xr_map_get_str(map, xr_string_new(buf, len), &found);
+        ASSERT(found, "字符串键应能找到");
+        ASSERT_EQ(xr_toint(result), i, "字符串键值应正确");
+        
+        result = xr_map_get(map, xr_string_value(xr_string_new(buf, len)), &found);
+        ASSERT(found && xr_toint(result) == i, "通用路径应找到同一条目");
+    }
+    
+    bool found;
+    xr_map_get_str(map, xr_string_new("missing", 7), &found);
+    ASSERT(!found, "不存在的字符串键");
+    
+    xr_map_free(map);
+}
+
+/* 测试13: 反复插入删除不应无限增长（墓碑计入负载并被回收） */
+void test_tombstone_churn() {
+    XrMap *map = xr_map_new();
+    
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 10; i++) {
+            xr_map_set(map, xr_int(1000 + round * 10 + i), xr_int(i));
+        }
+        for (int i = 0; i < 10; i++) {
+            ASSERT(xr_map_delete(map, xr_int(1000 + round * 10 + i)), "删除应成功");
+        }
+    }
+    
+    ASSERT_EQ(xr_map_size(map), 0, "全部删除后应为空");
+    ASSERT(map->capacity <= 64, "墓碑回收后容量不应持续增长");
+    
+    /* 墓碑之后的键仍可插入和查找 */
+    xr_map_set(map, xr_int(7), xr_int(70));
+    bool found;
+    XrValue result = xr_map_get(map, xr_int(7), &found);
+    ASSERT(found && xr_toint(result) == 70, "墓碑回收后查找正确");
+    
+    xr_map_free(map);
+}
+
+/* 测试14: 紧凑布局按插入顺序迭代 */
+void test_insertion_order() {
+    XrMap *map = xr_map_new();
+    int order[] = {42, 7, 19, 3, 100, 56, 8, 23, 91, 64, 5, 77, 30, 12, 88, 1, 50};
+    int n = sizeof(order) / sizeof(order[0]);
+    
+    for (int i = 0; i < n; i++) {
+        xr_map_set(map, xr_int(order[i]), xr_int(i));
+    }
+    
+    XrArray *keys = xr_map_keys(map);
+    ASSERT_EQ(keys->count, n, "keys数量应等于元素数量");
+    for (int i = 0; i < n; i++) {
+        ASSERT_EQ(xr_toint(keys->elements[i]), order[i], "keys应按插入顺序返回");
+    }
+    xr_array_free(keys);
+    
+    /* 删除后重新插入：移到末尾；更新已有键：位置不变 */
+    xr_map_delete(map, xr_int(7));
+    xr_map_set(map, xr_int(7), xr_int(-1));
+    xr_map_set(map, xr_int(42), xr_int(-2));
+    
+    XrArray *values = xr_map_values(map);
+    ASSERT_EQ(values->count, n, "values数量应等于元素数量");
+    ASSERT_EQ(xr_toint(values->elements[0]), -2, "更新不改变位置");
+    ASSERT_EQ(xr_toint(values->elements[1]), 2, "删除的键不再占据原位置");
+    ASSERT_EQ(xr_toint(values->elements[n - 1]), -1, "重新插入的键在末尾");
+    xr_array_free(values);
+    
+    xr_map_free(map);
+}
+
+/* 测试15: 稠密整数键进入数组部分，稀疏后迁回哈希部分 */
+void test_array_part() {
+    XrMap *map = xr_map_new();
+    
+    /* 倒序插入：先进入哈希部分，键0到达时整体迁入数组部分 */
+    for (int i = 31; i >= 0; i--) {
+        xr_map_set(map, xr_int(i), xr_int(i * 10));
+    }
+    ASSERT_EQ(map->array_size, 32, "连续整数键应全部进入数组部分");
+    ASSERT_EQ(map->count - map->array_count, 0, "哈希部分应为空");
+    ASSERT_EQ(xr_map_size(map), 32, "应有32个元素");
+    
+    /* 混合字符串键 */
+    xr_map_set(map, xr_string_value(xr_string_new("name", 4)), xr_int(-1));
+    ASSERT_EQ(xr_map_size(map), 33, "应有33个元素");
+    
+    /* 空洞：删除中间键 */
+    ASSERT(xr_map_delete(map, xr_int(5)), "删除键5");
+    ASSERT(!xr_map_has(map, xr_int(5)), "键5不应存在");
+    ASSERT(!xr_map_delete(map, xr_int(5)), "重复删除应失败");
+    xr_map_set(map, xr_int(5), xr_int(50));
+    bool found;
+    XrValue result = xr_map_get(map, xr_int(5), &found);
+    ASSERT(found && xr_toint(result) == 50, "空洞可重新填入");
+    
+    /* 迭代：数组部分升序在前 */
+    XrArray *keys = xr_map_keys(map);
+    ASSERT_EQ(xr_toint(keys->elements[0]), 0, "数组部分在前");
+    ASSERT_EQ(xr_toint(keys->elements[31]), 31, "数组部分升序");
+    ASSERT(xr_isstring(keys->elements[32]), "哈希部分在后");
+    xr_array_free(keys);
+    
+    /* 删除超过一半：迁回哈希部分，数据不丢失 */
+    for (int i = 0; i < 32; i += 3) {
+        xr_map_delete(map, xr_int(i));
+    }
+    for (int i = 1; i < 32; i += 3) {
+        xr_map_delete(map, xr_int(i));
+    }
+    ASSERT_EQ(map->array_size, 0, "稀疏后数组部分应迁回哈希部分");
+    for (int i = 2; i < 32; i += 3) {
+        result = xr_map_get(map, xr_int(i), &found);
+        ASSERT(found && xr_toint(result) == i * 10, "迁移后值应保持不变");
+    }
+    ASSERT_EQ(xr_map_size(map), 11, "应剩余10个整数键和1个字符串键");
+    
+    xr_map_free(map);
+}
+
+/* 测试16: 渐进式扩容期间所有键都可见，迁移完成后释放旧表 */
+void test_incremental_rehash() {
+    XrMap *map = xr_map_new();
+    bool found;
+    XrValue result;
+    
+    /* 插入直到容量从32扩到64：旧表中的条目多于一步的迁移量 */
+    int n = 0;
+    while (map->capacity < 64) {
+        xr_map_set(map, xr_int(1000 + n * 7), xr_int(n));
+        n++;
+    }
+    ASSERT(map->old_index != NULL, "扩容后应处于迁移状态");
+    ASSERT(map->migrate_end > XR_MAP_MIGRATE_STEP, "迁移应分多步进行");
+    
+    /* 迁移期间删除尚未迁移的键（最后迁移的是旧表中靠后的条目） */
+    int victim = (int)map->migrate_end - 1;
+    ASSERT(xr_map_delete(map, xr_int(1000 + victim * 7)), "迁移期间删除应成功");
+    ASSERT(map->old_index != NULL, "删除时迁移尚未完成");
+    
+    /* 所有键在迁移期间和迁移之后都可查找 */
+    for (int i = 0; i < n; i++) {
+        result = xr_map_get(map, xr_int(1000 + i * 7), &found);
+        if (i == victim) {
+            ASSERT(!found, "删除的键不应再找到");
+        } else {
+            ASSERT(found && xr_toint(result) == i, "迁移期间值应正确");
+        }
+    }
+    ASSERT(map->old_index == NULL, "足够多次操作后迁移应完成");
+    ASSERT_EQ(xr_map_size(map), n - 1, "迁移不应改变元素数量");
+    
+    /* 连续扩容：大量插入后键值完整 */
+    for (int i = n; i < 5000; i++) {
+        xr_map_set(map, xr_int(1000 + i * 7), xr_int(i));
+    }
+    for (int i = n; i < 5000; i++) {
+        result = xr_map_get(map, xr_int(1000 + i * 7), &found);
+        ASSERT(found && xr_toint(result) == i, "连续扩容后值应正确");
+    }
+    
+    xr_map_free(map);
+}
+
+/* 测试17: 游标迭代：数组部分在前，哈希部分按插入顺序，跳过已删除键 */
+void test_cursor_iteration() {
+    XrMap *map = xr_map_new();
+    bool found;
+    
+    /* 空Map */
+    uint32_t cursor = 0;
+    ASSERT(!xr_map_next(map, &cursor, NULL, NULL), "空Map没有元素");
+    
+    for (int i = 0; i < 4; i++) {
+        xr_map_set(map, xr_int(i), xr_int(i * 10));
+    }
+    xr_map_set(map, xr_int(500), xr_int(5));
+    xr_map_set(map, xr_int(300), xr_int(3));
+    xr_map_set(map, xr_int(400), xr_int(4));
+    xr_map_delete(map, xr_int(300));
+    xr_map_delete(map, xr_int(1));
+    
+    int64_t expect_keys[] = {0, 2, 3, 500, 400};
+    int64_t expect_values[] = {0, 20, 30, 5, 4};
+    
+    XrValue key, value;
+    int n = 0;
+    cursor = 0;
+    while (xr_map_next(map, &cursor, &key, &value)) {
+        ASSERT(n < 5, "迭代次数不应超过元素数量");
+        ASSERT_EQ(xr_toint(key), expect_keys[n], "键顺序正确");
+        ASSERT_EQ(xr_toint(value), expect_values[n], "值正确");
+        n++;
+    }
+    ASSERT_EQ(n, 5, "应遍历全部元素");
+    ASSERT(!xr_map_next(map, &cursor, &key, &value), "结束后继续调用仍返回false");
+    
+    /* 提前结束后可从保存的游标继续 */
+    cursor = 0;
+    xr_map_next(map, &cursor, &key, NULL);
+    xr_map_next(map, &cursor, &key, NULL);
+    ASSERT_EQ(xr_toint(key), 2, "第二个元素");
+    xr_map_next(map, &cursor, NULL, &value);
+    ASSERT_EQ(xr_toint(value), 30, "从游标继续");
+    
+    xr_map_get(map, xr_int(500), &found);
+    ASSERT(found, "迭代不修改Map");
+    
+    xr_map_free(map);
+}
+
+/* 测试18: WeakMap清除：批量删除失效键、不留墓碑、保持顺序 */
+static bool key_below_5000(XrValue key, void *ud) {
+    int *calls = (int *)ud;
+    (*calls)++;
+    return !xr_isint(key) || xr_toint(key) < 5000;
+}
+
+void test_weak_sweep() {
+    XrMap *map = xr_map_new_weak();
+    ASSERT(xr_map_is_weak(map), "应为WeakMap");
+    XrMap *plain = xr_map_new();
+    ASSERT(!xr_map_is_weak(plain), "普通Map不是WeakMap");
+    xr_map_free(plain);
+    
+    /* 数组部分（不参与判定）+ 交替存活/失效的哈希部分键 */
+    for (int i = 0; i < 4; i++) {
+        xr_map_set(map, xr_int(i), xr_int(i));
+    }
+    for (int i = 0; i < 200; i++) {
+        int key = (i % 2 == 0) ? 1000 + i : 9000 + i;
+        xr_map_set(map, xr_int(key), xr_int(i));
+    }
+    uint32_t cap_before = map->capacity;
+    
+    int calls = 0;
+    ASSERT_EQ(xr_map_sweep_weak(map, key_below_5000, &calls), 100, "应删除一半哈希部分键");
+    ASSERT_EQ(calls, 200, "只对哈希部分的键调用回调");
+    ASSERT_EQ(xr_map_size(map), 104, "剩余数组部分4个和存活键100个");
+    ASSERT_EQ(map->used, 100, "压缩后没有已删除条目");
+    ASSERT(map->capacity <= cap_before, "清除后容量不应增长");
+    
+    /* 存活键仍可查找，失效键已删除，顺序保持 */
+    bool found;
+    for (int i = 0; i < 200; i += 2) {
+        XrValue result = xr_map_get(map, xr_int(1000 + i), &found);
+        ASSERT(found && xr_toint(result) == i, "存活键应保留");
+        ASSERT(!xr_map_has(map, xr_int(9001 + i)), "失效键应删除");
+    }
+    ASSERT_EQ(xr_toint(map->entries[1].key), 1002, "压缩保持插入顺序");
+    
+    /* 没有失效键时不重建 */
+    calls = 0;
+    ASSERT_EQ(xr_map_sweep_weak(map, key_below_5000, &calls), 0, "没有需要删除的键");
+    
+    xr_map_free(map);
+}
+
+/* 测试19: 对象键按身份比较，可以查找和更新 */
+void test_object_keys() {
+    XrMap *map = xr_map_new_weak();
+    XrArray *a = xr_array_new();
+    XrArray *b = xr_array_new();
+    
+    xr_map_set(map, xr_value_from_array(a), xr_int(1));
+    xr_map_set(map, xr_value_from_array(b), xr_int(2));
+    xr_map_set(map, xr_value_from_array(a), xr_int(10));
+    ASSERT_EQ(xr_map_size(map), 2, "更新已有对象键不新增条目");
+    
+    bool found;
+    XrValue result = xr_map_get(map, xr_value_from_array(a), &found);
+    ASSERT(found && xr_toint(result) == 10, "按身份找到对象键");
+    result = xr_map_get(map, xr_value_from_array(b), &found);
+    ASSERT(found && xr_toint(result) == 2, "不同对象是不同的键");
+    
+    ASSERT(xr_map_delete(map, xr_value_from_array(b)), "删除对象键");
+    ASSERT(!xr_map_has(map, xr_value_from_array(b)), "删除后找不到");
+    
+    xr_map_free(map);
+    xr_array_free(a);
+    xr_array_free(b);
+}
+
+/* 测试20: 条目数组已满时更新已有键不扩容，插入新键才扩容 */
+void test_update_when_full() {
+    XrMap *map = xr_map_new();
+    
+    int n = 0;
+    while (map->capacity == 0 || map->used < map->usable) {
+        xr_map_set(map, xr_int(1000 + n), xr_int(n));
+        n++;
+    }
+    uint32_t capacity = map->capacity;
+    uint32_t used = map->used;
+    
+    for (int i = 0; i < n; i++) {
+        xr_map_set(map, xr_int(1000 + i), xr_int(-i));
+    }
+    ASSERT_EQ(map->capacity, capacity, "更新已有键不应扩容");
+    ASSERT(map->old_index == NULL, "更新已有键不应开始迁移");
+    ASSERT_EQ(map->used, used, "更新已有键不占新条目");
+    
+    /* 插入新键：扩容后在新表中的位置正确 */
+    xr_map_set(map, xr_int(5000), xr_int(5000));
+    ASSERT(map->capacity > capacity, "插入新键应扩容");
+    bool found;
+    XrValue result = xr_map_get(map, xr_int(5000), &found);
+    ASSERT(found && xr_toint(result) == 5000, "扩容后插入的键可以找到");
+    for (int i = 0; i < n; i++) {
+        result = xr_map_get(map, xr_int(1000 + i), &found);
+        ASSERT(found && xr_toint(result) == -i, "更新后的值应保留");
+    }
+    ASSERT_EQ(xr_map_size(map), n + 1, "元素数量");
+    
+    xr_map_free(map);
+}
+
 /* ========== 主测试函数 ========== */
 
 int main() {
@@ -303,8 +668,18 @@ int main() {
     TEST(clear);
     TEST(resize);
     TEST(collision);
-    TEST(small_map);
+    TEST(small_map_group);
     TEST(multiple_key_types);
+    TEST(with_capacity);
+    TEST(string_key_fast_path);
+    TEST(tombstone_churn);
+    TEST(insertion_order);
+    TEST(array_part);
+    TEST(incremental_rehash);
+    TEST(cursor_iteration);
+    TEST(weak_sweep);
+    TEST(object_keys);
+    TEST(update_when_full);
     
     printf("\n========== 所有测试通过! ==========\n");
     return 0;
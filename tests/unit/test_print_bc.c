@@ -3,14 +3,8 @@
 ** 测试字节码VM的print功能
 */
 
-#include "xcompiler.h"
-#include "xcompiler_context.h"
-#include "xvm.h"
+#include "xtest_vm.h"
 #include "xdebug.h"
-#include "xparse.h"
-#include "xstate.h"
-#include "xast.h"
-#include <stdio.h>
 
 int main(void) {
     printf("=== Print Function Test ===\n\n");
@@ -32,25 +26,10 @@ int main(void) {
     
     printf("源代码:\n%s\n", source);
     
-    /* 解析 */
-    AstNode *ast = xr_parse(X, source);
-    if (ast == NULL) {
-        printf("✗ 解析失败\n");
-        return 1;
-    }
-    
-    /* 编译 */
-    /* 创建编译器上下文 */
-
-    CompilerContext *ctx = xr_compiler_context_new();
-
-    Proto *proto = xr_compile(ctx, ast);
-
-    /* 释放编译器上下文 */
-
-    xr_compiler_context_free(ctx);
+    /* 解析和编译 */
+    AstNode *ast;
+    Proto *proto = xtest_compile_script(X, source, &ast);
     if (proto == NULL) {
-        printf("✗ 编译失败\n");
         return 1;
     }
     
@@ -58,14 +37,20 @@ int main(void) {
     printf("\n字节码:\n");
     xr_disassemble_proto(proto, "<test>");
     
-    /* 执行 */
+    /* 执行（输出写入截获缓冲） */
+    XTestCapture cap;
     printf("\n执行结果:\n");
-    InterpretResult result = xr_bc_interpret_proto(&vm, proto);
+    int failed = xtest_run_proto(&vm, proto, &cap, "42\n100\n3.14\n50\n", INTERPRET_OK);
+    printf("%s", cap.data);
+    
+    /* 四次print缓冲后一次写出 */
+    if (cap.writes != 1) {
+        printf("✗ print输出没有合并: writes=%d\n", cap.writes);
+        failed = 1;
+    }
     
-    if (result == INTERPRET_OK) {
+    if (!failed) {
         printf("\n✓ 执行成功\n");
-    } else {
-        printf("\n✗ 执行失败\n");
     }
     
     /* 清理 */
@@ -74,6 +59,6 @@ int main(void) {
     xr_bc_vm_free(&vm);
     xr_state_free(X);
     
-    return (result == INTERPRET_OK) ? 0 : 1;
+    return failed;
 }
 
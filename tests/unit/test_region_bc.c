@@ -0,0 +1,135 @@
+/*
+** test_region_bc.c
+** 测试字节码VM的区域模式
+*/
+
+#include "xtest_vm.h"
+#include "xvm_gc.h"
+#include "xarray.h"
+
+/* 每次执行都产生大量短命的数组、Map、字符串和闭包，只有last留在全局变量里 */
+static const char *request_source =
+    "function makeCounter() {\n"
+    "    let count = 0\n"
+    "    function increment() {\n"
+    "        count = count + 1\n"
+    "        return count\n"
+    "    }\n"
+    "    return increment\n"
+    "}\n"
+    "let counter = makeCounter()\n"
+    "let total = 0\n"
+    "let last = [0, \"\"]\n"
+    "for (let i = 0; i < 3000; i = i + 1) {\n"
+    "    let tmp = [i, i + 1]\n"
+    "    let m = {k: i}\n"
+    "    let s = \"item\" + i\n"
+    "    total = total + tmp[1] + m.k - i\n"
+    "    last = [counter(), s]\n"
+    "}\n"
+    "print(total)\n"
+    "print(last[1])\n";
+
+static const char *request_expected = "4501500\nitem2999\n";
+
+/* 链表中的对象数量 */
+static int count_objects(XrObject *list) {
+    int count = 0;
+    for (XrObject *object = list; object != NULL; object = object->next) {
+        count++;
+    }
+    return count;
+}
+
+/* 在全局变量里找数组（last） */
+static XrArray *find_array(VM *vm) {
+    for (int i = 0; i < 256; i++) {
+        if (xr_isarray(vm->globals_array[i])) {
+            return (XrArray*)xr_toobj(vm->globals_array[i]);
+        }
+    }
+    return NULL;
+}
+
+/*
+** 区域模式下反复执行：执行期间不做GC，重置后只剩导出的值
+*/
+static int test_requests(XrayState *X) {
+    VM vm;
+    xr_bc_vm_init(&vm);
+    xr_bc_vm_set_region_mode(&vm, true);
+    
+    AstNode *ast;
+    Proto *proto = xtest_compile_script(X, request_source, &ast);
+    if (proto == NULL) {
+        xr_bc_vm_free(&vm);
+        return 1;
+    }
+    
+    int failed = 0;
+    for (int run = 0; run < 3; run++) {
+        failed += xtest_run_proto(&vm, proto, NULL, request_expected, INTERPRET_OK);
+        if (vm.gc_epoch != 0 || vm.gc_pauses.count != 0) {
+            printf("✗ 区域执行期间做了GC\n");
+            failed++;
+        }
+        
+        /* 重置之前显式导出，之后的副本与区域无关 */
+        XrArray *last = find_array(&vm);
+        if (last == NULL) {
+            printf("✗ 全局变量中没有数组\n");
+            return failed + 1;
+        }
+        XrValue exported = xr_bc_region_export(&vm, xr_value_from_array(last));
+        XrArray *copy = (XrArray*)xr_toobj(exported);
+        if (copy == last || copy->count != 2 ||
+            strcmp(xr_tostring(copy->elements[1])->chars, "item2999") != 0) {
+            printf("✗ 导出的数组不对\n");
+            failed++;
+        }
+        
+        xr_bc_region_reset(&vm);
+        
+        /* 全局的last自动导出，与显式导出的是同一个副本；闭包counter导不出来 */
+        XrArray *kept = find_array(&vm);
+        printf("第%d次: 年轻对象%d个，老年代%d个，upvalue %d个\n", run + 1,
+               count_objects(vm.young[0]), count_objects(vm.objects),
+               count_objects(vm.upvalues));
+        if (kept != copy || xr_toint(kept->elements[0]) != 3000) {
+            printf("✗ 全局变量没有导出\n");
+            failed++;
+        }
+        if (count_objects(vm.young[0]) != 1 || vm.upvalues != NULL ||
+            vm.methods != NULL || vm.frame_count != 0 || vm.region.active) {
+            printf("✗ 重置后留下了区域对象\n");
+            failed++;
+        }
+    }
+    
+    /* 关闭区域模式后照常执行和回收 */
+    xr_bc_vm_set_region_mode(&vm, false);
+    vm.gc_stress = true;
+    failed += xtest_run_proto(&vm, proto, NULL, request_expected, INTERPRET_OK);
+    if (vm.gc_epoch == 0) {
+        printf("✗ 关闭区域模式后没有GC\n");
+        failed++;
+    }
+    
+    xr_bc_proto_free(proto);
+    xr_ast_free(X, ast);
+    xr_bc_vm_free(&vm);
+    return failed;
+}
+
+int main(void) {
+    printf("=== Region Test ===\n\n");
+    
+    XrayState *X = xr_state_new();
+    int failed = test_requests(X);
+    xr_state_free(X);
+    
+    if (failed == 0) {
+        printf("\n✓ 区域模式测试通过\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/* test_slab.c - slab分配器单元测试
+ *
+ * 测试内容：
+ *   1. 同尺寸级的块复用（空闲链表）
+ *   2. 不同尺寸级互不干扰，块按级差对齐
+ *   3. 大块和没有当前slab时走xmem
+ *   4. 释放不属于slab的指针交还xmem
+ *   5. 跨页分配与整体归还
+ */
+
+#include "xslab.h"
+#include "xmem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TEST(name) \
+    printf("测试: %s...", #name); \
+    test_##name(); \
+    printf(" ✓\n");
+
+#define ASSERT(cond, msg) \
+    if (!(cond)) { \
+        printf("\n✗ 断言失败: %s\n", msg); \
+        printf("  文件: %s:%d\n", __FILE__, __LINE__); \
+        exit(1); \
+    }
+
+/* ========== 测试用例 ========== */
+
+/* 测试1: 释放的块被同尺寸级的下一次分配复用 */
+void test_reuse() {
+    XrSlab slab;
+    xr_slab_init(&slab);
+    xr_slab_use(&slab);
+    
+    void *a = xr_slab_alloc(24);
+    void *b = xr_slab_alloc(24);
+    ASSERT(a != b, "两次分配得到同一块");
+    ASSERT(xr_slab_owns(&slab, a) && xr_slab_owns(&slab, b), "块不属于slab");
+    ASSERT(slab.bytes_in_use == 64, "24字节应占32字节的块");
+    
+    xr_slab_free(a);
+    ASSERT(slab.bytes_in_use == 32, "释放后字节数未减少");
+    void *c = xr_slab_alloc(17);  /* 同属32字节级 */
+    ASSERT(c == a, "空闲块没有被复用");
+    
+    xr_slab_use(NULL);
+    xr_slab_free_all(&slab);
+}
+
+/* 测试2: 不同尺寸级分在不同页，块按级差对齐 */
+void test_size_classes() {
+    XrSlab slab;
+    xr_slab_init(&slab);
+    xr_slab_use(&slab);
+    
+    char *small = (char*)xr_slab_alloc(8);
+    char *large = (char*)xr_slab_alloc(XR_SLAB_MAX_SIZE);
+    uintptr_t page_mask = ~(uintptr_t)(XR_SLAB_PAGE_SIZE - 1);
+    ASSERT(((uintptr_t)small & page_mask) != ((uintptr_t)large & page_mask),
+           "不同尺寸级落在同一页");
+    ASSERT((uintptr_t)small % XR_SLAB_GRANULE == 0, "块没有按级差对齐");
+    
+    /* 写满整块不影响相邻块 */
+    char *next = (char*)xr_slab_alloc(XR_SLAB_MAX_SIZE);
+    memset(large, 0xAB, XR_SLAB_MAX_SIZE);
+    memset(next, 0xCD, XR_SLAB_MAX_SIZE);
+    ASSERT((unsigned char)large[XR_SLAB_MAX_SIZE - 1] == 0xAB, "相邻块重叠");
+    
+    xr_slab_use(NULL);
+    xr_slab_free_all(&slab);
+}
+
+/* 测试3: 大块和没有当前slab时走xmem */
+void test_fallback() {
+    XrSlab slab;
+    xr_slab_init(&slab);
+    
+    void *plain = xr_slab_alloc(32);  /* 没有当前slab */
+    xr_slab_use(&slab);
+    void *big = xr_slab_alloc(XR_SLAB_MAX_SIZE + 1);
+    ASSERT(!xr_slab_owns(&slab, plain), "xmem分配的块被当作slab块");
+    ASSERT(!xr_slab_owns(&slab, big), "大块不应从slab分配");
+    ASSERT(slab.bytes_in_use == 0, "大块计入了slab");
+    
+    /* 4. 有当前slab时释放它们，交还xmem */
+    xr_slab_free(plain);
+    xr_slab_free(big);
+    ASSERT(slab.classes[1].free_list == NULL, "外来指针进入了空闲链表");
+    
+    xr_slab_use(NULL);
+    xr_slab_free_all(&slab);
+}
+
+/* 测试5: 跨多页、多个大块分配后整体归还 */
+void test_many_pages() {
+    XrSlab slab;
+    xr_slab_init(&slab);
+    xr_slab_use(&slab);
+    
+    int count = XR_SLAB_PAGE_SIZE / 64 * XR_SLAB_CHUNK_PAGES * 3;
+    void **blocks = (void**)malloc(sizeof(void*) * count);
+    for (int i = 0; i < count; i++) {
+        blocks[i] = xr_slab_alloc(64);
+        memset(blocks[i], i & 0xFF, 64);
+    }
+    ASSERT(slab.chunk_count >= 3, "应该申请了多个大块");
+    ASSERT(slab.page_count >= (size_t)(XR_SLAB_CHUNK_PAGES * 3), "页数不足");
+    for (int i = 0; i < count; i++) {
+        ASSERT(xr_slab_owns(&slab, blocks[i]), "块不属于slab");
+        ASSERT(((unsigned char*)blocks[i])[63] == (i & 0xFF), "块内容被覆盖");
+    }
+    
+    /* 不逐块释放，直接整体归还 */
+    xr_slab_use(NULL);
+    xr_slab_free_all(&slab);
+    ASSERT(slab.chunk_count == 0 && slab.page_count == 0, "整体归还后状态未复位");
+    free(blocks);
+}
+
+/* 测试6: 当前slab是另一个时，块仍回到分配它的slab */
+void test_owner_lookup() {
+    XrSlab first, second;
+    xr_slab_init(&first);
+    xr_slab_init(&second);
+    
+    xr_slab_use(&first);
+    void *a = xr_slab_alloc(48);
+    xr_slab_use(&second);
+    void *b = xr_slab_alloc(48);
+    
+    /* 当前是second，释放first的块 */
+    xr_slab_free(a);
+    ASSERT(first.classes[2].free_list == (XrSlabBlock*)a, "块没有回到所属slab");
+    ASSERT(second.classes[2].free_list == NULL, "块进入了当前slab");
+    ASSERT(first.bytes_in_use == 0 && second.bytes_in_use == 48, "字节统计错误");
+    
+    /* 没有当前slab时同样能找到 */
+    xr_slab_use(NULL);
+    xr_slab_free(b);
+    ASSERT(second.classes[2].free_list == (XrSlabBlock*)b, "没有当前slab时块丢失");
+    
+    /* 整体归还后不再参与查找，外来指针交还xmem */
+    xr_slab_free_all(&first);
+    xr_slab_free_all(&second);
+    void *plain = xr_slab_alloc(48);
+    xr_slab_free(plain);
+}
+
+int main() {
+    printf("========== slab分配器单元测试 ==========\n\n");
+    
+    TEST(reuse);
+    TEST(size_classes);
+    TEST(fallback);
+    TEST(many_pages);
+    TEST(owner_lookup);
+    
+    printf("\n========== 所有测试通过! ==========\n");
+    return 0;
+}
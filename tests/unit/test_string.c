@@ -5,10 +5,13 @@
 ** Day 1: 字符串对象和驻留池测试（15个）
 */
 
+#include "xarray.h"
 #include "xstring.h"
+#include "xstrbuf.h"
 #include "xmem.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 
 /* 测试计数 */
@@ -58,8 +61,15 @@ TEST(string_new) {
     assert(str != NULL);
     assert(str->length == 5);
     assert(strcmp(str->chars, "hello") == 0);
+    
+    /* 哈希惰性计算：首次取用时才算 */
+    assert(str->hash == 0);
+    assert(xr_string_get_hash(str) == xr_string_hash("hello", 5));
     assert(str->hash != 0);
     
+    /* 字符内联在头部之后 */
+    assert((char*)str->chars == (char*)str + offsetof(XrString, chars));
+    
     xr_string_free(str);
     xr_string_pool_free();
 }
@@ -97,6 +107,16 @@ TEST(string_hash) {
     /* 哈希值非零 */
     assert(hash1 != 0);
     assert(hash3 != 0);
+    
+    /* 按字处理：各种长度（含8字节块、4字节和单字节尾部）都要区分 */
+    const char *text = "abcdefghijklmnopqrstuvwxyz0123456789";
+    for (size_t len = 1; len <= 36; len++) {
+        uint32_t h = xr_string_hash(text, len);
+        assert(h != 0);
+        assert(h != xr_string_hash(text, len - 1));
+        assert(h != xr_string_hash(text + 1, len));
+    }
+    assert(xr_string_hash("", 0) != 0);
 }
 
 /*
@@ -268,6 +288,90 @@ TEST(string_from_float) {
     xr_string_pool_free();
 }
 
+/*
+** 测试12.1: 数字格式化（写入调用者缓冲区）
+*/
+TEST(format_numbers) {
+    char buf[XR_FLOAT_BUFSIZE];
+    char ref[XR_FLOAT_BUFSIZE];
+    
+    xr_Integer ints[] = {0, 7, -7, 99, 100, -1000, 123456789,
+                         INT64_MAX, INT64_MIN};
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        size_t len = xr_format_int(buf, ints[i]);
+        snprintf(ref, sizeof(ref), "%lld", (long long)ints[i]);
+        assert(strcmp(buf, ref) == 0);
+        assert(len == strlen(ref));
+        assert(xr_format_int_length(ints[i]) == len);
+    }
+    
+    /* 15位以内能精确表示的数：与 "%.15g" 输出一致 */
+    xr_Number floats[] = {0.0, -0.0, 3.0, -3.0, 2.5, 3.14, 1e14, 1e15,
+                          123456789012345.0, 1e-7, -1e300, 0.001, 1e-5,
+                          636.209476309227, 5679.37608407578};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        size_t len = xr_format_float(buf, floats[i]);
+        snprintf(ref, sizeof(ref), "%.15g", floats[i]);
+        assert(strcmp(buf, ref) == 0);
+        assert(len == strlen(ref));
+    }
+}
+
+/*
+** 测试12.1.1: 浮点数最短往返表示
+*/
+TEST(format_float_shortest) {
+    char buf[XR_FLOAT_BUFSIZE];
+    
+    struct { xr_Number n; const char *text; } cases[] = {
+        {0.1 + 0.2, "0.30000000000000004"},
+        {1.0 / 3.0, "0.3333333333333333"},
+        {9007199254740993.0, "9.007199254740992e+15"},
+        {1.7976931348623157e308, "1.7976931348623157e+308"},
+        {5e-324, "5e-324"},
+        {-2.2250738585072014e-308, "-2.2250738585072014e-308"},
+        {123.456, "123.456"},
+        {1.0 / 0.0, "inf"},
+        {-1.0 / 0.0, "-inf"},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t len = xr_format_float(buf, cases[i].n);
+        assert(strcmp(buf, cases[i].text) == 0);
+        assert(len == strlen(cases[i].text));
+    }
+    
+    /* 任意值都能解析回原值 */
+    xr_Number n = 0.7;
+    for (int i = 0; i < 1000; i++) {
+        n = n * 1.37 + 0.011;
+        if (n > 1e200) n /= 1e190;
+        xr_format_float(buf, n);
+        assert(strtod(buf, NULL) == n);
+    }
+}
+
+/*
+** 测试12.2: 接管缓冲区驻留
+*/
+TEST(string_intern_take) {
+    xr_string_pool_init();
+    
+    char *buf1 = xr_string_buffer_new(5);
+    memcpy(buf1, "hello", 5);
+    XrString *str1 = xr_string_intern_take(buf1, 5);
+    assert(str1->chars == buf1);
+    assert(strcmp(str1->chars, "hello") == 0);
+    assert(str1 == xr_string_intern("hello", 5, 0));
+    
+    /* 已存在：返回已有字符串 */
+    char *buf2 = xr_string_buffer_new(5);
+    memcpy(buf2, "hello", 5);
+    XrString *str2 = xr_string_intern_take(buf2, 5);
+    assert(str2 == str1);
+    
+    xr_string_pool_free();
+}
+
 /*
 ** 测试13: 空字符串驻留
 */
@@ -702,6 +806,28 @@ TEST(case_conversion) {
     xr_string_pool_free();
 }
 
+/* 大小写转换：整块处理、保留UTF-8、无变化时返回原字符串 */
+TEST(case_conversion_bulk) {
+    xr_string_pool_init();
+    
+    /* 跨越16/8字节块，夹带UTF-8和边界字符 @[`{ */
+    const char *src = "Key_@[`{ AZaz \xC3\x89t\xC3\xA9 MIXED case 0123456789";
+    const char *low = "key_@[`{ azaz \xC3\x89t\xC3\xA9 mixed case 0123456789";
+    const char *up  = "KEY_@[`{ AZAZ \xC3\x89T\xC3\xA9 MIXED CASE 0123456789";
+    XrString *str = xr_string_intern(src, strlen(src), 0);
+    
+    assert(strcmp(xr_string_to_lower_case(str)->chars, low) == 0);
+    assert(strcmp(xr_string_to_upper_case(str)->chars, up) == 0);
+    
+    XrString *lower = xr_string_intern(low, strlen(low), 0);
+    assert(xr_string_to_lower_case(lower) == lower);
+    
+    XrString *digits = xr_string_intern("0123456789", 10, 0);
+    assert(xr_string_to_upper_case(digits) == digits);
+    
+    xr_string_pool_free();
+}
+
 /* ========== Day 4: 转义序列测试（10个）========== */
 
 /* 测试41: 换行符转义 */
@@ -850,6 +976,479 @@ TEST(template_ast_create) {
     xr_string_pool_free();
 }
 
+/* ========== 字符串构建器测试 ========== */
+
+/*
+** 构建器：追加与2倍扩容
+*/
+TEST(strbuf_append) {
+    xr_string_pool_init();
+    
+    XrStringBuilder sb;
+    xr_strbuf_init(&sb);
+    assert(sb.data == NULL && sb.length == 0);
+    
+    xr_strbuf_append(&sb, "abc", 3);
+    assert(sb.capacity == XR_STRBUF_MIN_CAPACITY);
+    assert(strcmp(sb.data, "abc") == 0);
+    
+    /* 逐字节追加，容量只按2倍增长 */
+    size_t grows = 0;
+    size_t last_capacity = sb.capacity;
+    for (int i = 0; i < 1000; i++) {
+        xr_strbuf_append(&sb, "x", 1);
+        if (sb.capacity != last_capacity) {
+            assert(sb.capacity == last_capacity * 2);
+            last_capacity = sb.capacity;
+            grows++;
+        }
+    }
+    assert(sb.length == 1003);
+    assert(grows == 5);  /* 32 -> 1024 */
+    assert(sb.data[sb.length] == '\0');
+    
+    xr_strbuf_reset(&sb);
+    assert(sb.length == 0 && sb.data[0] == '\0');
+    assert(sb.capacity == last_capacity);
+    
+    xr_strbuf_free(&sb);
+    assert(sb.data == NULL);
+    xr_string_pool_free();
+}
+
+/*
+** 构建器：数字与任意值追加
+*/
+TEST(strbuf_append_value) {
+    xr_string_pool_init();
+    
+    XrStringBuilder sb;
+    xr_strbuf_init(&sb);
+    
+    xr_strbuf_append_int(&sb, -42);
+    xr_strbuf_append(&sb, ",", 1);
+    xr_strbuf_append_float(&sb, 2.5);
+    xr_strbuf_append(&sb, ",", 1);
+    xr_strbuf_append_value(&sb, xr_string_value(xr_string_intern("hi", 2, 0)));
+    xr_strbuf_append_value(&sb, xr_int(7));
+    xr_strbuf_append_value(&sb, xr_bool(1));
+    xr_strbuf_append_value(&sb, xr_null());
+    assert(strcmp(sb.data, "-42,2.5,hi7truenull") == 0);
+    
+    xr_strbuf_free(&sb);
+    xr_string_pool_free();
+}
+
+/*
+** 构建器：toString复制并驻留，takeString交出缓冲区
+*/
+TEST(strbuf_to_string) {
+    xr_string_pool_init();
+    
+    XrStringBuilder sb;
+    xr_strbuf_init(&sb);
+    
+    /* 空构建器得到空串 */
+    assert(xr_strbuf_to_string(&sb) == xr_string_intern("", 0, 0));
+    
+    xr_strbuf_append(&sb, "hello", 5);
+    XrString *s1 = xr_strbuf_to_string(&sb);
+    assert(s1 == xr_string_intern("hello", 5, 0));
+    assert(s1->chars != sb.data);
+    
+    /* toString后可继续追加 */
+    xr_strbuf_append(&sb, " world", 6);
+    XrString *s2 = xr_strbuf_take_string(&sb);
+    assert(strcmp(s2->chars, "hello world") == 0);
+    assert(s2 == xr_string_intern("hello world", 11, 0));
+    assert(sb.data == NULL && sb.length == 0 && sb.capacity == 0);
+    
+    /* 已驻留的内容：缓冲区被释放，返回已有字符串 */
+    xr_strbuf_append(&sb, "hello", 5);
+    assert(xr_strbuf_take_string(&sb) == s1);
+    
+    xr_string_pool_free();
+}
+
+/*
+** 多值拼接（模板字符串）
+*/
+TEST(strbuf_concat) {
+    xr_string_pool_init();
+    
+    XrValue parts[5] = {
+        xr_string_value(xr_string_intern("id=", 3, 0)),
+        xr_int(12345),
+        xr_string_value(xr_string_intern(", ratio=", 8, 0)),
+        xr_float(0.25),
+        xr_null(),
+    };
+    XrString *str = xr_strbuf_concat(parts, 5);
+    assert(strcmp(str->chars, "id=12345, ratio=0.25null") == 0);
+    assert(str == xr_string_intern("id=12345, ratio=0.25null", 24, 0));
+    
+    /* 单个数字片段：转为字符串 */
+    XrValue num = xr_int(-7);
+    assert(strcmp(xr_strbuf_concat(&num, 1)->chars, "-7") == 0);
+    
+    /* 空 */
+    assert(xr_strbuf_concat(NULL, 0) == xr_string_intern("", 0, 0));
+    
+    xr_string_pool_free();
+}
+
+/* ========== 字符串池：长度阈值与清扫 ========== */
+
+/*
+** 短字符串驻留，长字符串不驻留但登记在池中
+*/
+TEST(string_make_threshold) {
+    xr_string_pool_init();
+    
+    char text[XR_STRING_SHORT_MAX + 2];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    
+    XrString *s1 = xr_string_make(text, XR_STRING_SHORT_MAX);
+    XrString *s2 = xr_string_make(text, XR_STRING_SHORT_MAX);
+    assert(s1 == s2);
+    
+    XrString *l1 = xr_string_make(text, XR_STRING_SHORT_MAX + 1);
+    XrString *l2 = xr_string_make(text, XR_STRING_SHORT_MAX + 1);
+    assert(l1 != l2);
+    assert(xr_string_equal(l1, l2));
+    assert(xr_string_pool_current()->long_count == 2);
+    
+    /* 显式驻留不受阈值限制 */
+    XrString *i1 = xr_string_intern(text, XR_STRING_SHORT_MAX + 1, 0);
+    assert(i1 == xr_string_intern(text, XR_STRING_SHORT_MAX + 1, 0));
+    
+    size_t count;
+    xr_string_pool_stats(&count, NULL, NULL);
+    assert(count == 2);
+    
+    /* 长拼接结果不进驻留表 */
+    XrString *cat = xr_string_concat(l1, s1);
+    assert(cat->length == 2 * XR_STRING_SHORT_MAX + 1);
+    assert(xr_string_pool_current()->long_count == 3);
+    
+    xr_string_pool_free();
+}
+
+static bool alive_if_marked(XrString *str, void *ud) {
+    (void)ud;
+    return str->header.marked;
+}
+
+/*
+** 清扫回收不可达字符串，存活的仍可查到
+*/
+TEST(string_pool_sweep) {
+    xr_string_pool_init();
+    
+    char key[16];
+    XrString *keep[67];
+    for (int i = 0; i < 200; i++) {
+        int len = snprintf(key, sizeof(key), "key%d", i);
+        XrString *str = xr_string_intern(key, len, 0);
+        if (i % 3 == 0) {
+            str->header.marked = true;
+            keep[i / 3] = str;
+        }
+    }
+    
+    char text[64];
+    memset(text, 'y', sizeof(text));
+    XrString *long_alive = xr_string_make(text, sizeof(text));
+    long_alive->header.marked = true;
+    xr_string_make(text, sizeof(text));
+    
+    /* 就地删除，不重新分配表 */
+    XrString **entries = xr_string_pool_current()->entries;
+    size_t capacity = xr_string_pool_current()->capacity;
+    size_t freed = xr_string_pool_sweep(alive_if_marked, NULL);
+    assert(freed == 133 + 1);
+    assert(xr_string_pool_current()->entries == entries);
+    assert(xr_string_pool_current()->capacity == capacity);
+    
+    size_t count;
+    xr_string_pool_stats(&count, NULL, NULL);
+    assert(count == 67);
+    assert(xr_string_pool_current()->long_count == 1);
+    assert(xr_string_pool_current()->long_strings == long_alive);
+    
+    /* 清扫后探测链仍完整 */
+    for (int i = 0; i < 200; i += 3) {
+        int len = snprintf(key, sizeof(key), "key%d", i);
+        assert(xr_string_intern(key, len, 0) == keep[i / 3]);
+    }
+    xr_string_pool_stats(&count, NULL, NULL);
+    assert(count == 67);
+    
+    xr_string_pool_free();
+}
+
+/*
+** 反复驻留和清扫：后移删除跨过表尾绕回时，存活的字符串仍可查到
+*/
+TEST(string_pool_sweep_churn) {
+    xr_string_pool_init();
+    
+    char key[32];
+    size_t alive = 0;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 300; i++) {
+            int len = snprintf(key, sizeof(key), "r%d_%d", round, i);
+            XrString *str = xr_string_intern(key, len, 0);
+            str->header.marked = (i * 7 + round) % 5 == 0;
+            alive += str->header.marked;
+        }
+        xr_string_pool_sweep(alive_if_marked, NULL);
+        
+        size_t count;
+        xr_string_pool_stats(&count, NULL, NULL);
+        assert(count == alive);
+        for (int r = 0; r <= round; r++) {
+            for (int i = 0; i < 300; i++) {
+                if ((i * 7 + r) % 5 != 0) continue;
+                int len = snprintf(key, sizeof(key), "r%d_%d", r, i);
+                XrString *str = xr_string_intern(key, len, 0);
+                assert(str->header.marked);
+            }
+        }
+        xr_string_pool_stats(&count, NULL, NULL);
+        assert(count == alive);
+    }
+    
+    xr_string_pool_free();
+}
+
+/*
+** 切换字符串池（VM持有自己的池）
+*/
+TEST(string_pool_use) {
+    xr_string_pool_init();
+    XrString *outer = xr_string_intern("shared", 6, 0);
+    
+    StringPool pool;
+    memset(&pool, 0, sizeof(pool));
+    xr_string_pool_use(&pool);
+    assert(xr_string_pool_current() == &pool);
+    
+    XrString *inner = xr_string_intern("shared", 6, 0);
+    assert(inner != outer);
+    assert(pool.count == 1);
+    xr_string_pool_free();
+    
+    xr_string_pool_use(NULL);
+    assert(xr_string_pool_current() != &pool);
+    assert(xr_string_intern("shared", 6, 0) == outer);
+    
+    xr_string_pool_free();
+}
+
+/* ========== 字符串切片 ========== */
+
+/*
+** 切片去空白与生成字符串
+*/
+TEST(slice_trim) {
+    xr_string_pool_init();
+    
+    XrString *str = xr_string_intern("  key = value \t", 15, 0);
+    XrStringSlice slice = xr_string_slice_trim(xr_string_slice(str, 0, str->length));
+    assert(slice.parent == str);
+    assert(slice.offset == 2);
+    assert(slice.length == 11);
+    
+    XrString *key = xr_string_intern("key = value", 11, 0);
+    assert(xr_string_slice_equals(slice, key));
+    assert(xr_string_slice_materialize(slice) == key);
+    
+    /* 无需裁剪/覆盖整串：返回原字符串 */
+    assert(xr_string_trim(key) == key);
+    assert(xr_string_substring(key, 0, -1) == key);
+    
+    /* 全是空白 */
+    XrString *blank = xr_string_intern(" \n ", 3, 0);
+    assert(xr_string_trim(blank)->length == 0);
+    
+    xr_string_pool_free();
+}
+
+/*
+** 按切片切分字段
+*/
+TEST(slice_split) {
+    xr_string_pool_init();
+    
+    XrString *line = xr_string_intern("a,,bc,", 6, 0);
+    XrString *comma = xr_string_intern(",", 1, 0);
+    const char *expect[] = {"a", "", "bc", ""};
+    
+    XrStringSlice rest = xr_string_slice(line, 0, line->length);
+    XrStringSlice field;
+    int n = 0;
+    while (xr_string_slice_split_next(&rest, comma, &field)) {
+        assert(field.parent == line);
+        assert(field.length == strlen(expect[n]));
+        assert(memcmp(xr_string_slice_chars(field), expect[n], field.length) == 0);
+        n++;
+    }
+    assert(n == 4);
+    
+    /* 多字节分隔符，首字节在字段中出现 */
+    XrString *text = xr_string_intern("x:y::z:::", 9, 0);
+    XrString *sep = xr_string_intern("::", 2, 0);
+    struct XrArray *parts = xr_string_split(text, sep);
+    assert(xr_array_length(parts) == 3);
+    assert(strcmp(xr_tostring(xr_array_get(parts, 0))->chars, "x:y") == 0);
+    assert(strcmp(xr_tostring(xr_array_get(parts, 1))->chars, "z") == 0);
+    assert(strcmp(xr_tostring(xr_array_get(parts, 2))->chars, ":") == 0);
+    
+    /* 没有分隔符：唯一的字段就是原字符串 */
+    struct XrArray *whole = xr_string_split(sep, comma);
+    assert(xr_array_length(whole) == 1);
+    assert(xr_tostring(xr_array_get(whole, 0)) == sep);
+    
+    xr_array_free(parts);
+    xr_array_free(whole);
+    xr_string_pool_free();
+}
+
+/*
+** 切片字符串：长子串引用父串，读取、比较、查找都按字节范围进行
+*/
+TEST(slice_string) {
+    xr_string_pool_init();
+    
+    char text[101];
+    for (int i = 0; i < 100; i++) {
+        text[i] = (char)('a' + i % 26);
+    }
+    text[100] = '\0';
+    XrString *parent = xr_string_make(text, 100);
+    
+    XrString *sub = xr_string_substring(parent, 10, 90);
+    assert(xr_string_is_slice(sub));
+    assert(xr_string_ref(sub)->parent == parent);
+    assert(sub->length == 80);
+    assert(memcmp(xr_string_data(sub), text + 10, 80) == 0);
+    
+    /* 与内容相同的内联字符串相等、哈希相同 */
+    XrString *copy = xr_string_make(text + 10, 80);
+    assert(xr_string_equal(sub, copy));
+    assert(xr_string_compare(sub, copy) == 0);
+    assert(xr_string_get_hash(sub) == xr_string_get_hash(copy));
+    assert(xr_string_index_of(sub, xr_string_intern("uvw", 3, 0)) == 10);
+    assert(xr_string_starts_with(sub, xr_string_intern("klm", 3, 0)));
+    
+    /* 切片的切片引用最初的父串 */
+    XrString *inner = xr_string_substring(sub, 5, 75);
+    assert(xr_string_is_slice(inner));
+    assert(xr_string_ref(inner)->parent == parent);
+    assert(xr_string_ref(inner)->offset == 15);
+    
+    /* 内联副本以\0结尾；内联字符串原样返回 */
+    XrString *flat = xr_string_flatten(sub);
+    assert(!xr_string_is_slice(flat));
+    assert(flat->length == 80 && flat->chars[80] == '\0');
+    assert(memcmp(flat->chars, text + 10, 80) == 0);
+    assert(xr_string_flatten(parent) == parent);
+    
+    /* 短子串和只占父串一小部分的子串复制 */
+    assert(!xr_string_is_slice(xr_string_substring(parent, 0, XR_STRING_SHORT_MAX)));
+    XrString *wide = xr_string_concat(parent, xr_string_concat(parent, parent));
+    assert(!xr_string_is_slice(xr_string_substring(wide, 0, 60)));
+    assert(xr_string_is_slice(xr_string_substring(wide, 0, 75)));
+    
+    /* 拼接读取切片的字节 */
+    XrString *cat = xr_string_concat(sub, xr_string_intern("!", 1, 0));
+    assert(cat->length == 81 && cat->chars[80] == '!');
+    assert(memcmp(cat->chars, text + 10, 80) == 0);
+    
+    xr_string_pool_free();
+}
+
+/* ========== 子串查找 ========== */
+
+/*
+** 短模式串：跨越16字节分组边界、只有首尾字节相同的干扰项
+*/
+TEST(search_short_needle) {
+    char hay[80];
+    memset(hay, '.', sizeof(hay));
+    memcpy(hay + 10, "axxz", 4);   /* 首尾字节命中但中间不同 */
+    memcpy(hay + 30, "ayyz", 4);
+    memcpy(hay + 62, "ayyz", 4);
+    
+    assert(xr_string_search(hay, sizeof(hay), "ayyz", 4) == hay + 30);
+    assert(xr_string_search(hay + 31, sizeof(hay) - 31, "ayyz", 4) == hay + 62);
+    assert(xr_string_search(hay, sizeof(hay), "ayyq", 4) == NULL);
+    
+    /* 恰好在末尾 */
+    memcpy(hay + sizeof(hay) - 3, "end", 3);
+    assert(xr_string_search(hay, sizeof(hay), "end", 3) == hay + sizeof(hay) - 3);
+    
+    assert(xr_string_search(hay, sizeof(hay), "", 0) == hay);
+    assert(xr_string_search(hay, 2, "abc", 3) == NULL);
+}
+
+/*
+** 长模式串（Two-Way），包括周期模式串
+*/
+TEST(search_long_needle) {
+    char hay[512];
+    char needle[64];
+    
+    /* 周期模式串：63个a加一个b，文本大部分是a */
+    memset(hay, 'a', sizeof(hay));
+    memset(needle, 'a', sizeof(needle));
+    needle[63] = 'b';
+    assert(xr_string_search(hay, sizeof(hay), needle, 64) == NULL);
+    hay[400] = 'b';
+    assert(xr_string_search(hay, sizeof(hay), needle, 64) == hay + 337);
+    
+    /* 非周期模式串 */
+    for (int i = 0; i < 64; i++) {
+        needle[i] = (char)('A' + (i * 7) % 26);
+    }
+    memset(hay, 'A', sizeof(hay));
+    memcpy(hay + 200, needle, 63);       /* 只差最后一个字节 */
+    memcpy(hay + 448, needle, 64);
+    assert(xr_string_search(hay, sizeof(hay), needle, 64) == hay + 448);
+}
+
+/*
+** replaceAll：单遍，替换内容里的模式串不会再次匹配
+*/
+TEST(replace_all_single_pass) {
+    xr_string_pool_init();
+    
+    XrString *str = xr_string_intern("a-b-c", 5, 0);
+    XrString *dash = xr_string_intern("-", 1, 0);
+    XrString *arrow = xr_string_intern("->-", 3, 0);
+    XrString *result = xr_string_replace_all(str, dash, arrow);
+    assert(strcmp(result->chars, "a->-b->-c") == 0);
+    
+    /* 替换后拼出的新匹配不再处理 */
+    XrString *aabb = xr_string_intern("aabb", 4, 0);
+    XrString *ab = xr_string_intern("ab", 2, 0);
+    XrString *empty = xr_string_intern("", 0, 0);
+    assert(strcmp(xr_string_replace_all(aabb, ab, empty)->chars, "ab") == 0);
+    
+    /* 不重叠匹配 */
+    XrString *aaa = xr_string_intern("aaa", 3, 0);
+    XrString *aa = xr_string_intern("aa", 2, 0);
+    XrString *b = xr_string_intern("b", 1, 0);
+    assert(strcmp(xr_string_replace_all(aaa, aa, b)->chars, "ba") == 0);
+    
+    /* 没有匹配：返回原字符串 */
+    assert(xr_string_replace_all(aaa, dash, b) == aaa);
+    
+    xr_string_pool_free();
+}
+
 /* ========== 主测试函数 ========== */
 
 int main() {
@@ -874,6 +1473,9 @@ int main() {
     RUN_TEST(string_concat);
     RUN_TEST(string_from_int);
     RUN_TEST(string_from_float);
+    RUN_TEST(format_numbers);
+    RUN_TEST(format_float_shortest);
+    RUN_TEST(string_intern_take);
     RUN_TEST(string_empty);
     RUN_TEST(string_pool_grow);
     RUN_TEST(string_pool_stats);
@@ -915,6 +1517,7 @@ int main() {
     RUN_TEST(trim_trailing);
     RUN_TEST(trim_all_whitespace);
     RUN_TEST(case_conversion);
+    RUN_TEST(case_conversion_bulk);
     
     /* Day 4: 转义序列测试（10个）*/
     printf("\n--- Day 4: 转义序列 ---\n");
@@ -934,6 +1537,32 @@ int main() {
     RUN_TEST(template_ast_create);
     printf("  注意：模板字符串主要通过示例程序测试\n");
     
+    /* 字符串构建器测试（4个）*/
+    printf("\n--- 字符串构建器 ---\n");
+    RUN_TEST(strbuf_append);
+    RUN_TEST(strbuf_append_value);
+    RUN_TEST(strbuf_to_string);
+    RUN_TEST(strbuf_concat);
+    
+    /* 字符串池测试（3个）*/
+    printf("\n--- 字符串池 ---\n");
+    RUN_TEST(string_make_threshold);
+    RUN_TEST(string_pool_sweep);
+    RUN_TEST(string_pool_sweep_churn);
+    RUN_TEST(string_pool_use);
+    
+    /* 字符串切片测试（3个）*/
+    printf("\n--- 字符串切片 ---\n");
+    RUN_TEST(slice_trim);
+    RUN_TEST(slice_split);
+    RUN_TEST(slice_string);
+    
+    /* 子串查找测试（3个）*/
+    printf("\n--- 子串查找 ---\n");
+    RUN_TEST(search_short_needle);
+    RUN_TEST(search_long_needle);
+    RUN_TEST(replace_all_single_pass);
+    
     /* 输出测试结果 */
     printf("\n========================================\n");
     printf("测试结果: %d/%d 通过\n", tests_passed, tests_run);
@@ -0,0 +1,106 @@
+/*
+** test_template_bc.c
+** 测试模板字符串编译为连续寄存器 + 一条CONCAT
+*/
+
+#include "xtest_vm.h"
+#include "xchunk.h"
+#include "xstring.h"
+
+/*
+** 片段混合局部变量、临时值、整数、浮点数和嵌套调用
+** show里三个模板是同一次调用的三个参数
+*/
+static const char *template_source =
+    "function twice(x) {\n"
+    "    return x * 2\n"
+    "}\n"
+    "function join3(a, b, c) {\n"
+    "    return `${a},${b},${c}`\n"
+    "}\n"
+    "function show(a, b) {\n"
+    "    let t = a * 1.5\n"
+    "    let s = join3(`${a}`, `<${a * 2 + b * 2}|${t}>`, `${b}/${twice(b)}/${join3(twice(b), t * 2.5, a)}`)\n"
+    "    return s\n"
+    "}\n"
+    "print(show(3, 4))\n"
+    "print(`${1}+${2.5}` + \" \" + `[${show(1, 2)}]`)\n"
+    "for (let i = 0; i < 3; i = i + 1) {\n"
+    "    print(`${i}:${i + 0.5}`)\n"
+    "}\n"
+    "print(``)\n";
+
+static const char *template_expected =
+    "3,<14|4.5>,4/8/8,11.25,3\n"
+    "1+2.5 [1,<6|1.5>,2/4/4,3.75,1]\n"
+    "0:0.5\n"
+    "1:1.5\n"
+    "2:2.5\n"
+    "\n";
+
+/* 按函数名查找嵌套原型 */
+static Proto *find_proto(Proto *proto, const char *name) {
+    for (int i = 0; i < proto->sizeprotos; i++) {
+        Proto *child = proto->protos[i];
+        if (child->name != NULL && strcmp(child->name->chars, name) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+/*
+** show里外层join3的三个参数都是模板：
+** 每个模板只占一个寄存器，三条CONCAT依次落在参数寄存器上，无需MOVE
+*/
+static int check_no_leak(VM *vm, Proto *proto, void *ud) {
+    (void)vm;
+    (void)ud;
+    Proto *show = find_proto(proto, "show");
+    if (show == NULL) {
+        printf("✗ 找不到函数show\n");
+        return 1;
+    }
+    
+    int concat_base[4];
+    int concats = 0;
+    int call_base = -1;
+    for (int i = 0; i < show->sizecode; i++) {
+        Instruction inst = show->code[i];
+        if (GET_OPCODE(inst) == OP_CONCAT) {
+            if (concats < 4) {
+                concat_base[concats] = GETARG_B(inst);
+            }
+            concats++;
+        } else if (GET_OPCODE(inst) == OP_CALL && GETARG_B(inst) == 3) {
+            call_base = GETARG_A(inst);  /* 最后一个三参数调用是外层join3 */
+        }
+    }
+    
+    if (concats != 3 || call_base < 0) {
+        printf("✗ show有%d条CONCAT，应为3条\n", concats);
+        return 1;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (concat_base[i] != call_base + 1 + i) {
+            printf("✗ 第%d个模板在R[%d]，应在R[%d]（寄存器泄漏）\n",
+                   i + 1, concat_base[i], call_base + 1 + i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    printf("=== Template String Test ===\n\n");
+    
+    XrayState *X = xr_state_new();
+    int failed = xtest_run_script(X, "模板字符串", template_source, template_expected,
+                                  INTERPRET_OK, check_no_leak, NULL);
+    xr_state_free(X);
+    
+    if (failed == 0) {
+        printf("\n✓ 模板字符串测试通过\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
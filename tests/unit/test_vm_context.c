@@ -4,6 +4,7 @@
 */
 
 #include "xvm_context.h"
+#include "xstring.h"
 #include <stdio.h>
 #include <assert.h>
 
@@ -87,6 +88,11 @@ int main(void) {
     assert(ctx->vm->stack_top == ctx->vm->stack);
     assert(ctx->vm->frame_count == 0);
     assert(ctx->vm->global_count == 0);
+    assert(xr_isnull(ctx->vm->globals_array[5]));
+    assert(ctx->vm->builder_count == 0);
+    assert(ctx->vm->gc_phase == GC_PAUSE);
+    assert(ctx->vm->remembered_count == 0);
+    assert(!ctx->vm->region.active);
     assert(ctx->total_instructions == 0);
     assert(ctx->total_calls == 0);
     printf("✓ 上下文重置成功\n\n");
@@ -136,9 +142,18 @@ int main(void) {
     assert(ctx->vm->trace_execution == true);
     printf("✓ 执行跟踪启用/禁用成功\n\n");
     
-    /* 清理 */
+    /* 测试9: 释放后当前字符串池不再指向已释放的VM */
+    printf("测试9: 释放上下文\n");
+    StringPool *pool1 = &ctx->vm->strings;
+    StringPool *pool2 = &ctx2->vm->strings;
+    XrSlab *slab1 = &ctx->vm->slab;
+    XrSlab *slab2 = &ctx2->vm->slab;
     xr_vm_context_free(ctx);
     xr_vm_context_free(ctx2);
+    assert(xr_string_pool_current() != pool1);
+    assert(xr_string_pool_current() != pool2);
+    assert(xr_slab_current() != slab1 && xr_slab_current() != slab2);
+    printf("✓ 当前字符串池和slab已恢复\n\n");
     
     printf("=== 所有测试通过！ ===\n");
     printf("\n📌 VM上下文的优势:\n");